@@ -358,12 +358,6 @@ if(NOT WINDOWS)
 endif()
 include (FindThreads)
 include (GlibcDetect)
-if (WINDOWS)
-	message(STATUS "OpenMP support will be disabled on Windows until we have a chance to fix the installer to support it")
-	# TJ: 8.5.8 disabling OpenMP on Windows because it adds a dependency on an additional merge module for VCOMP110.DLL
-else()
-	find_package ("OpenMP")
-endif()
 
 if (FIPS_BUILD)
     add_definitions(-DFIPS_MODE=1)
@@ -1177,12 +1171,6 @@ if (CONDOR_CXX_FLAGS)
 	set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${CONDOR_CXX_FLAGS}")
 endif()
 
-if (OPENMP_FOUND)
-	set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} ${OpenMP_C_FLAGS}")
-	set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
-	set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} ${OpenMP_EXE_LINKER_FLAGS}")
-endif()
-
 if(MSVC)
 	#disable autolink settings 
 	add_definitions(-DBOOST_ALL_NO_LIB)
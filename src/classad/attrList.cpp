@@ -0,0 +1,286 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/classad_containers.h"
+#include "classad/attrList.h"
+#include <mutex>
+
+using namespace std;
+
+namespace classad {
+
+typedef classad_unordered<string, AttrName*> SpellingTable;
+typedef classad_unordered<string, const AttrName*, ClassadAttrNameHash, CaseIgnEqStr> AtomTable;
+
+const AttrName *
+InternAttrName( const string &name )
+{
+		// allocated rather than static so that ads destroyed at exit can
+		// still use their names
+	static mutex *lock = new mutex;
+	static SpellingTable *spellings = new SpellingTable;
+	static AtomTable *atoms = new AtomTable;
+
+	lock_guard<mutex> guard( *lock );
+	SpellingTable::iterator itr = spellings->find( name );
+	if( itr != spellings->end( ) ) {
+		return itr->second;
+	}
+
+	AttrName *spelling = new AttrName;
+	spelling->name = name;
+	spelling->hash = ClassadAttrNameHash()( name );
+	AtomTable::iterator atom = atoms->find( name );
+	if( atom != atoms->end( ) ) {
+		spelling->atom = atom->second;
+	} else {
+		spelling->atom = spelling;
+		atoms->emplace( name, spelling );
+	}
+	spellings->emplace( name, spelling );
+	return spelling;
+}
+
+void AttrList::
+clear( )
+{
+	items.clear( );
+	index.clear( );
+	shift = 0;
+}
+
+void AttrList::
+reserve( size_t count )
+{
+	items.reserve( count );
+	if( count > SMALL_SIZE && index.size( ) * 3 < count * 4 ) {
+		buildIndex( count );
+	}
+}
+
+size_t AttrList::
+home( size_t hash ) const
+{
+		// the name hash is weak in its low bits, so take the slot from
+		// the high bits of a multiplicative hash of it
+	return (size_t)( (unsigned int)hash * 2654435769U ) >> shift;
+}
+
+int AttrList::
+lookup( const string &name ) const
+{
+	size_t hash = ClassadAttrNameHash()( name );
+	if( index.empty( ) ) {
+		for( size_t ii = 0; ii < items.size( ); ii++ ) {
+			const AttrName *attr = items[ii].name;
+			if( attr->hash == hash &&
+				strcasecmp( attr->name.c_str( ), name.c_str( ) ) == 0 ) {
+				return (int)ii;
+			}
+		}
+		return -1;
+	}
+
+	size_t mask = index.size( ) - 1;
+	for( size_t pos = home( hash ); index[pos]; pos = ( pos + 1 ) & mask ) {
+		const AttrName *attr = items[index[pos]-1].name;
+		if( attr->hash == hash &&
+			strcasecmp( attr->name.c_str( ), name.c_str( ) ) == 0 ) {
+			return (int)index[pos] - 1;
+		}
+	}
+	return -1;
+}
+
+int AttrList::
+lookup( const AttrName *name ) const
+{
+	const AttrName *atom = name->atom;
+	if( index.empty( ) ) {
+		for( size_t ii = 0; ii < items.size( ); ii++ ) {
+			if( items[ii].name->atom == atom ) {
+				return (int)ii;
+			}
+		}
+		return -1;
+	}
+
+	size_t mask = index.size( ) - 1;
+	for( size_t pos = home( atom->hash ); index[pos]; pos = ( pos + 1 ) & mask ) {
+		if( items[index[pos]-1].name->atom == atom ) {
+			return (int)index[pos] - 1;
+		}
+	}
+	return -1;
+}
+
+AttrList::iterator AttrList::
+find( const string &name )
+{
+	int ii = lookup( name );
+	return ii < 0 ? end( ) : iterator( entry( ii ) );
+}
+
+AttrList::const_iterator AttrList::
+find( const string &name ) const
+{
+	int ii = lookup( name );
+	return ii < 0 ? end( ) : const_iterator( entry( ii ) );
+}
+
+AttrList::const_iterator AttrList::
+find( const AttrName *name ) const
+{
+	int ii = lookup( name );
+	return ii < 0 ? end( ) : const_iterator( entry( ii ) );
+}
+
+pair<AttrList::iterator,bool> AttrList::
+emplace( const string &name, ExprTree *tree )
+{
+	int ii = lookup( name );
+	if( ii >= 0 ) {
+		return pair<iterator,bool>( iterator( entry( ii ) ), false );
+	}
+	append( InternAttrName( name ), tree );
+	return pair<iterator,bool>( iterator( entry( items.size( ) - 1 ) ), true );
+}
+
+ExprTree *&AttrList::
+operator[]( const string &name )
+{
+	int ii = lookup( name );
+	if( ii >= 0 ) {
+		return items[ii].tree;
+	}
+	append( InternAttrName( name ), NULL );
+	return items.back( ).tree;
+}
+
+void AttrList::
+append( const AttrName *name, ExprTree *tree )
+{
+	Attr attr = { name, tree };
+	items.push_back( attr );
+	if( index.empty( ) ) {
+		if( items.size( ) > SMALL_SIZE ) {
+			buildIndex( items.size( ) );
+		}
+	} else if( items.size( ) * 4 > index.size( ) * 3 ) {
+		buildIndex( items.size( ) );
+	} else {
+		indexEntry( items.size( ) - 1 );
+	}
+}
+
+void AttrList::
+buildIndex( size_t count )
+{
+	size_t capacity = 16;
+	int bits = 4;
+	while( capacity < count * 2 ) {
+		capacity *= 2;
+		bits++;
+	}
+	shift = 32 - bits;
+	index.assign( capacity, 0 );
+	for( size_t ii = 0; ii < items.size( ); ii++ ) {
+		indexEntry( ii );
+	}
+}
+
+void AttrList::
+indexEntry( size_t ii )
+{
+	size_t mask = index.size( ) - 1;
+	size_t pos = home( items[ii].name->hash );
+	while( index[pos] ) {
+		pos = ( pos + 1 ) & mask;
+	}
+	index[pos] = (unsigned int)ii + 1;
+}
+
+size_t AttrList::
+findSlot( size_t ii ) const
+{
+	size_t mask = index.size( ) - 1;
+	size_t pos = home( items[ii].name->hash );
+	while( index[pos] != ii + 1 ) {
+		pos = ( pos + 1 ) & mask;
+	}
+	return pos;
+}
+
+void AttrList::
+unindex( size_t ii )
+{
+		// empty the slot, then move back any of the slots after it that
+		// could no longer be reached from their home
+	size_t mask = index.size( ) - 1;
+	size_t hole = findSlot( ii );
+	for( size_t pos = ( hole + 1 ) & mask; index[pos]; pos = ( pos + 1 ) & mask ) {
+		size_t want = home( items[index[pos]-1].name->hash );
+		bool reachable = ( hole <= pos ) ? ( want > hole && want <= pos )
+		                                 : ( want > hole || want <= pos );
+		if( !reachable ) {
+			index[hole] = index[pos];
+			hole = pos;
+		}
+	}
+	index[hole] = 0;
+}
+
+AttrList::iterator AttrList::
+erase( const_iterator itr )
+{
+	size_t ii = itr.entry - entry( 0 );
+	size_t last = items.size( ) - 1;
+	if( !index.empty( ) ) {
+		unindex( ii );
+		if( ii != last ) {
+			index[findSlot( last )] = (unsigned int)ii + 1;
+		}
+	}
+	items[ii] = items[last];
+	items.pop_back( );
+	return iterator( entry( ii ) );
+}
+
+size_t AttrList::
+erase( const string &name )
+{
+	int ii = lookup( name );
+	if( ii < 0 ) {
+		return 0;
+	}
+	erase( const_iterator( entry( ii ) ) );
+	return 1;
+}
+
+void AttrList::
+swap( AttrList &other )
+{
+	items.swap( other.items );
+	index.swap( other.index );
+	std::swap( shift, other.shift );
+}
+
+} // classad
@@ -20,6 +20,7 @@
 
 #include "classad/common.h"
 #include "classad/classad.h"
+#include "classad/evalProfile.h"
 
 using namespace std;
 
@@ -31,6 +32,7 @@ AttributeReference()
 	parentScope = NULL;
 	expr = NULL;
 	absolute = false;
+	attrAtom = NULL;
 }
 
 
@@ -40,6 +42,7 @@ AttributeReference( ExprTree *tree, const string &attrname, bool absolut )
 {
 	parentScope = NULL;
 	attributeStr = attrname;
+	attrAtom = InternAttrName( attributeStr );
 	expr = tree;
 	absolute = absolut;
 }
@@ -94,6 +97,7 @@ CopyFrom(const AttributeReference &ref)
 
 	parentScope = ref.parentScope;
 	attributeStr = ref.attributeStr;
+	attrAtom = ref.attrAtom;
 	if( ref.expr && ( expr=ref.expr->Copy( ) ) == NULL ) {
         success = false;
 	} else {
@@ -110,6 +114,7 @@ bool AttributeReference::SetComponents( ExprTree *tree, const std::string &attr,
 		expr = tree;
 	}
 	attributeStr = attr;
+	attrAtom = InternAttrName( attributeStr );
 	absolute = abs;
 	return true;
 }
@@ -201,7 +206,16 @@ _Evaluate (EvalState &state, Value &val) const
 			}
 			state.depth_remaining--;
 
-			rval = tree->Evaluate( state, val );
+				// nested ads are only a step on the way to an
+				// attribute, so they aren't counted themselves
+			if( EvalProfile::Enabled( ) && tree->self( )->GetKind( ) != CLASSAD_NODE ) {
+				const ClassAd *foundAd = state.curAd;
+				EvalProfile::Timer timer;
+				rval = tree->Evaluate( state, val );
+				EvalProfile::CountAttribute( attributeStr, foundAd, timer.Seconds( ) );
+			} else {
+				rval = tree->Evaluate( state, val );
+			}
 
 			state.depth_remaining++;
 
@@ -459,9 +473,9 @@ FindExpr(EvalState &state, ExprTree *&tree, ExprTree *&sig, bool wantSig) const
 		 * Expect alternateScope to be removed from a future release.
 		 */
 	if (!current) { return EVAL_UNDEF; }
-	int rc = current->LookupInScope( attributeStr, tree, state );
+	int rc = current->LookupInScope( attributeStr, tree, state, attrAtom );
 	if ( !expr && !absolute && rc == EVAL_UNDEF && current->alternateScope ) {
-		rc = current->alternateScope->LookupInScope( attributeStr, tree, state );
+		rc = current->alternateScope->LookupInScope( attributeStr, tree, state, attrAtom );
 	}
 	return rc;
 }
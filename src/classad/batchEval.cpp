@@ -0,0 +1,234 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/classad.h"
+#include "classad/literals.h"
+#include "classad/attrrefs.h"
+#include "classad/batchEval.h"
+
+using namespace std;
+
+namespace classad {
+
+	// names that ClassAd::LookupInScope() treats specially when they are
+	// not attributes of the ad, under either the old or new semantics
+static const char * const specialNames[] = {
+	"toplevel", "root", "self", "parent", "my", "CurrentTime"
+};
+
+	// the comparison that gives the same result with its operands swapped
+static Operation::OpKind
+swapOperands( Operation::OpKind op )
+{
+	switch( op ) {
+		case Operation::LESS_THAN_OP:			return Operation::GREATER_THAN_OP;
+		case Operation::LESS_OR_EQUAL_OP:		return Operation::GREATER_OR_EQUAL_OP;
+		case Operation::GREATER_OR_EQUAL_OP:	return Operation::LESS_OR_EQUAL_OP;
+		case Operation::GREATER_THAN_OP:		return Operation::LESS_THAN_OP;
+		default:								return op;
+	}
+}
+
+	// the result of a comparison, given how its operands compare
+static bool
+compareResult( Operation::OpKind op, int cmp )
+{
+	switch( op ) {
+		case Operation::LESS_THAN_OP:			return cmp < 0;
+		case Operation::LESS_OR_EQUAL_OP:		return cmp <= 0;
+		case Operation::GREATER_OR_EQUAL_OP:	return cmp >= 0;
+		case Operation::GREATER_THAN_OP:		return cmp > 0;
+		case Operation::EQUAL_OP:
+		case Operation::META_EQUAL_OP:			return cmp == 0;
+		default:								return cmp != 0;
+	}
+}
+
+
+BatchEval::
+BatchEval( const ExprTree *expr ) : tree( expr ), only_columns( true )
+{
+	if( tree ) {
+		addColumns( tree );
+	}
+}
+
+
+void BatchEval::
+addColumns( const ExprTree *expr )
+{
+	expr = expr->self( );
+	if( expr->GetKind( ) == ExprTree::OP_NODE ) {
+		Operation::OpKind	op;
+		ExprTree			*t1, *t2, *t3;
+		((const Operation *)expr)->GetComponents( op, t1, t2, t3 );
+		if( op == Operation::PARENTHESES_OP ) {
+			addColumns( t1 );
+			return;
+		}
+		if( op == Operation::LOGICAL_AND_OP ) {
+			addColumns( t1 );
+			addColumns( t2 );
+			return;
+		}
+	}
+
+	Column column;
+	if( isColumn( expr, column ) ) {
+		columns.push_back( column );
+	} else {
+		only_columns = false;
+	}
+}
+
+
+bool BatchEval::
+isColumn( const ExprTree *expr, Column &column ) const
+{
+	if( expr->GetKind( ) != ExprTree::OP_NODE ) {
+		return false;
+	}
+	Operation::OpKind	op;
+	ExprTree			*t1, *t2, *t3;
+	((const Operation *)expr)->GetComponents( op, t1, t2, t3 );
+	if( op < Operation::__COMPARISON_START__ || op > Operation::__COMPARISON_END__ ) {
+		return false;
+	}
+
+	const ExprTree *ref = t1->self( );
+	const ExprTree *lit = t2->self( );
+	if( ref->GetKind( ) == ExprTree::LITERAL_NODE ) {
+		std::swap( ref, lit );
+		op = swapOperands( op );
+	}
+	if( ref->GetKind( ) != ExprTree::ATTRREF_NODE ||
+		lit->GetKind( ) != ExprTree::LITERAL_NODE ) {
+		return false;
+	}
+
+		// only a plain attribute name is looked up in the ad alone
+	ExprTree	*scope;
+	string		name;
+	bool		absolute;
+	((const AttributeReference *)ref)->GetComponents( scope, name, absolute );
+	if( scope || absolute ) {
+		return false;
+	}
+	for( size_t ix = 0; ix < sizeof( specialNames ) / sizeof( specialNames[0] ); ix++ ) {
+		if( strcasecmp( name.c_str( ), specialNames[ix] ) == 0 ) {
+			return false;
+		}
+	}
+
+	column.attr = InternAttrName( name );
+	column.op = op;
+	((const Literal *)lit)->GetValue( column.literal );
+	return true;
+}
+
+
+BatchEval::Check BatchEval::
+check( const Column &column, const ClassAd *ad )
+{
+	Value			copy;
+	const Value		*val = &copy;
+	const ExprTree	*expr = ad->_Lookup( column.attr );
+	if( !expr ) {
+		copy.SetUndefinedValue( );
+	} else {
+		expr = expr->self( );
+		if( expr->GetKind( ) != ExprTree::LITERAL_NODE ) {
+			return CHECK_EXPR;
+		}
+		Value::NumberFactor factor;
+		val = &((const Literal *)expr)->getValue( factor );
+		if( factor != Value::NO_FACTOR ) {
+			((const Literal *)expr)->GetValue( copy );
+			val = &copy;
+		}
+	}
+
+		// integers and strings are compared in place, as
+		// Operation::Operate() would compare them
+	long long	i1, i2;
+	const char	*s1, *s2;
+	bool		result;
+	if( val->IsIntegerValue( i1 ) && column.literal.IsIntegerValue( i2 ) ) {
+		result = compareResult( column.op, i1 < i2 ? -1 : ( i1 > i2 ? 1 : 0 ) );
+	} else if( val->IsStringValue( s1 ) && column.literal.IsStringValue( s2 ) ) {
+		bool meta = column.op == Operation::META_EQUAL_OP ||
+			column.op == Operation::META_NOT_EQUAL_OP;
+		result = compareResult( column.op, meta ? strcmp( s1, s2 ) : strcasecmp( s1, s2 ) );
+	} else {
+		Value v1, v2, res;
+		v1.CopyFrom( *val );
+		v2.CopyFrom( column.literal );
+		Operation::Operate( column.op, v1, v2, res );
+		result = res.IsBooleanValue( result ) && result;
+	}
+	return result ? CHECK_TRUE : CHECK_FALSE;
+}
+
+
+void BatchEval::
+Evaluate( const ClassAd * const *ads, size_t count, vector<bool> &results ) const
+{
+	results.assign( count, false );
+	if( !tree ) {
+		return;
+	}
+
+		// An ad is false as soon as one of the columns is not true, since
+		// && is then not true either.  If all of them are true, the rest
+		// of the expression decides.  An ad with an alternate scope is
+		// evaluated whole, since what it lacks is looked for there.
+	vector<Check> checks( count, CHECK_TRUE );
+	for( size_t ix = 0; ix < count; ix++ ) {
+		if( !ads[ix] ) {
+			checks[ix] = CHECK_FALSE;
+		} else if( ads[ix]->alternateScope ) {
+			checks[ix] = CHECK_EXPR;
+		}
+	}
+	for( vector<Column>::const_iterator col = columns.begin( ); col != columns.end( ); col++ ) {
+		for( size_t ix = 0; ix < count; ix++ ) {
+			if( checks[ix] == CHECK_TRUE ) {
+				checks[ix] = check( *col, ads[ix] );
+			}
+		}
+	}
+
+	for( size_t ix = 0; ix < count; ix++ ) {
+		if( checks[ix] == CHECK_FALSE ) {
+			continue;
+		}
+		if( checks[ix] == CHECK_TRUE && only_columns ) {
+			results[ix] = true;
+			continue;
+		}
+		Value	val;
+		bool	b;
+		results[ix] = ads[ix]->EvaluateExpr( tree, val ) &&
+			val.IsBooleanValueEquiv( b ) && b;
+	}
+}
+
+} // classad
@@ -0,0 +1,316 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/exprTree.h"
+#include "classad/binarySink.h"
+#include "classad/util.h"
+#include "classad/classadCache.h"
+
+using namespace std;
+
+namespace classad {
+
+using namespace BinaryClassAd;
+
+ClassAdBinaryUnParser::
+ClassAdBinaryUnParser()
+{
+}
+
+
+ClassAdBinaryUnParser::
+~ClassAdBinaryUnParser()
+{
+}
+
+
+void ClassAdBinaryUnParser::
+Reset()
+{
+	m_names.clear();
+	m_order.clear();
+}
+
+
+void ClassAdBinaryUnParser::
+PutVarint( std::string &buffer, unsigned long long val )
+{
+	while (val >= 0x80) {
+		buffer += (char)((val & 0x7F) | 0x80);
+		val >>= 7;
+	}
+	buffer += (char)val;
+}
+
+
+static void
+PutZigZag( std::string &buffer, long long val )
+{
+	ClassAdBinaryUnParser::PutVarint( buffer, ((unsigned long long)val << 1) ^ (unsigned long long)(val >> 63) );
+}
+
+
+static void
+PutDouble( std::string &buffer, double d )
+{
+	unsigned long long bits;
+	memcpy( &bits, &d, sizeof(bits) );
+	for (int ii = 0; ii < 8; ++ii) {
+		buffer += (char)(bits & 0xFF);
+		bits >>= 8;
+	}
+}
+
+
+static void
+PutBytes( std::string &buffer, const char *str, size_t cch )
+{
+	ClassAdBinaryUnParser::PutVarint( buffer, cch );
+	buffer.append( str, cch );
+}
+
+
+void ClassAdBinaryUnParser::
+UnparseName( std::string &buffer, const std::string &name )
+{
+	unordered_map<string, unsigned int>::const_iterator found = m_names.find( name );
+	if (found != m_names.end()) {
+		PutVarint( buffer, found->second + 1 );
+		return;
+	}
+	PutVarint( buffer, 0 );
+	PutBytes( buffer, name.data(), name.size() );
+	if (m_order.size() < MAX_NAMES) {
+		m_names[name] = (unsigned int)m_order.size();
+		m_order.push_back( name );
+	}
+}
+
+
+// forget the names added since the table held the given number of names,
+// used when an encoding is abandoned half way so the reader never sees them.
+void ClassAdBinaryUnParser::
+Rollback( size_t names )
+{
+	while (m_order.size() > names) {
+		m_names.erase( m_order.back() );
+		m_order.pop_back();
+	}
+}
+
+
+bool ClassAdBinaryUnParser::
+Unparse( std::string &buffer, const ExprTree *expr )
+{
+	size_t mark = buffer.size();
+	size_t names = m_order.size();
+	if ( ! UnparseAux( buffer, expr )) {
+		buffer.resize( mark );
+		Rollback( names );
+		return false;
+	}
+	return true;
+}
+
+
+bool ClassAdBinaryUnParser::
+Unparse( std::string &buffer, const ClassAd *ad )
+{
+	if ( ! ad) {
+		return false;
+	}
+	size_t mark = buffer.size();
+	size_t names = m_order.size();
+	PutVarint( buffer, ad->size() );
+	for (AttrList::const_iterator itr = ad->begin(); itr != ad->end(); ++itr) {
+		UnparseName( buffer, itr->first );
+		if ( ! UnparseAux( buffer, itr->second )) {
+			buffer.resize( mark );
+			Rollback( names );
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool ClassAdBinaryUnParser::
+Unparse( std::string &buffer, const vector< pair< string, ExprTree*> >& attrs )
+{
+	size_t mark = buffer.size();
+	size_t names = m_order.size();
+	PutVarint( buffer, attrs.size() );
+	for (vector< pair< string, ExprTree*> >::const_iterator itr = attrs.begin(); itr != attrs.end(); ++itr) {
+		UnparseName( buffer, itr->first );
+		if ( ! UnparseAux( buffer, itr->second )) {
+			buffer.resize( mark );
+			Rollback( names );
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool ClassAdBinaryUnParser::
+UnparseAux( std::string &buffer, const ExprTree *tree )
+{
+	if ( ! tree) {
+		return false;
+	}
+
+	switch (tree->GetKind()) {
+		case ExprTree::LITERAL_NODE: {
+			Value::NumberFactor factor;
+			const Value &val = ((const Literal*)tree)->getValue( factor );
+			if (factor != Value::NO_FACTOR && (val.IsIntegerValue() || val.IsRealValue())) {
+				buffer += (char)FACTOR_TAG;
+				buffer += (char)factor;
+			}
+			switch (val.GetType()) {
+				case Value::UNDEFINED_VALUE:
+					buffer += (char)UNDEFINED_TAG;
+					return true;
+				case Value::ERROR_VALUE:
+					buffer += (char)ERROR_TAG;
+					return true;
+				case Value::BOOLEAN_VALUE: {
+					bool b = false;
+					val.IsBooleanValue( b );
+					buffer += (char)(b ? TRUE_TAG : FALSE_TAG);
+					return true;
+				}
+				case Value::INTEGER_VALUE: {
+					long long i = 0;
+					val.IsIntegerValue( i );
+					buffer += (char)INTEGER_TAG;
+					PutZigZag( buffer, i );
+					return true;
+				}
+				case Value::REAL_VALUE: {
+					double d = 0;
+					val.IsRealValue( d );
+					buffer += (char)REAL_TAG;
+					PutDouble( buffer, d );
+					return true;
+				}
+				case Value::STRING_VALUE: {
+					const char *str = NULL;
+					int cch = 0;
+					val.IsStringValue( str );
+					val.IsStringValue( cch );
+					buffer += (char)STRING_TAG;
+					PutBytes( buffer, str, cch );
+					return true;
+				}
+				case Value::ABSOLUTE_TIME_VALUE: {
+					abstime_t atime;
+					val.IsAbsoluteTimeValue( atime );
+					buffer += (char)ABSTIME_TAG;
+					PutZigZag( buffer, atime.secs );
+					PutZigZag( buffer, atime.offset );
+					return true;
+				}
+				case Value::RELATIVE_TIME_VALUE: {
+					double secs = 0;
+					val.IsRelativeTimeValue( secs );
+					buffer += (char)RELTIME_TAG;
+					PutDouble( buffer, secs );
+					return true;
+				}
+				default:
+					// lists and classads are not expected in a literal
+					return false;
+			}
+		}
+
+		case ExprTree::ATTRREF_NODE: {
+			ExprTree *expr = NULL;
+			string ref;
+			bool absolute = false;
+			((const AttributeReference*)tree)->GetComponents( expr, ref, absolute );
+			buffer += (char)ATTRREF_TAG;
+			buffer += (char)((absolute ? ATTRREF_ABSOLUTE : 0) | (expr ? ATTRREF_SCOPED : 0));
+			UnparseName( buffer, ref );
+			return ! expr || UnparseAux( buffer, expr );
+		}
+
+		case ExprTree::OP_NODE: {
+			Operation::OpKind op;
+			ExprTree *t1 = NULL, *t2 = NULL, *t3 = NULL;
+			((const Operation*)tree)->GetComponents( op, t1, t2, t3 );
+			buffer += (char)OP_TAG;
+			buffer += (char)op;
+			buffer += (char)((t1 ? 1 : 0) | (t2 ? 2 : 0) | (t3 ? 4 : 0));
+			return ( ! t1 || UnparseAux( buffer, t1 )) &&
+				( ! t2 || UnparseAux( buffer, t2 )) &&
+				( ! t3 || UnparseAux( buffer, t3 ));
+		}
+
+		case ExprTree::FN_CALL_NODE: {
+			string fnName;
+			vector<ExprTree*> args;
+			((const FunctionCall*)tree)->GetComponents( fnName, args );
+			buffer += (char)FNCALL_TAG;
+			UnparseName( buffer, fnName );
+			PutVarint( buffer, args.size() );
+			for (vector<ExprTree*>::const_iterator itr = args.begin(); itr != args.end(); ++itr) {
+				if ( ! UnparseAux( buffer, *itr )) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		case ExprTree::CLASSAD_NODE: {
+			const ClassAd *ad = (const ClassAd*)tree;
+			buffer += (char)CLASSAD_TAG;
+			PutVarint( buffer, ad->size() );
+			for (AttrList::const_iterator itr = ad->begin(); itr != ad->end(); ++itr) {
+				UnparseName( buffer, itr->first );
+				if ( ! UnparseAux( buffer, itr->second )) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		case ExprTree::EXPR_LIST_NODE: {
+			const ExprList *list = (const ExprList*)tree;
+			buffer += (char)LIST_TAG;
+			PutVarint( buffer, list->size() );
+			for (ExprList::const_iterator itr = list->begin(); itr != list->end(); ++itr) {
+				if ( ! UnparseAux( buffer, *itr )) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		case ExprTree::EXPR_ENVELOPE:
+			// recurse b/c we indirect for this element.
+			return UnparseAux( buffer, ((const CachedExprEnvelope*)tree)->get() );
+	}
+
+	return false;
+}
+
+} // classad
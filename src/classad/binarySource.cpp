@@ -0,0 +1,365 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/exprTree.h"
+#include "classad/binarySource.h"
+#include "classad/classad.h"
+#include "classad/util.h"
+
+using namespace std;
+
+namespace classad {
+
+using namespace BinaryClassAd;
+
+ClassAdBinaryParser::
+ClassAdBinaryParser()
+	: m_pos(NULL)
+	, m_end(NULL)
+{
+}
+
+
+ClassAdBinaryParser::
+~ClassAdBinaryParser()
+{
+}
+
+
+void ClassAdBinaryParser::
+Reset()
+{
+	m_names.clear();
+}
+
+
+ExprTree *ClassAdBinaryParser::
+ParseExpression( const char *buf, size_t len, size_t *used )
+{
+	m_pos = (const unsigned char *)buf;
+	m_end = m_pos + len;
+	ExprTree *tree = ParseAux( 0 );
+	if (used) { *used = m_pos - (const unsigned char *)buf; }
+	return tree;
+}
+
+
+bool ClassAdBinaryParser::
+ParseClassAd( const char *buf, size_t len, ClassAd &ad, size_t *used )
+{
+	m_pos = (const unsigned char *)buf;
+	m_end = m_pos + len;
+	bool ok = ParseAttrs( ad, 0 );
+	if (used) { *used = m_pos - (const unsigned char *)buf; }
+	return ok;
+}
+
+
+bool ClassAdBinaryParser::
+GetVarint( unsigned long long &val )
+{
+	val = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (m_pos >= m_end) {
+			return false;
+		}
+		unsigned char ch = *m_pos++;
+		val |= (unsigned long long)(ch & 0x7F) << shift;
+		if ( ! (ch & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool ClassAdBinaryParser::
+Get64( unsigned long long &bits )
+{
+	if (m_end - m_pos < 8) {
+		return false;
+	}
+	bits = 0;
+	for (int ii = 7; ii >= 0; --ii) {
+		bits = (bits << 8) | m_pos[ii];
+	}
+	m_pos += 8;
+	return true;
+}
+
+
+bool ClassAdBinaryParser::
+GetBytes( std::string &str )
+{
+	unsigned long long cch;
+	if ( ! GetVarint( cch ) || cch > (unsigned long long)(m_end - m_pos)) {
+		return false;
+	}
+	str.assign( (const char *)m_pos, (size_t)cch );
+	m_pos += cch;
+	return true;
+}
+
+
+bool ClassAdBinaryParser::
+GetName( std::string &name )
+{
+	unsigned long long ref;
+	if ( ! GetVarint( ref )) {
+		return false;
+	}
+	if (ref) {
+		if (ref > m_names.size()) {
+			return false;
+		}
+		name = m_names[ref - 1];
+		return true;
+	}
+	if ( ! GetBytes( name )) {
+		return false;
+	}
+	// the writer adds names to its table by the same rule
+	if (m_names.size() < MAX_NAMES) {
+		m_names.push_back( name );
+	}
+	return true;
+}
+
+
+static long long
+ZigZag( unsigned long long val )
+{
+	return (long long)(val >> 1) ^ -(long long)(val & 1);
+}
+
+
+bool ClassAdBinaryParser::
+ParseAttrs( ClassAd &ad, int depth )
+{
+	unsigned long long count;
+	if ( ! GetVarint( count ) || count > (unsigned long long)(m_end - m_pos)) {
+		return false;
+	}
+	string name;
+	for (unsigned long long ii = 0; ii < count; ++ii) {
+		if ( ! GetName( name )) {
+			return false;
+		}
+		ExprTree *tree = ParseAux( depth + 1 );
+		if ( ! tree || ! ad.Insert( name, tree )) {
+			delete tree;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+ExprTree *ClassAdBinaryParser::
+ParseAux( int depth )
+{
+	if (depth > MAX_DEPTH || m_pos >= m_end) {
+		return NULL;
+	}
+
+	int tag = *m_pos++;
+	Value val;
+	Value::NumberFactor factor = Value::NO_FACTOR;
+	if (tag == FACTOR_TAG) {
+		if (m_end - m_pos < 2 || *m_pos > Value::T_FACTOR) {
+			return NULL;
+		}
+		factor = (Value::NumberFactor)*m_pos++;
+		tag = *m_pos++;
+		if (tag != INTEGER_TAG && tag != REAL_TAG) {
+			return NULL;
+		}
+	}
+
+	switch (tag) {
+		case UNDEFINED_TAG:
+			return Literal::MakeUndefined();
+
+		case ERROR_TAG:
+			return Literal::MakeError();
+
+		case FALSE_TAG:
+		case TRUE_TAG:
+			return Literal::MakeBool( tag == TRUE_TAG );
+
+		case INTEGER_TAG: {
+			unsigned long long bits;
+			if ( ! GetVarint( bits )) {
+				return NULL;
+			}
+			if (factor == Value::NO_FACTOR) {
+				return Literal::MakeLong( ZigZag( bits ));
+			}
+			val.SetIntegerValue( ZigZag( bits ));
+			return Literal::MakeLiteral( val, factor );
+		}
+
+		case REAL_TAG: {
+			unsigned long long bits;
+			double d;
+			if ( ! Get64( bits )) {
+				return NULL;
+			}
+			memcpy( &d, &bits, sizeof(d) );
+			if (factor == Value::NO_FACTOR) {
+				return Literal::MakeReal( d );
+			}
+			val.SetRealValue( d );
+			return Literal::MakeLiteral( val, factor );
+		}
+
+		case STRING_TAG: {
+			string str;
+			if ( ! GetBytes( str )) {
+				return NULL;
+			}
+			return Literal::MakeString( str );
+		}
+
+		case ABSTIME_TAG: {
+			unsigned long long secs, offset;
+			if ( ! GetVarint( secs ) || ! GetVarint( offset )) {
+				return NULL;
+			}
+			abstime_t atime;
+			atime.secs = (time_t)ZigZag( secs );
+			atime.offset = (int)ZigZag( offset );
+			val.SetAbsoluteTimeValue( atime );
+			return Literal::MakeLiteral( val );
+		}
+
+		case RELTIME_TAG: {
+			unsigned long long bits;
+			double secs;
+			if ( ! Get64( bits )) {
+				return NULL;
+			}
+			memcpy( &secs, &bits, sizeof(secs) );
+			val.SetRelativeTimeValue( secs );
+			return Literal::MakeLiteral( val );
+		}
+
+		case ATTRREF_TAG: {
+			if (m_pos >= m_end) {
+				return NULL;
+			}
+			int flags = *m_pos++;
+			string ref;
+			if ( ! GetName( ref )) {
+				return NULL;
+			}
+			ExprTree *expr = NULL;
+			if (flags & ATTRREF_SCOPED) {
+				expr = ParseAux( depth + 1 );
+				if ( ! expr) {
+					return NULL;
+				}
+			}
+			return AttributeReference::MakeAttributeReference( expr, ref, (flags & ATTRREF_ABSOLUTE) != 0 );
+		}
+
+		case OP_TAG: {
+			if (m_end - m_pos < 2) {
+				return NULL;
+			}
+			int op = *m_pos++;
+			int mask = *m_pos++;
+			// the operands must be exactly the ones the operator takes
+			int want = 3;
+			if (op == Operation::PARENTHESES_OP || op == Operation::UNARY_PLUS_OP || op == Operation::UNARY_MINUS_OP ||
+				op == Operation::LOGICAL_NOT_OP || op == Operation::BITWISE_NOT_OP) {
+				want = 1;
+			} else if (op == Operation::TERNARY_OP) {
+				want = 7;
+			}
+			if (op < Operation::__FIRST_OP__ || op > Operation::__LAST_OP__ || mask != want) {
+				return NULL;
+			}
+			ExprTree *t[3] = { NULL, NULL, NULL };
+			for (int ii = 0; ii < 3; ++ii) {
+				if ((mask & (1 << ii)) && ! (t[ii] = ParseAux( depth + 1 ))) {
+					delete t[0]; delete t[1];
+					return NULL;
+				}
+			}
+			ExprTree *tree = Operation::MakeOperation( (Operation::OpKind)op, t[0], t[1], t[2] );
+			if ( ! tree) {
+				delete t[0]; delete t[1]; delete t[2];
+			}
+			return tree;
+		}
+
+		case FNCALL_TAG: {
+			string fnName;
+			unsigned long long argc;
+			if ( ! GetName( fnName ) || ! GetVarint( argc ) || argc > (unsigned long long)(m_end - m_pos)) {
+				return NULL;
+			}
+			vector<ExprTree*> args;
+			args.reserve( (size_t)argc );
+			for (unsigned long long ii = 0; ii < argc; ++ii) {
+				ExprTree *arg = ParseAux( depth + 1 );
+				if ( ! arg) {
+					for (size_t jj = 0; jj < args.size(); ++jj) { delete args[jj]; }
+					return NULL;
+				}
+				args.push_back( arg );
+			}
+			return FunctionCall::MakeFunctionCall( fnName, args );
+		}
+
+		case CLASSAD_TAG: {
+			ClassAd *ad = new ClassAd();
+			if ( ! ParseAttrs( *ad, depth )) {
+				delete ad;
+				return NULL;
+			}
+			return ad;
+		}
+
+		case LIST_TAG: {
+			unsigned long long count;
+			if ( ! GetVarint( count ) || count > (unsigned long long)(m_end - m_pos)) {
+				return NULL;
+			}
+			vector<ExprTree*> list;
+			list.reserve( (size_t)count );
+			for (unsigned long long ii = 0; ii < count; ++ii) {
+				ExprTree *item = ParseAux( depth + 1 );
+				if ( ! item) {
+					for (size_t jj = 0; jj < list.size(); ++jj) { delete list[jj]; }
+					return NULL;
+				}
+				list.push_back( item );
+			}
+			return ExprList::MakeExprList( list );
+		}
+	}
+
+	return NULL;
+}
+
+} // classad
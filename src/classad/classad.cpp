@@ -23,6 +23,8 @@
 #include "classad/source.h"
 #include "classad/sink.h"
 #include "classad/classadCache.h"
+#include "classad/classadArena.h"
+#include "classad/evalProfile.h"
 
 using namespace std;
 
@@ -151,11 +153,14 @@ CopyFrom( const ClassAd &ad )
 		succeeded = false;
 	} else 
 	{
+		// Clear() lets go of a shared parent, which may be the other ad
+		classad_shared_ptr<ClassAd> parent_ref = chained_parent_ref;
 		Clear( );
 		
 		// copy scoping attributes
 		ExprTree::CopyFrom(ad);
 		chained_parent_ad = ad.chained_parent_ad;
+		chained_parent_ref = ad.chained_parent_ref;
 		alternateScope = ad.alternateScope;
 		parentScope = ad.parentScope;
 		
@@ -197,6 +202,7 @@ CopyFromChain( const ClassAd &ad )
 {
 	if (this == &ad) return false;
 
+	classad_shared_ptr<ClassAd> parent_ref = chained_parent_ref;
 	Clear( );
 	ExprTree::CopyFrom(ad);
 	return UpdateFromChain(ad);
@@ -547,7 +553,11 @@ bool ClassAd::InsertViaCache( std::string& name, const std::string & rhs, bool l
 	// we did not use the cache, or get a hit in the cache... parse the expression
 	ClassAdParser parser;
 	parser.SetOldClassAd(true);
-	tree = parser.ParseExpression(rhs);
+	{
+			// cached expressions may be shared with ads of other batches
+		ClassAdArena::Parsing parsing(use_cache);
+		tree = parser.ParseExpression(rhs);
+	}
 	if ( ! tree) {
 		return false;
 	}
@@ -718,6 +728,20 @@ Lookup( const string &name ) const
 	return tree;
 }
 
+ExprTree *ClassAd::
+_Lookup( const AttrName *atom ) const
+{
+	const ClassAd *ad = this;
+	do {
+		AttrList::const_iterator itr = ad->attrList.find( atom );
+		if( itr != ad->attrList.end( ) ) {
+			return itr->second;
+		}
+		ad = ad->chained_parent_ad;
+	} while( ad );
+	return NULL;
+}
+
 ExprTree *ClassAd::
 LookupIgnoreChain( const string &name ) const
 {
@@ -753,7 +777,7 @@ LookupInScope( const string &name, const ClassAd *&finalScope ) const
 
 
 int ClassAd::
-LookupInScope(const string &name, ExprTree*& expr, EvalState &state) const
+LookupInScope(const string &name, ExprTree*& expr, EvalState &state, const AttrName *atom) const
 {
 	const ClassAd *current = this, *superScope;
 
@@ -765,7 +789,8 @@ LookupInScope(const string &name, ExprTree*& expr, EvalState &state) const
 		state.curAd = current;
 
 		// lookup in current scope
-		if( ( expr = current->Lookup( name ) ) ) {
+		expr = atom ? current->_Lookup( atom ) : current->Lookup( name );
+		if( expr ) {
 			return( EVAL_OK );
 		}
 
@@ -880,8 +905,9 @@ Remove( const string &name )
 	if (chained_parent_ad != NULL &&
 		chained_parent_ad->Lookup(name) != NULL) {
 
+		// the caller owns what we return, so it can't be the parent's
 		if (tree == NULL) {
-			tree = chained_parent_ad->Lookup(name);
+			tree = chained_parent_ad->Lookup(name)->Copy();
 		}
 		
 		Value undefined_value;
@@ -1018,6 +1044,7 @@ Copy( ) const
 	if( !newAd ) return NULL;
 	newAd->parentScope = parentScope;
 	newAd->chained_parent_ad = chained_parent_ad;
+	newAd->chained_parent_ref = chained_parent_ref;
 
 	AttrList::const_iterator	itr;
 	for( itr=attrList.begin( ); itr != attrList.end( ); itr++ ) {
@@ -1122,6 +1149,13 @@ EvaluateAttr( const string &attr , Value &val ) const
 			return false;
 
 		case EVAL_OK:
+			if( EvalProfile::Enabled( ) ) {
+				const ClassAd *foundAd = state.curAd;
+				EvalProfile::Timer timer;
+				bool rval = tree->Evaluate( state, val );
+				EvalProfile::CountAttribute( attr, foundAd, timer.Seconds( ) );
+				return rval;
+			}
 			return( tree->Evaluate( state, val ) );
 
 		case EVAL_UNDEF:
@@ -2141,11 +2175,23 @@ CurrentAttribute (string &attr, const ExprTree *&expr) const
 void ClassAd::ChainToAd(ClassAd *new_chain_parent_ad)
 {
 	if (new_chain_parent_ad != NULL) {
+		if (new_chain_parent_ad != chained_parent_ref.get()) {
+			chained_parent_ref.reset();
+		}
 		chained_parent_ad = new_chain_parent_ad;
 	}
 	return;
 }
 
+void ClassAd::ChainToSharedAd(const classad_shared_ptr<ClassAd> &new_chain_parent_ad)
+{
+	if (new_chain_parent_ad) {
+		chained_parent_ref = new_chain_parent_ad;
+		chained_parent_ad = new_chain_parent_ad.get();
+	}
+	return;
+}
+
 bool ClassAd::PruneChildAttr(const std::string & attrName, bool if_child_matches /*=true*/)
 {
 	if ( ! chained_parent_ad)
@@ -2176,7 +2222,7 @@ int ClassAd::PruneChildAd()
 	if (chained_parent_ad)
 	{
 		// loop through cleaning all expressions which are the same.
-		AttrList::const_iterator	itr= attrList.begin( );
+		AttrList::iterator			itr= attrList.begin( );
 		ExprTree 					*tree;
 	
 		while (itr != attrList.end() )
@@ -2184,12 +2230,11 @@ int ClassAd::PruneChildAd()
 			tree = chained_parent_ad->Lookup(itr->first);
 				
 			if(  tree && tree->SameAs(itr->second) ) {
-				AttrList::const_iterator rm_itr = itr;
-				itr++; // once 
 				// 1st remove from dirty list
-				MarkAttributeClean(rm_itr->first);
-				delete rm_itr->second;
-				attrList.erase( rm_itr->first );
+				MarkAttributeClean(itr->first);
+				delete itr->second;
+				// erase moves the last attribute here, so don't advance
+				itr = attrList.erase( itr );
 				iRet++;
 			}
 			else
@@ -2205,9 +2250,30 @@ int ClassAd::PruneChildAd()
 void ClassAd::Unchain(void)
 {
 	chained_parent_ad = NULL;
+	chained_parent_ref.reset();
 	return;
 }
 
+void ClassAd::ChainCollapse(void)
+{
+	if ( ! chained_parent_ad) {
+		return;
+	}
+
+	// keep the parent until its attributes are copied
+	const ClassAd *parent = chained_parent_ad;
+	classad_shared_ptr<ClassAd> parent_ref = chained_parent_ref;
+	Unchain();
+
+	for (const ClassAd *ad = parent; ad; ad = ad->chained_parent_ad) {
+		for (AttrList::const_iterator itr = ad->attrList.begin(); itr != ad->attrList.end(); itr++) {
+			if (attrList.find(itr->first) == attrList.end()) {
+				Insert(itr->first, itr->second->Copy());
+			}
+		}
+	}
+}
+
 ClassAd *ClassAd::GetChainedParentAd(void)
 {
 	return chained_parent_ad;
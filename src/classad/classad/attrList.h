@@ -0,0 +1,188 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_ATTR_LIST_H__
+#define __CLASSAD_ATTR_LIST_H__
+
+#include "classad/common.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+
+namespace classad {
+
+class ExprTree;
+
+/** An attribute name interned in a process-wide table.  Each spelling of
+	a name is interned once, so ads share the strings for their names, and
+	all the spellings that are the same ignoring case share one atom, so
+	names can be compared by address.  AttrNames are never freed.
+*/
+struct AttrName {
+	std::string		name;	// as spelled
+	size_t			hash;	// ClassadAttrNameHash, the same for every spelling
+	const AttrName	*atom;	// the spelling that stands for all of them
+};
+
+/** Find or add the interned form of an attribute name.
+	@param name The attribute name
+	@return The interned name, which is never NULL
+*/
+const AttrName *InternAttrName( const std::string &name );
+
+/** The attributes of a ClassAd, a map from the case-insensitive attribute
+	name to the expression.  Each attribute is just its interned name and
+	its expression, kept in a vector; lists of more than a few attributes
+	also get an open-addressing index on the hash of the name.  Iteration
+	is in no particular order, and deleting an attribute moves the last
+	attribute into its place.  Supports the parts of the interface of
+	std::unordered_map that ClassAd and its users need; an iterator
+	points at something with a first (the name) and a second (the
+	expression), like a std::pair.
+*/
+class AttrList
+{
+		struct Attr {
+			const AttrName	*name;
+			ExprTree		*tree;
+		};
+
+	public:
+		/// What an iterator points at
+		template <class Tree>
+		struct AttrRef {
+			AttrRef( const std::string &n, Tree &t ) : first( n ), second( t ) {}
+			const AttrRef *operator->( ) const { return this; }
+			template <class T>
+			operator std::pair<std::string, T>( ) const {
+				return std::pair<std::string, T>( first, second );
+			}
+			const std::string	&first;
+			Tree				&second;
+		};
+
+		template <class Tree, class Entry>
+		class Iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef AttrRef<Tree> value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef AttrRef<Tree> reference;
+				typedef AttrRef<Tree> pointer;
+
+				Iterator( ) : entry( NULL ) {}
+				template <class T2, class E2>
+				Iterator( const Iterator<T2,E2> &other ) : entry( other.entry ) {}
+
+				reference operator*( ) const {
+					return reference( entry->name->name, entry->tree );
+				}
+				pointer operator->( ) const { return **this; }
+				Iterator &operator++( ) { ++entry; return *this; }
+				Iterator operator++( int ) { Iterator tmp( *this ); ++entry; return tmp; }
+
+				template <class T2, class E2>
+				bool operator==( const Iterator<T2,E2> &other ) const {
+					return entry == other.entry;
+				}
+				template <class T2, class E2>
+				bool operator!=( const Iterator<T2,E2> &other ) const {
+					return entry != other.entry;
+				}
+
+				/// The interned name of the attribute
+				const AttrName *name( ) const { return entry->name; }
+
+			private:
+				explicit Iterator( Entry *e ) : entry( e ) {}
+				template <class T2, class E2> friend class Iterator;
+				friend class AttrList;
+				Entry *entry;
+		};
+
+		typedef Iterator<ExprTree*, Attr> iterator;
+		typedef Iterator<ExprTree* const, const Attr> const_iterator;
+
+		AttrList( ) : shift( 0 ) {}
+
+		iterator begin( ) { return iterator( entry( 0 ) ); }
+		const_iterator begin( ) const { return const_iterator( entry( 0 ) ); }
+		iterator end( ) { return iterator( entry( items.size( ) ) ); }
+		const_iterator end( ) const { return const_iterator( entry( items.size( ) ) ); }
+
+		size_t size( ) const { return items.size( ); }
+		bool empty( ) const { return items.empty( ); }
+		void clear( );
+
+		/// Make room for at least the given number of attributes
+		void reserve( size_t count );
+		void rehash( size_t count ) { reserve( count ); }
+
+		iterator find( const std::string &name );
+		const_iterator find( const std::string &name ) const;
+
+		/// Find using an interned name, which saves comparing strings
+		const_iterator find( const AttrName *name ) const;
+
+		/** Insert an attribute if there is none of the same name.
+			@return The attribute of that name, and whether it was
+				inserted.
+		*/
+		std::pair<iterator,bool> emplace( const std::string &name, ExprTree *tree );
+
+		/// The expression of an attribute, inserting it as NULL if needed
+		ExprTree *&operator[]( const std::string &name );
+
+		/** Remove an attribute.
+			@return The position of the attribute that was moved into its
+				place, which is end() if it was the last one.
+		*/
+		iterator erase( const_iterator itr );
+		size_t erase( const std::string &name );
+
+		void swap( AttrList &other );
+
+	private:
+			// at or below this many attributes, search without an index
+		static const size_t SMALL_SIZE = 8;
+
+		Attr *entry( size_t ii ) { return items.empty( ) ? NULL : &items[0] + ii; }
+		const Attr *entry( size_t ii ) const { return items.empty( ) ? NULL : &items[0] + ii; }
+
+		int lookup( const std::string &name ) const;
+		int lookup( const AttrName *name ) const;
+		size_t home( size_t hash ) const;
+		void append( const AttrName *name, ExprTree *tree );
+		void buildIndex( size_t count );
+		void indexEntry( size_t ii );
+		size_t findSlot( size_t ii ) const;
+		void unindex( size_t ii );
+
+		std::vector<Attr>			items;
+		std::vector<unsigned int>	index;	// an item plus one, or 0 if empty;
+											// empty for small lists
+		int							shift;	// maps a hash to a slot
+};
+
+} // classad
+
+#endif//__CLASSAD_ATTR_LIST_H__
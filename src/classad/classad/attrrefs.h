@@ -23,6 +23,8 @@
 
 namespace classad {
 
+struct AttrName;
+
 /// Represents a attribute reference node (like .b) in the expression tree
 class AttributeReference : public ExprTree 
 {
@@ -112,6 +114,7 @@ class AttributeReference : public ExprTree
 		ExprTree	*expr;
 		bool		absolute;
     	std::string attributeStr;
+		const AttrName *attrAtom;	// interned attributeStr, for lookups
 };
 
 } // classad
@@ -0,0 +1,92 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_BATCH_EVAL_H__
+#define __CLASSAD_BATCH_EVAL_H__
+
+#include "classad/operators.h"
+#include <vector>
+
+namespace classad {
+
+class ClassAd;
+struct AttrName;
+
+/** Evaluates one expression, such as a query constraint, in each of many
+	ads.  The expression is looked over once, and the comparisons of an
+	attribute with a literal that it &&s together, like
+	<tt>JobStatus == 2 && Owner == "alice"</tt>, are then checked a
+	comparison at a time across all of the ads, straight from the
+	attribute values in the ads.  An ad stops being checked as soon as
+	one of them is not true.  The whole expression is only evaluated in
+	the ads where the comparisons could not settle the result: where an
+	attribute is an expression rather than a literal, or where the rest
+	of the expression still has to be checked.
+	The results are the same as evaluating the expression in each ad.
+*/
+class BatchEval
+{
+	public:
+		/** Prepare an expression for evaluation.
+			@param tree The expression; it must not change, or be deleted,
+				while this is in use.
+		*/
+		BatchEval( const ExprTree *tree );
+
+		/** Evaluate the expression in each ad, as ClassAd::EvaluateExpr()
+				would, and note where it is true or a nonzero number.
+				Several threads may evaluate at the same time.
+			@param ads The ads; a NULL ad counts as false
+			@param count The number of ads
+			@param results Set to one result for each ad
+		*/
+		void Evaluate( const ClassAd * const *ads, size_t count,
+				std::vector<bool> &results ) const;
+
+		void Evaluate( const std::vector<ClassAd*> &ads,
+				std::vector<bool> &results ) const {
+			Evaluate( ads.empty() ? NULL : &ads[0], ads.size(), results );
+		}
+
+		/// The number of comparisons that are checked across the ads
+		size_t Columns( ) const { return columns.size(); }
+
+	private:
+		// a comparison of an attribute of the ad with a literal
+		struct Column {
+			const AttrName		*attr;
+			Operation::OpKind	op;			// with the attribute on the left
+			Value				literal;
+		};
+
+		enum Check { CHECK_FALSE, CHECK_TRUE, CHECK_EXPR };
+
+		void addColumns( const ExprTree *tree );
+		bool isColumn( const ExprTree *tree, Column &column ) const;
+		static Check check( const Column &column, const ClassAd *ad );
+
+		const ExprTree		*tree;
+		std::vector<Column>	columns;
+		bool				only_columns;	// tree is just the columns &&ed
+};
+
+} // classad
+
+#endif//__CLASSAD_BATCH_EVAL_H__
@@ -0,0 +1,126 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_BINARY_SINK_H__
+#define __CLASSAD_BINARY_SINK_H__
+
+#include "classad/common.h"
+#include "classad/exprTree.h"
+#include <vector>
+#include <utility>	// for pair template
+#include <string>
+#include <unordered_map>
+
+namespace classad {
+
+/** The compact binary encoding of ClassAds and expressions.
+
+	Expressions are written as a tree of tagged nodes rather than as text,
+	so the reader does not need to run the lexer or parser.  Literals are
+	written in their native form: integers as zig-zag varints, reals as
+	their 8 byte IEEE representation and strings as a varint length
+	followed by the bytes.
+
+	Attribute names (and function names) are written by reference to a
+	table of names that the writer and reader build up as they go.  The
+	first time a name is written it is written in full and added to the
+	table, after that it is written as its index in the table.  So the
+	writer and the reader must see the same sequence of ads and
+	expressions for as long as they keep their tables; Reset() both of
+	them to start over.
+*/
+namespace BinaryClassAd {
+	enum Tag {
+		UNDEFINED_TAG = 1,
+		ERROR_TAG,
+		FALSE_TAG,
+		TRUE_TAG,
+		INTEGER_TAG,    // zig-zag varint
+		REAL_TAG,       // 8 bytes, little endian
+		STRING_TAG,     // varint length, bytes
+		ABSTIME_TAG,    // zig-zag varint seconds, zig-zag varint offset
+		RELTIME_TAG,    // 8 bytes, little endian
+		FACTOR_TAG,     // number factor byte, then the numeric literal
+
+		ATTRREF_TAG = 16, // flags byte, name, [scope expression]
+		OP_TAG,         // operator byte, operand mask byte, operands
+		FNCALL_TAG,     // name, varint argument count, arguments
+		CLASSAD_TAG,    // varint attribute count, (name, expression) pairs
+		LIST_TAG,       // varint count, expressions
+	};
+
+	enum AttrRefFlags {
+		ATTRREF_ABSOLUTE = 1,
+		ATTRREF_SCOPED = 2,
+	};
+
+	/// names beyond this many are always written in full
+	const unsigned int MAX_NAMES = 4096;
+
+	/// the deepest nesting of expressions the reader will accept
+	const int MAX_DEPTH = 1000;
+}
+
+/// This converts a ClassAd or expression into the binary encoding
+class ClassAdBinaryUnParser
+{
+ public:
+	/// Constructor
+	ClassAdBinaryUnParser( );
+
+	/// Destructor
+	virtual ~ClassAdBinaryUnParser( );
+
+	/** Append the encoding of an expression to the buffer.
+		@return false if the expression cannot be encoded (the buffer and
+			the name table are left as they were)
+	*/
+	bool Unparse( std::string &buffer, const ExprTree *expr );
+
+	/** Append the encoding of a ClassAd's attributes to the buffer, in the
+		form that ClassAdBinaryParser::ParseClassAd reads.  The chained
+		parent ad is not included.
+	*/
+	bool Unparse( std::string &buffer, const ClassAd *ad );
+
+	/// Append the encoding of a list of attributes, as if they were a ClassAd
+	bool Unparse( std::string &buffer,
+			const std::vector< std::pair< std::string, ExprTree*> >& attrs );
+
+	/// Forget the name table
+	void Reset( );
+
+	/// The number of names in the name table
+	size_t NameCount( ) const { return m_names.size(); }
+
+	static void PutVarint( std::string &buffer, unsigned long long val );
+
+ protected:
+	bool UnparseAux( std::string &buffer, const ExprTree *expr );
+	void UnparseName( std::string &buffer, const std::string &name );
+	void Rollback( size_t names );
+
+	std::unordered_map<std::string, unsigned int> m_names;
+	std::vector<std::string> m_order;
+};
+
+} // classad
+
+#endif//__CLASSAD_BINARY_SINK_H__
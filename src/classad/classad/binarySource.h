@@ -0,0 +1,75 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_BINARY_SOURCE_H__
+#define __CLASSAD_BINARY_SOURCE_H__
+
+#include "classad/binarySink.h"
+#include <vector>
+#include <string>
+
+namespace classad {
+
+class ClassAd;
+
+/// This reads ClassAds and expressions written by ClassAdBinaryUnParser
+class ClassAdBinaryParser
+{
+ public:
+	/// Constructor
+	ClassAdBinaryParser( );
+
+	/// Destructor
+	virtual ~ClassAdBinaryParser( );
+
+	/** Parse an expression.
+		@param buf The encoded expression
+		@param len The length of buf
+		@param used Set to the number of bytes of buf that were read
+		@return The expression, or NULL if buf is not a valid encoding
+	*/
+	ExprTree *ParseExpression( const char *buf, size_t len, size_t *used = NULL );
+
+	/** Parse a ClassAd's attributes and insert them into the given ad.
+		Attributes already in the ad are kept unless they are replaced.
+		@return false if buf is not a valid encoding; the ad may then
+			hold some of the attributes
+	*/
+	bool ParseClassAd( const char *buf, size_t len, ClassAd &ad, size_t *used = NULL );
+
+	/// Forget the name table
+	void Reset( );
+
+ protected:
+	ExprTree *ParseAux( int depth );
+	bool ParseAttrs( ClassAd &ad, int depth );
+	bool GetVarint( unsigned long long &val );
+	bool GetName( std::string &name );
+	bool GetBytes( std::string &str );
+	bool Get64( unsigned long long &bits );
+
+	const unsigned char *m_pos;
+	const unsigned char *m_end;
+	std::vector<std::string> m_names;
+};
+
+} // classad
+
+#endif//__CLASSAD_BINARY_SOURCE_H__
@@ -27,6 +27,7 @@
 #include <vector>
 #include "classad/classad_containers.h"
 #include "classad/exprTree.h"
+#include "classad/attrList.h"
 
 namespace classad {
 
@@ -38,7 +39,6 @@ typedef std::map<const ClassAd*, References> PortReferences;
 #include "classad/rectangle.h"
 #endif
 
-typedef classad_unordered<std::string, ExprTree*, ClassadAttrNameHash, CaseIgnEqStr> AttrList;
 typedef std::set<std::string, CaseIgnLTStr> DirtyAttrList;
 
 void ClassAdLibraryVersion(int &major, int &minor, int &patch);
@@ -49,6 +49,29 @@ void ClassAdLibraryVersion(std::string &version_string);
 void ClassAdSetExpressionCaching(bool do_caching);
 bool ClassAdGetExpressionCaching();
 
+// Operator expressions that are evaluated this many times are compiled
+// to a flat form that evaluates faster (see CompiledExpr).
+// The default is 0, which turns compiling off.
+void ClassAdSetCompileThreshold(int evaluations);
+int ClassAdGetCompileThreshold();
+
+// Patterns compiled for regexp() and the other regular expression
+// functions are kept, with their options, in a cache of this many
+// patterns shared by all threads, so a constant pattern is compiled
+// once rather than on every evaluation.  The least recently used pattern
+// is dropped when the cache is full.  The default is 0, which turns the
+// cache off.
+void ClassAdSetRegexCacheSize(int patterns);
+int ClassAdGetRegexCacheSize();
+
+// Whether patterns in the cache are also compiled to machine code, when
+// the regular expression library can do that.  The default is false.
+void ClassAdSetRegexJIT(bool jit);
+
+// The number of times a pattern was found in the cache, and the number
+// of times it had to be compiled, since the process started.
+void ClassAdGetRegexCacheStats(unsigned long &hits, unsigned long &misses);
+
 // This flag is only meant for use in Condor, which is transitioning
 // from an older version of ClassAds with slightly different evaluation
 // semantics. It will be removed without warning in a future release.
@@ -355,7 +378,9 @@ class ClassAd : public ExprTree
 		  		deleted from the classad.
 			@param attrName The name of the attribute to be extricated.
 			@return The expression tree of the named attribute, or NULL if
-				the attribute could not be found.
+				the attribute could not be found.  If the attribute is
+				in the chained parent ad, a copy of the parent's is
+				returned, and the attribute is set to undefined here.
 			@see Delete
 		*/
 		ExprTree *Remove( const std::string &attrName );
@@ -638,6 +663,7 @@ class ClassAd : public ExprTree
 		ClassAd &operator=(ClassAd &&rhs) {
 			this->do_dirty_tracking = rhs.do_dirty_tracking;
 			this->chained_parent_ad = rhs.chained_parent_ad;
+			this->chained_parent_ref = rhs.chained_parent_ref;
 			this->alternateScope = rhs.alternateScope;
 
 			this->dirtyAttrList = std::move(rhs.dirtyAttrList);
@@ -729,6 +755,19 @@ class ClassAd : public ExprTree
          *  @param new_chain_parent_ad the parent ad we are chained too.
          */
 	    void		ChainToAd(ClassAd *new_chain_parent_ad);
+
+		/** Chain this ad to a parent that it shares with other ads, as a
+		 *  cheap copy of the parent that is only copied on write.  Like
+		 *  ChainToAd(), but this ad also holds a reference to the parent,
+		 *  so the parent lives for as long as any ad chained to it this
+		 *  way.  Changes to this ad are kept in this ad: an attribute
+		 *  inserted here hides the parent's, and one deleted here is
+		 *  set to undefined here.  The parent must not change while it
+		 *  is shared; if it does not, any number of threads may read
+		 *  and change their own ads chained to it at the same time.
+		 *  @param new_chain_parent_ad the parent ad we are chained to.
+		 */
+		void		ChainToSharedAd(const classad_shared_ptr<ClassAd> &new_chain_parent_ad);
 		
 		/** If there is a chained parent remove redundant entries.
 		 */
@@ -744,6 +783,12 @@ class ClassAd : public ExprTree
          */
 		void		Unchain(void);
 
+		/** If we are chained to a parent ad, copy the attributes of the
+		 *  parent that are not set in this ad into it, then remove the
+		 *  chain, so this ad stands on its own.
+		 */
+		void		ChainCollapse(void);
+
 		/** Return a pointer to the parent ad.
 		 */
 		ClassAd *   GetChainedParentAd(void);
@@ -828,6 +873,7 @@ class ClassAd : public ExprTree
 
   	private:
 		friend 	class AttributeReference;
+		friend 	class BatchEval;
 		friend 	class ExprTree;
 		friend 	class EvalState;
 		friend 	class ClassAdIterator;
@@ -853,11 +899,14 @@ class ClassAd : public ExprTree
 		virtual bool _Evaluate( EvalState&, Value&, ExprTree*& ) const;
 		virtual bool _Flatten( EvalState&, Value&, ExprTree*&, int* ) const;
 	
-		int LookupInScope( const std::string&, ExprTree*&, EvalState& ) const;
+		int LookupInScope( const std::string&, ExprTree*&, EvalState&,
+			const AttrName *atom = NULL ) const;
+		ExprTree *_Lookup( const AttrName *atom ) const;
 		AttrList	  attrList;
 		DirtyAttrList dirtyAttrList;
 		bool          do_dirty_tracking;
 		ClassAd       *chained_parent_ad;
+		classad_shared_ptr<ClassAd> chained_parent_ref;	// if chained by ChainToSharedAd()
 		const ClassAd *parentScope;
 };
 
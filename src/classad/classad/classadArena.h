@@ -0,0 +1,132 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_ARENA_H__
+#define __CLASSAD_ARENA_H__
+
+#include <stddef.h>
+#include <vector>
+#include <atomic>
+
+namespace classad {
+
+/** A region that the expression nodes of a batch of parsed ClassAds,
+	including the ClassAds themselves, are allocated from instead of one
+	by one from the heap.  Deleting a node from an arena only counts it;
+	the arena goes back to the heap in one shot once all of its nodes
+	are deleted.  So a node that outlives the rest of its batch keeps
+	the whole arena, and arenas suit batches of ads that are thrown away
+	together, like the results of a query.
+
+	Only parsing uses an arena: the nodes made by evaluating or copying
+	ads always come from the heap.
+*/
+class ClassAdArena
+{
+	public:
+		/** While a Batch exists, the ClassAds parsed by the thread that
+			made it, by ClassAdParser or getClassAd(), come from one
+			arena.  Batches nest.
+		*/
+		class Batch {
+			public:
+				/** @param cache_in_arena Also take expressions that go into
+						the expression cache from the arena.  They may be
+						shared with ads parsed later, which then keep the
+						arena; so this is only for batches that are kept
+						as long as the process runs anyway.
+				*/
+				Batch( bool cache_in_arena = false );
+				~Batch( );
+
+				/// The arena, for its statistics
+				const ClassAdArena &Arena( ) const { return *arena; }
+
+			private:
+				Batch( const Batch & );
+				Batch &operator=( const Batch & );
+
+				ClassAdArena	*arena;
+				Batch			*outer;
+				bool			cache_in_arena;
+
+				friend class ClassAdArena;
+		};
+
+		/** While a Parsing exists, the nodes made by this thread come from
+			the arena of the current Batch, if there is one.  Made by the
+			parsers.  Inside another Parsing, one for cached nodes can move
+			them to the heap, and otherwise it changes nothing.
+		*/
+		class Parsing {
+			public:
+				/** @param cached Whether the nodes made will go into the
+						expression cache
+				*/
+				Parsing( bool cached = false );
+				~Parsing( );
+
+			private:
+				Parsing( const Parsing & );
+				Parsing &operator=( const Parsing & );
+
+				ClassAdArena	*outer;
+				bool			nested;
+		};
+
+		/// The number of nodes allocated from the arena
+		size_t Allocations( ) const { return allocations; }
+
+		/// The number of blocks the arena took from the heap
+		size_t Blocks( ) const { return blocks.size( ); }
+
+		/// The number of bytes in those blocks
+		size_t Bytes( ) const { return bytes; }
+
+		/** Allocate memory for a node, from the current arena or the heap.
+			Used by ExprTree::operator new().
+		*/
+		static void *Allocate( size_t size );
+
+		/// Free memory from Allocate().
+		static void Free( void *ptr );
+
+	private:
+		ClassAdArena( );
+		~ClassAdArena( );
+		ClassAdArena( const ClassAdArena & );
+		ClassAdArena &operator=( const ClassAdArena & );
+
+		void *allocate( size_t size );
+		void release( );
+
+		std::vector<char *>	blocks;
+		char				*next;
+		char				*limit;
+		size_t				block_size;
+		size_t				allocations;
+		size_t				bytes;
+			// nodes not yet deleted, plus one while the batch lasts
+		std::atomic<size_t>	live;
+};
+
+} // classad
+
+#endif//__CLASSAD_ARENA_H__
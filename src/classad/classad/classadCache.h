@@ -53,7 +53,7 @@ typedef classad_shared_ptr< CacheEntry > pCacheData;
 class CachedExprEnvelope : public ExprTree
 {
 public:
-	virtual ~CachedExprEnvelope() {} // nothing to do counted pointer and cache entry do all of the work.
+	virtual ~CachedExprEnvelope(); // counted pointer and cache entry do all of the work.
 
 	/// node type
 	virtual NodeKind GetKind (void) const { return EXPR_ENVELOPE; }
@@ -81,6 +81,12 @@ public:
 	static bool _debug_dump_keys(const std::string & szFile);
 	static void _debug_print_stats(FILE* fp);
 	static bool _debug_get_counts(unsigned long &hits, unsigned long &misses, unsigned long &querys, unsigned long &hitdels, unsigned long &removals, unsigned long &unparse);
+	/**
+	 * how many distinct values are in the cache, and how many
+	 * expressions in all of the ads refer to them.  Both are kept
+	 * as running counts, so this is cheap enough to publish often.
+	 */
+	static bool _debug_get_usage(unsigned long &values, unsigned long &uses);
 	
 	ExprTree * get() const;
 	const std::string & get_unparsed_str() const;
@@ -90,7 +96,7 @@ public:
 protected:
 	
 	virtual void _SetParentScope( const ClassAd* parent) { parentScope = parent; }
-	CachedExprEnvelope() : parentScope(NULL) {;};
+	CachedExprEnvelope();
 	
 	/**
 	 * SameAs() - determines if two elements are the same.
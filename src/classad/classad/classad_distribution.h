@@ -23,12 +23,17 @@
 
 #include "classad/common.h"
 #include "classad/classad.h"
+#include "classad/batchEval.h"
+#include "classad/classadArena.h"
+#include "classad/evalProfile.h"
 #include "classad/source.h"
 #include "classad/sink.h"
 #include "classad/xmlSource.h"
 #include "classad/xmlSink.h"
 #include "classad/jsonSource.h"
 #include "classad/jsonSink.h"
+#include "classad/binarySource.h"
+#include "classad/binarySink.h"
 #include "classad/matchClassad.h"
 #include "classad/collection.h"
 #include "classad/collectionBase.h"
@@ -0,0 +1,108 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_COMPILED_EXPR_H__
+#define __CLASSAD_COMPILED_EXPR_H__
+
+#include "classad/exprTree.h"
+#include <vector>
+
+namespace classad {
+
+/** A flat form of an operator expression that evaluates faster than
+	walking the tree.  The operators are laid out as a list of
+	instructions working on a stack of values, with jumps for &&, ||
+	and ?:, and any part of the tree made only of literals and
+	operators is evaluated once, when compiled.  Attribute references,
+	function calls, lists and nested ads are left to the nodes of the
+	tree, so the compiled form must not outlive the tree.  Evaluation
+	gives the same result as evaluating the tree.
+	@see ClassAdSetCompileThreshold
+*/
+class CompiledExpr
+{
+	public:
+		/** Compile an expression.
+			@param tree The expression; it must not change while the
+				compiled form is in use.
+			@return The compiled form, or NULL if the expression is
+				not an operator expression.
+		*/
+		static CompiledExpr *Compile( const ExprTree *tree );
+
+		/** Evaluate the compiled expression, as ExprTree::Evaluate()
+				would evaluate the tree.
+			@param state The current state
+			@param val The result of the evaluation
+			@return true on success, false on failure
+		*/
+		bool Evaluate( EvalState &state, Value &val ) const;
+
+		/// The number of instructions
+		size_t size( ) const { return code.size(); }
+
+		/** Constants are evaluated under the old or new ClassAd semantics
+			in use when compiled; the compiled form should not be used
+			under the other ones.
+			@return true if compiled under the old semantics
+		*/
+		bool OldSemantics( ) const { return old_semantics; }
+
+	private:
+		enum OpCode {
+			PUSH_CONST,		// push consts[arg]
+			EVAL_TREE,		// evaluate tree and push the result
+			EVAL_OP,		// same, for an operator not compiled
+			UNARY_OP,		// replace the top value with op applied to it
+			BINARY_OP,		// replace the top two values with op applied
+			AND_JUMP,		// if the top is false, make it false and jump
+			OR_JUMP,		// if the top is true, make it true and jump
+			TERNARY_JUMP,	// pop the selector and pick a branch, see Compile
+			TERNARY_OTHER,	// the selector is not boolean
+			JUMP
+		};
+
+		struct Instruction {
+			OpCode code;
+			Operation::OpKind op;
+			int arg;		// constant index or jump target
+			int arg2;		// second jump target for TERNARY_JUMP
+			const ExprTree *tree;
+			const ExprTree *tree2;
+		};
+
+		CompiledExpr( ) : max_depth(0), fold(true), old_semantics(_useOldClassAdSemantics) {}
+
+		void compile( const ExprTree *tree, int &depth );
+		bool isConstant( const ExprTree *tree ) const;
+		int emit( OpCode code, Operation::OpKind op = Operation::__NO_OP__,
+				const ExprTree *tree = NULL, const ExprTree *tree2 = NULL );
+		void push( int &depth );
+
+		std::vector<Instruction> code;
+		std::vector<Value> consts;
+		int max_depth;
+		bool fold;			// evaluate constant parts when compiling
+		bool old_semantics;
+};
+
+} // classad
+
+#endif//__CLASSAD_COMPILED_EXPR_H__
@@ -0,0 +1,97 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef __CLASSAD_EVAL_PROFILE_H__
+#define __CLASSAD_EVAL_PROFILE_H__
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+
+namespace classad {
+
+class ClassAd;
+
+/** Counts of how often, and for how long, the attributes of ClassAds and
+	the builtin functions are evaluated, to find the expressions that use
+	the most time.  Attributes are counted by name and by the MyType of
+	the ad they are in.  The time of an attribute or function includes
+	the time of what it evaluates in turn, so an expression that refers
+	to others is charged for them as well.
+
+	Counting is off until turned on with Enable(); the counts are kept for
+	the whole process and shared by all threads.
+*/
+class EvalProfile
+{
+	public:
+		/// The counts for one attribute of one type of ad, or one function
+		struct Entry {
+			std::string		name;
+			std::string		ad_type;	// empty for functions
+			unsigned long	count;
+			double			seconds;
+		};
+
+		/// Turn counting on or off.  Turning it on starts over.
+		static void Enable( bool enable );
+
+		/** Whether evaluations are being counted.  Checked before every
+			evaluation from any thread, so it is a relaxed load; an
+			evaluation that races with Enable() may or may not be counted.
+		*/
+		static bool Enabled( ) { return enabled.load( std::memory_order_relaxed ); }
+
+		/// The attributes counted so far, most time first
+		static void GetAttributes( std::vector<Entry> &entries );
+
+		/// The functions counted so far, most time first
+		static void GetFunctions( std::vector<Entry> &entries );
+
+		/// Forget the counts so far
+		static void Reset( );
+
+		/** Times one evaluation.  Only made when counting is on, since
+			reading the clock costs more than many evaluations.
+		*/
+		class Timer {
+			public:
+				Timer( ) : start( std::chrono::steady_clock::now( ) ) {}
+				double Seconds( ) const {
+					return std::chrono::duration<double>( std::chrono::steady_clock::now( ) - start ).count( );
+				}
+			private:
+				std::chrono::steady_clock::time_point	start;
+		};
+
+		/// Count an evaluation of an attribute of the given ad
+		static void CountAttribute( const std::string &name, const ClassAd *ad, double seconds );
+
+		/// Count an evaluation of a builtin function
+		static void CountFunction( const std::string &name, double seconds );
+
+	private:
+		static std::atomic<bool>	enabled;
+};
+
+} // classad
+
+#endif//__CLASSAD_EVAL_PROFILE_H__
@@ -95,6 +95,15 @@ class ExprTree
 		/// Virtual destructor
 		virtual ~ExprTree () {};
 
+		/** Nodes are allocated by ClassAdArena, which takes them from an
+			arena while a batch of ads is being parsed.
+			@see ClassAdArena
+		*/
+		static void *operator new( size_t size );
+		static void operator delete( void *ptr );
+		static void *operator new( size_t, void *where ) { return where; }
+		static void operator delete( void *, void * ) { }
+
 		/** Sets the lexical parent scope of the expression, which is used to 
 				determine the lexical scoping structure for resolving attribute
 				references. (However, the semantic parent may be different from 
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <vector>
+#include <memory>
 #include "classad/classad.h"
 
 namespace classad {
@@ -223,6 +224,34 @@ class FunctionCall : public ExprTree
  	//static bool doReal(const char*,const ArgumentList&,EvalState&,Value&);
 };
 
+struct CompiledRegex;
+
+/** A regular expression, compiled once as the regexp() function would
+ *  compile it, for matching against many strings.  The compiled pattern
+ *  comes from the same cache that regexp() uses.
+ */
+class RegexpMatcher
+{
+ public:
+	/** @param pattern The regular expression
+	 *  @param options The option letters that regexp() takes, like "i"
+	 */
+	RegexpMatcher( const char *pattern, const std::string &options );
+
+	/// False if the pattern is not a valid regular expression
+	bool Valid( ) const;
+
+	/** Match a string against the pattern, as regexp() does.
+	 *  @param target The string to match
+	 *  @param result Set to whether the string matched, or to error if
+	 *		the pattern is not valid
+	 */
+	void Match( const char *target, Value &result ) const;
+
+ private:
+	std::shared_ptr<const CompiledRegex> regex;
+};
+
 } // classad
 
 #endif//__CLASSAD_FN_CALL_H__
@@ -227,6 +227,8 @@ class Lexer
 
 		// internal lexing functions
 		void 		wind(bool fetch = true);	// consume character from source
+		void		windRun(size_t count);		// consume character and the
+												// next count from the buffer
 		void 		mark(void);					// mark()s beginning of a token
 		void 		cut(void);					// delimits token
 		void		fetch();					// fetch next character if ch is empty
@@ -40,6 +40,7 @@ class LexerSource
 {
 public:
 	LexerSource()
+		: _buffer(NULL), _offset(0)
 	{
 		return;
 	}
@@ -51,6 +52,33 @@ public:
 	// Reads a single character from the source
 	virtual int ReadCharacter(void) = 0;
 
+	// Sources that hold all of their characters in memory set _buffer
+	// to them, up to a NUL, and keep _offset at the next one to read.
+	// The lexer then reads and scans the buffer directly instead of
+	// making a virtual call for every character.
+	const char *Buffer(void) const { return _buffer; }
+	int Position(void) const { return _offset; }
+	void Skip(int count) { _offset += count; }
+
+	// Same as ReadCharacter(), but straight from the buffer if there is one
+	int NextCharacter(void)
+	{
+		if ( ! _buffer) {
+			return ReadCharacter();
+		}
+		int character = (unsigned char)_buffer[_offset];
+		if (character == 0 && Refill()) {
+			character = (unsigned char)_buffer[_offset];
+		}
+		if (character == 0) {
+			character = EOF;
+		} else {
+			_offset++;
+		}
+		_previous_character = character;
+		return character;
+	}
+
 	// Returns the last character read (from ReadCharacter()) from the
 	// source
 	virtual int ReadPreviousCharacter(void) { return _previous_character; };
@@ -63,7 +91,14 @@ public:
 	virtual void UnreadCharacter(void) = 0;
 	virtual bool AtEnd(void) const = 0;
 protected:
+	// Called by NextCharacter() at the NUL that ends the buffer, for
+	// sources that read their characters a chunk at a time.  Returns
+	// true if the buffer now holds more characters at _offset.
+	virtual bool Refill(void) { return false; }
+
 	int _previous_character;
+	const char *_buffer;
+	int         _offset;
 private:
     // The copy constructor and assignment operator are defined
     // to be private so we don't have to write them, or worry about
@@ -107,12 +142,12 @@ public:
 	virtual int GetCurrentLocation(void) const;
 private:
 	const char *_string;
-	int         _offset;
     CharLexerSource(const CharLexerSource &) : LexerSource() { return;       }
     CharLexerSource &operator=(const CharLexerSource &) { return *this; }
 };
 
-// This source allows input from a C++ string.
+// This source allows input from a C++ string, which must not change
+// while it is being read.
 class StringLexerSource : public LexerSource
 {
 public:
@@ -128,11 +163,90 @@ public:
 	virtual int GetCurrentLocation(void) const;
 private:
 	const std::string *_string;
-	int                _offset;
     StringLexerSource(const StringLexerSource &) : LexerSource() { return;       }
     StringLexerSource &operator=(const StringLexerSource &) { return *this; }
 };
 
+// This source reads its input a chunk at a time, so that a stream of
+// any length can be parsed without holding all of it in memory.  The
+// current chunk is the buffer, so the lexer scans it directly.  The
+// last character of the previous chunk is kept in front of the next
+// one, so a character can still be put back after a refill.
+class ChunkedLexerSource : public LexerSource
+{
+public:
+	static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	ChunkedLexerSource(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	virtual ~ChunkedLexerSource();
+
+	virtual int ReadCharacter(void);
+	virtual void UnreadCharacter(void);
+	virtual bool AtEnd(void) const;
+
+	// True if reading stopped because of an error, not at the end
+	bool Failed(void) const { return _failed; }
+
+protected:
+	// Reads up to size characters into buf. Returns the number read,
+	// 0 at the end of the input, or -1 on an error.
+	virtual long ReadChunk(char *buf, size_t size) = 0;
+	virtual bool Refill(void);
+
+	// Forgets what has been read, to start on a new input
+	void Reset(void);
+
+private:
+	char   *_chunk;
+	size_t  _chunk_size;
+	int     _length;	// offset of the NUL after the characters read
+	bool    _ended;
+	bool    _failed;
+    ChunkedLexerSource(const ChunkedLexerSource &) : LexerSource() { return;  }
+    ChunkedLexerSource &operator=(const ChunkedLexerSource &) { return *this; }
+};
+
+// This source reads from a file descriptor, such as a pipe or a socket,
+// a chunk at a time.
+class FileDescriptorLexerSource : public ChunkedLexerSource
+{
+public:
+	FileDescriptorLexerSource(int fd, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	virtual ~FileDescriptorLexerSource();
+
+	virtual void SetNewSource(int fd);
+
+protected:
+	virtual long ReadChunk(char *buf, size_t size);
+
+private:
+	int _fd;
+    FileDescriptorLexerSource(const FileDescriptorLexerSource &) : ChunkedLexerSource() { return;  }
+    FileDescriptorLexerSource &operator=(const FileDescriptorLexerSource &) { return *this; }
+};
+
+// Like FileLexerSource, but reads the FILE a chunk at a time instead of
+// calling fgetc() for every character. Because it reads ahead, the same
+// source must be used to parse one ad after another, and nothing else
+// should read from the FILE while it is in use.
+class BufferedFileLexerSource : public ChunkedLexerSource
+{
+public:
+	BufferedFileLexerSource(FILE *file, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	virtual ~BufferedFileLexerSource();
+
+	virtual void SetNewSource(FILE *file);
+	FILE *GetSource(void) const { return _file; }
+
+protected:
+	virtual long ReadChunk(char *buf, size_t size);
+
+private:
+	FILE *_file;
+    BufferedFileLexerSource(const BufferedFileLexerSource &) : ChunkedLexerSource() { return;  }
+    BufferedFileLexerSource &operator=(const BufferedFileLexerSource &) { return *this; }
+};
+
 }
 
 #endif /* __CLASSAD_LEXER_SOURCE_H__ */
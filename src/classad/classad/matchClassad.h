@@ -165,11 +165,13 @@ class MatchClassAd : public ClassAd
 		void SetLeftAlias( const std::string &name );
 		void SetRightAlias( const std::string &name );
 
-		/** Modifies the requirements expression in the given ad to
-			make matchmaking more efficient.  This will only improve
-			efficiency if it is called once and then the resulting
-			requirements are used multiple times.  Saves the old
-			requirements expression so it can be restored via
+		/** Modifies the requirements and rank expressions in the given
+			ad to make matchmaking more efficient, by flattening them
+			against the ad so that only the parts that depend on the other
+			ad are left to evaluate for each candidate.  This will only
+			improve efficiency if it is called once and then the resulting
+			expressions are used multiple times.  Saves the old
+			expressions so they can be restored via
 			UnoptimizeAdForMatchmaking.
 			@param ad The ad to be optimized.
 			@param error_msg non-NULL if an error description is desired.
@@ -177,11 +179,13 @@ class MatchClassAd : public ClassAd
 		*/
 		static bool OptimizeRightAdForMatchmaking( ClassAd *ad, std::string *error_msg, const std::string &left_alias = "", const std::string &right_alias = "" );
 
-		/** Modifies the requirements expression in the given ad to
-			make matchmaking more efficient.  This will only improve
-			efficiency if it is called once and then the resulting
-			requirements are used multiple times.  Saves the old
-			requirements expression so it can be restored via
+		/** Modifies the requirements and rank expressions in the given
+			ad to make matchmaking more efficient, by flattening them
+			against the ad so that only the parts that depend on the other
+			ad are left to evaluate for each candidate.  This will only
+			improve efficiency if it is called once and then the resulting
+			expressions are used multiple times.  Saves the old
+			expressions so they can be restored via
 			UnoptimizeAdForMatchmaking.
 			@param ad The ad to be optimized.
 			@param error_msg non-NULL if an error description is desired.
@@ -190,6 +194,8 @@ class MatchClassAd : public ClassAd
 		static bool OptimizeLeftAdForMatchmaking( ClassAd *ad, std::string *error_msg, const std::string &left_alias = "", const std::string &right_alias = "" );
 
 		/** Restores ad previously optimized with OptimizeAdForMatchmaking.
+			An ad chained to an optimized parent is first collapsed
+			into a plain ad; the parent is not changed.
 			@param ad The ad to be unoptimized.
 			@return True on success.
 		*/
@@ -209,11 +215,13 @@ class MatchClassAd : public ClassAd
         MatchClassAd(const MatchClassAd &) : ClassAd(){ return;       }
         MatchClassAd &operator=(const MatchClassAd &) { return *this; }
 
-		/** Modifies the requirements expression in the given ad to
-			make matchmaking more efficient.  This will only improve
-			efficiency if it is called once and then the resulting
-			requirements are used multiple times.  Saves the old
-			requirements expression so it can be restored via
+		/** Modifies the requirements and rank expressions in the given
+			ad to make matchmaking more efficient, by flattening them
+			against the ad so that only the parts that depend on the other
+			ad are left to evaluate for each candidate.  This will only
+			improve efficiency if it is called once and then the resulting
+			expressions are used multiple times.  Saves the old
+			expressions so they can be restored via
 			UnoptimizeAdForMatchmaking.
 			@param ad The ad to be optimized.
 			@param is_right True if this ad will be the right ad.
@@ -222,6 +230,12 @@ class MatchClassAd : public ClassAd
 		*/
 		static bool OptimizeAdForMatchmaking( ClassAd *ad, bool is_right, std::string *error_msg, const std::string &left_alias, const std::string &right_alias );
 
+		/** Replaces an expression in the given ad with its flattened
+			form, saving the original under another name.
+			@return False if the ad was left without the expression.
+		*/
+		static bool FlattenForMatchmaking( ClassAd *ad, const char *name, const char *saved_name, std::string *error_msg );
+
 		/**
 		   @return true if the given expression evaluates to true
 		*/
@@ -22,9 +22,12 @@
 #define __CLASSAD_OPERATORS_H__
 
 #include "classad/exprTree.h"
+#include <atomic>
 
 namespace classad {
 
+class CompiledExpr;
+
 /** Represents a node of the expression tree which is an operation applied to
 	expression operands, like 3 + 2
 */
@@ -175,7 +178,7 @@ class Operation : public ExprTree
 
 	protected:
 		/// Constructor
-		Operation() : parentScope(NULL) {};
+		Operation() : parentScope(NULL), compiled(NULL), evaluations(0) {};
 
   	private:
         static bool SameChild(const ExprTree *tree1, const ExprTree *tree2);
@@ -186,6 +189,12 @@ class Operation : public ExprTree
 		virtual bool _Evaluate( EvalState &, Value &, ExprTree*& ) const;
 		virtual bool _Flatten( EvalState&, Value&, ExprTree*&, int* ) const;
 
+			// evaluate by walking the tree, never the compiled form
+		bool evaluateTree( EvalState &, Value & ) const;
+			// the compiled form, compiling it if this has been evaluated
+			// often enough; NULL if it should not be used
+		const CompiledExpr *compiledForm( ) const;
+
 			// returns true if result is determined for this operation
 			// based on the evaluated arg1
 		bool shortCircuit( EvalState &state, Value const &arg1, Value &result ) const;
@@ -218,9 +227,14 @@ class Operation : public ExprTree
 
 		const ClassAd *parentScope;
 
-		// No Operation-specific data members.
+			// see ClassAdSetCompileThreshold()
+		mutable std::atomic<CompiledExpr*> compiled;
+		mutable std::atomic<int> evaluations;
+
+		// No other Operation-specific data members.
 		// Everything is in child classes
 
+		friend class CompiledExpr;
 		friend class Operation1;
 		friend class OperationParens;
 		friend class Operation2;
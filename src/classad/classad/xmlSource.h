@@ -40,6 +40,11 @@ class ClassAdXMLParser
 		bool ParseClassAd(const std::string &buffer, ClassAd &ad);
 		bool ParseClassAd(FILE *file, ClassAd &ad);
 		bool ParseClassAd(std::istream& stream, ClassAd &ad);
+
+		// Parse from a source that the caller keeps from one ad to
+		// the next, such as a ChunkedLexerSource
+		ClassAd *ParseClassAd(LexerSource *lexer_source);
+		bool ParseClassAd(LexerSource *lexer_source, ClassAd &ad);
 	private:
         // The copy constructor and assignment operator are defined
         // to be private so we don't have to write them, or worry about
@@ -0,0 +1,161 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/classadArena.h"
+#include <new>
+
+namespace classad {
+
+	// the first block of an arena, and the most any block grows to
+static const size_t FIRST_BLOCK_SIZE = 4096;
+static const size_t MAX_BLOCK_SIZE = 256*1024;
+
+	// nodes bigger than this come from the heap
+static const size_t MAX_ARENA_NODE = 1024;
+
+	// every node is preceded by the arena it came from, or NULL if it
+	// came from the heap; the other members keep the node aligned
+union NodeHeader {
+	ClassAdArena	*arena;
+	double			d;
+	long long		ll;
+	void			*p;
+};
+
+static thread_local ClassAdArena::Batch *currentBatch = NULL;
+static thread_local ClassAdArena *currentArena = NULL;
+static thread_local bool parsing = false;
+
+ClassAdArena::Batch::
+Batch( bool cache_in_arena_ )
+	: arena( new ClassAdArena ), outer( currentBatch ), cache_in_arena( cache_in_arena_ )
+{
+	currentBatch = this;
+}
+
+ClassAdArena::Batch::
+~Batch( )
+{
+	currentBatch = outer;
+	arena->release( );
+}
+
+ClassAdArena::Parsing::
+Parsing( bool cached )
+	: outer( currentArena ), nested( parsing )
+{
+	Batch *batch = currentBatch;
+	if( nested ) {
+		if( cached && batch && !batch->cache_in_arena ) {
+			currentArena = NULL;
+		}
+		return;
+	}
+	if( batch && ( !cached || batch->cache_in_arena ) ) {
+		currentArena = batch->arena;
+	} else {
+		currentArena = NULL;
+	}
+	parsing = true;
+}
+
+ClassAdArena::Parsing::
+~Parsing( )
+{
+	currentArena = outer;
+	parsing = nested;
+}
+
+ClassAdArena::
+ClassAdArena( )
+	: next( NULL ), limit( NULL ), block_size( 0 ), allocations( 0 ), bytes( 0 ), live( 1 )
+{
+}
+
+ClassAdArena::
+~ClassAdArena( )
+{
+	for( size_t ii = 0; ii < blocks.size( ); ii++ ) {
+		delete [] blocks[ii];
+	}
+}
+
+void *ClassAdArena::
+Allocate( size_t size )
+{
+	size_t total = sizeof( NodeHeader ) + size;
+	ClassAdArena *arena = currentArena;
+	NodeHeader *header;
+	if( arena && total <= MAX_ARENA_NODE ) {
+		header = (NodeHeader *)arena->allocate( total );
+	} else {
+		header = (NodeHeader *)::operator new( total );
+		arena = NULL;
+	}
+	header->arena = arena;
+	return header + 1;
+}
+
+void ClassAdArena::
+Free( void *ptr )
+{
+	if( !ptr ) {
+		return;
+	}
+	NodeHeader *header = (NodeHeader *)ptr - 1;
+	if( header->arena ) {
+		header->arena->release( );
+	} else {
+		::operator delete( header );
+	}
+}
+
+void *ClassAdArena::
+allocate( size_t size )
+{
+	size = ( size + sizeof( NodeHeader ) - 1 ) / sizeof( NodeHeader ) * sizeof( NodeHeader );
+	if( (size_t)( limit - next ) < size ) {
+		block_size = block_size ? block_size * 2 : FIRST_BLOCK_SIZE;
+		if( block_size > MAX_BLOCK_SIZE ) {
+			block_size = MAX_BLOCK_SIZE;
+		}
+		char *block = new char[block_size];
+		blocks.push_back( block );
+		bytes += block_size;
+		next = block;
+		limit = block + block_size;
+	}
+	char *ptr = next;
+	next += size;
+	allocations++;
+	live.fetch_add( 1, std::memory_order_relaxed );
+	return ptr;
+}
+
+void ClassAdArena::
+release( )
+{
+	if( live.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+		delete this;
+	}
+}
+
+} // classad
@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <list>
+#include <atomic>
 
 using namespace classad;
 using namespace std;
@@ -51,6 +52,7 @@ protected:
 	unsigned long m_HitDelete;	///< Hits that freed the incoming expr tree
 	unsigned long m_RemovalCount;	///< Useful to see churn
 	unsigned long m_UnparseCount; ///< number of times we had to unparse a tree to populate the cache.
+	unsigned long m_ValueCount;	///< values now in the cache; main thread only, like m_Cache
 	bool          m_destroyed;
 	
 public:
@@ -61,6 +63,7 @@ public:
 	, m_HitDelete(0)
 	, m_RemovalCount(0)
 	, m_UnparseCount(0)
+	, m_ValueCount(0)
 	, m_destroyed(false)
 	{ 
 	};
@@ -130,6 +133,7 @@ public:
 			}
 
 			m_MissCount++;
+			m_ValueCount++;
 		} else {
 			m_QueryCount++;
 		}
@@ -166,6 +170,7 @@ public:
 
 		// if we got here we missed
 		m_MissCount++;
+		m_ValueCount++;
 		pRet.reset( new CacheEntry(szName,szValue,NULL) );
 
 		if (bValidName) {
@@ -195,6 +200,7 @@ public:
 			}
 
 			m_RemovalCount++;
+			m_ValueCount--;
 			return (true);
 		}
 
@@ -318,6 +324,8 @@ public:
 		fprintf( fp, "Hits:%lu (%.2f%%) Misses: %lu (%.2f%%) Querys: %lu\n", m_HitCount,dHitRatio,m_MissCount,dMissRatio,m_QueryCount ); 
 	};
 
+	unsigned long get_value_count() const { return m_ValueCount; }
+
 	void get_counts(unsigned long &hits, unsigned long &misses, unsigned long &querys, unsigned long & hitdels, unsigned long &removals, unsigned long &unparse) {
 		hits = m_HitCount;
 		misses = m_MissCount;
@@ -330,6 +338,10 @@ public:
 
 
 static classad_shared_ptr<ClassAdCache> _cache;
+// the number of envelopes, each of which is one use of a cached value.
+// envelopes are copied and deleted along with ads, which the match pool
+// threads can do, so this is atomic.
+static std::atomic<unsigned long> _envelope_count( 0 );
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -347,6 +359,16 @@ CacheEntry::~CacheEntry()
 }
 
 
+CachedExprEnvelope::CachedExprEnvelope() : parentScope(NULL)
+{
+	_envelope_count.fetch_add( 1, std::memory_order_relaxed );
+}
+
+CachedExprEnvelope::~CachedExprEnvelope()
+{
+	_envelope_count.fetch_sub( 1, std::memory_order_relaxed );
+}
+
 #ifdef HAVE_COW_STRING
 ExprTree * CachedExprEnvelope::cache (std::string & pName, ExprTree * pTree, const std::string & szValue)
 #else
@@ -407,6 +429,14 @@ bool CachedExprEnvelope::_debug_get_counts(unsigned long &hits, unsigned long &m
 	return true;
 }
 
+bool CachedExprEnvelope::_debug_get_usage(unsigned long &values, unsigned long &uses)
+{
+	if ( ! _cache) return false;
+	values = _cache->get_value_count();
+	uses = _envelope_count.load( std::memory_order_relaxed );
+	return true;
+}
+
 void CachedExprEnvelope::_debug_print_stats(FILE* fp)
 {
   if (_cache) _cache->print_stats(fp);
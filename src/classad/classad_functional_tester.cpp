@@ -159,6 +159,11 @@ void Parameters::ParseCommandLine(
 		} else if (   !strcasecmp(argv[arg_index], "-v")
                    || !strcasecmp(argv[arg_index], "-verbose")) {
 			verbose = true;
+		} else if (   !strcasecmp(argv[arg_index], "-c")
+                   || !strcasecmp(argv[arg_index], "-compile")) {
+			// compile every operator expression the first time it is
+			// evaluated, so the tests run against the compiled forms
+			ClassAdSetCompileThreshold(1);
 		} else {
 			if (input_file == NULL) {
                 interactive = false;
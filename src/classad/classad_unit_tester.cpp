@@ -23,7 +23,6 @@
  * To Do:
  *  - Write test_value()
  *  - Write test_literal()
- *  - Write test_match()
  *  - Write test_operator()
  *  - Extend test_collection() to test much more of the interface
  *  - Extend test_classad() to test much more of the interface
@@ -94,6 +93,7 @@ static void test_parsing(const Parameters &parameters, Results &results);
 static void test_classad(const Parameters &parameters, Results &results);
 static void test_exprlist(const Parameters &parameters, Results &results);
 static void test_value(const Parameters &parameters, Results &results);
+static void test_match(const Parameters &parameters, Results &results);
 static void test_collection(const Parameters &parameters, Results &results);
 static void test_utils(const Parameters &parameters, Results &results);
 static bool check_in_view(ClassAdCollection *collection, string view_name, string classad_name);
@@ -288,6 +288,7 @@ int main(
     if (parameters.check_all || parameters.check_literal) {
     }
     if (parameters.check_all || parameters.check_match) {
+        test_match(parameters, results);
     }
     if (parameters.check_all || parameters.check_operator) {
     }
@@ -314,6 +315,88 @@ int main(
     return have_errors;
 }
 
+/*********************************************************************
+ *
+ * Lexer sources for test_parsing: the same text read a character at a
+ * time, and a few characters at a time, so that the lexer's scans of
+ * an in-memory buffer can be checked against its character-at-a-time
+ * path, and against buffers that end in the middle of a token.
+ *
+ *********************************************************************/
+class CharacterAtATimeLexerSource : public CharLexerSource
+{
+public:
+    CharacterAtATimeLexerSource(const char *text) : CharLexerSource(text)
+    {
+        // without a buffer, the lexer calls ReadCharacter() for each one
+        _buffer = NULL;
+    }
+};
+
+class StringChunkLexerSource : public ChunkedLexerSource
+{
+public:
+    StringChunkLexerSource(const string &text, size_t chunk_size)
+        : ChunkedLexerSource(chunk_size), _text(text), _read(0) {}
+protected:
+    virtual long ReadChunk(char *buf, size_t size)
+    {
+        size_t count = _text.copy(buf, size, _read);
+        _read += count;
+        return (long)count;
+    }
+private:
+    string _text;
+    size_t _read;
+};
+
+    // describe each token the lexer finds in the source, up to the end
+    // or the first error
+static void lex_tokens(LexerSource *source, bool old_syntax, string &tokens)
+{
+    Lexer lexer;
+    Lexer::TokenValue value;
+    Lexer::TokenType type;
+    lexer.Initialize(source);
+    lexer.SetOldClassAdLex(old_syntax);
+    tokens.clear();
+    do {
+        type = lexer.ConsumeToken(&value);
+        tokens += Lexer::strLexToken(type);
+        string str;
+        long long i;
+        double r;
+        bool b;
+        Value::NumberFactor f;
+        char number[64];
+        switch (type) {
+        case Lexer::LEX_IDENTIFIER:
+        case Lexer::LEX_STRING_VALUE:
+            value.GetStringValue(str);
+            tokens += " [" + str + "]";
+            break;
+        case Lexer::LEX_INTEGER_VALUE:
+            value.GetIntValue(i, f);
+            snprintf(number, sizeof(number), " %lld %d", i, (int)f);
+            tokens += number;
+            break;
+        case Lexer::LEX_REAL_VALUE:
+            value.GetRealValue(r, f);
+            snprintf(number, sizeof(number), " %.17g %d", r, (int)f);
+            tokens += number;
+            break;
+        case Lexer::LEX_BOOLEAN_VALUE:
+            value.GetBoolValue(b);
+            tokens += b ? " true" : " false";
+            break;
+        default:
+            break;
+        }
+        tokens += '\n';
+    } while (type != Lexer::LEX_END_OF_INPUT && type != Lexer::LEX_TOKEN_ERROR);
+    lexer.FinishedParse();
+}
+
 /*********************************************************************
  *
  * Function: test_parsing
@@ -357,6 +440,163 @@ static void test_parsing(const Parameters &, Results &results)
 
     tree = parser.ParseExpression("1 * 3 * ;");
     TEST("Bad multiplicative doesn't crash & isn't bogus", tree == NULL);
+
+    // The binary encoding should give back the same ad, and the second
+    // ad should only refer to the names the first one put in the table.
+    ClassAd *ad1 = parser.ParseClassAd(
+        "[ A = 1; B = -7.5; C = \"str\"; D = undefined; E = error; F = 10K;"
+        "  Requirements = (A > 0) && !D && (C =?= \"str\" ? B : -B);"
+        "  G = { 1, \"two\", [ X = A + 1 ] }; H = strcat(C, MY.C, TARGET.C);"
+        "  I = absTime(\"2020-01-01T00:00:00\"); J = relTime(\"1+02:00:00\") ]");
+    ClassAd *ad2 = parser.ParseClassAd("[ A = 2; Requirements = A > 1 && strcat(C) == \"\" ]");
+    ClassAdBinaryUnParser binary_unparser;
+    ClassAdBinaryParser binary_parser;
+    std::string buf1, buf2;
+    TEST("Binary encode ad", ad1 && binary_unparser.Unparse(buf1, ad1));
+    size_t names = binary_unparser.NameCount();
+    TEST("Binary encode second ad", ad2 && binary_unparser.Unparse(buf2, ad2));
+    TEST("Binary second ad reuses names", binary_unparser.NameCount() == names);
+    ClassAd copy1, copy2;
+    size_t used = 0;
+    TEST("Binary decode ad", binary_parser.ParseClassAd(buf1.data(), buf1.size(), copy1, &used) && used == buf1.size());
+    TEST("Binary decode second ad", binary_parser.ParseClassAd(buf2.data(), buf2.size(), copy2));
+    TEST("Binary round trip is the same", ad1 && copy1.SameAs(ad1));
+    TEST("Binary round trip is the same 2", ad2 && copy2.SameAs(ad2));
+    ClassAd truncated;
+    binary_parser.Reset();
+    TEST("Binary decode rejects truncated ad", ! binary_parser.ParseClassAd(buf1.data(), buf1.size() - 1, truncated));
+
+    // The lexer scans in-memory sources a run of characters at a time.
+    // It must find the same tokens as when it reads one character at a
+    // time, wherever the buffer it is scanning happens to end.
+    {
+        const char *texts[] = {
+            "a Abc_123 _x a1.b2 MY.Requirements TARGET.Memory",
+            "AVeryLongIdentifierThatIsLongerThanSixteenCharacters + b",
+            "x = abc",
+            "   \t\n  \r\n                                       y\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\tz   ",
+            "// comment\n a /* comment */ b",
+            "\"hello world\" \"\" \"a\"",
+            "\"a\\\"b\\\\c\\n\\t\\101\\x41\"",
+            "\"a string longer than sixteen characters\\\" with an escape at the end\\\\\"",
+            "\"0123456789abcde\\\"\" \"0123456789abcdef\\\"\" \"0123456789abcdefg\\\"\"",
+            "\"\xc3\xa9t\xc3\xa9 and high bit characters\"",
+            "'quoted attr' 'a\\'b' 'x y z'",
+            "\"ends at the end\"",
+            "\"unterminated",
+            "\"escape at the end\\",
+            "\"C:\\\\dir\\\\\" \"old\\\"style\" \"a\\b\"",
+            "[ a = 1; b = 2.5e3; c = true; d = \"x\\ty\"; e = {1, 2K, 3M} ]",
+            "x >= 10 && y != \"z\" || z =?= undefined ? error : 0x1F",
+        };
+        const size_t chunk_sizes[] = { 1, 2, 3, 5, 16, 17 };
+        for (int old_syntax = 0; old_syntax < 2; old_syntax++) {
+            for (size_t ix = 0; ix < sizeof(texts) / sizeof(texts[0]); ix++) {
+                string text(texts[ix]);
+                string expected, tokens;
+                CharacterAtATimeLexerSource char_source(text.c_str());
+                lex_tokens(&char_source, old_syntax != 0, expected);
+
+                StringLexerSource string_source(&text);
+                lex_tokens(&string_source, old_syntax != 0, tokens);
+                bool same = (tokens == expected);
+                CharLexerSource buffer_source(text.c_str());
+                lex_tokens(&buffer_source, old_syntax != 0, tokens);
+                same = same && (tokens == expected);
+                for (size_t cx = 0; cx < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); cx++) {
+                    StringChunkLexerSource chunk_source(text, chunk_sizes[cx]);
+                    lex_tokens(&chunk_source, old_syntax != 0, tokens);
+                    same = same && (tokens == expected);
+                }
+                if ( ! same) {
+                    cout << "Lexer sources differ on: " << text << endl;
+                }
+                TEST(old_syntax ? "Buffer scan lexes old syntax like character reads"
+                                : "Buffer scan lexes like character reads", same);
+            }
+        }
+    }
+
+    // Ads read from a file a chunk at a time should be the same as ads
+    // parsed from a string, wherever the chunks happen to end.
+    if (ad1 && ad2) {
+        ClassAdUnParser new_unparser;
+        ClassAdJsonUnParser json_unparser;
+        ClassAdXMLUnParser xml_unparser;
+        ClassAdJsonParser json_parser;
+        ClassAdXMLParser xml_parser;
+        std::string new_text, json_text, xml_text;
+        new_unparser.Unparse(new_text, ad1);
+        new_unparser.Unparse(new_text, ad2);
+        json_text = "[\n";
+        json_unparser.Unparse(json_text, ad1);
+        json_text += ",\n";
+        json_unparser.Unparse(json_text, ad2);
+        json_text += "\n]\n";
+        xml_unparser.Unparse(xml_text, ad1);
+        xml_unparser.Unparse(xml_text, ad2);
+
+        ClassAd new1, new2, json1, json2, xml1, xml2;
+        int new_offset = 0, xml_offset = 0;
+        parser.ParseClassAd(new_text, new1, new_offset);
+        parser.ParseClassAd(new_text, new2, new_offset);
+        json_parser.ParseClassAd(json_text.substr(json_text.find('{')), json1);
+        json_parser.ParseClassAd(json_text.substr(json_text.rfind('{')), json2);
+        xml_parser.ParseClassAd(xml_text, xml1, xml_offset);
+        xml_parser.ParseClassAd(xml_text, xml2, xml_offset);
+
+        FILE *file = tmpfile();
+        TEST("Made a file to read in chunks", file != NULL);
+        const size_t chunk_sizes[] = { 1, 2, 3, 7, 64, ChunkedLexerSource::DEFAULT_CHUNK_SIZE };
+        for (size_t ix = 0; file && ix < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ix++) {
+            ClassAd chunk1, chunk2, chunk3;
+            bool same, ended;
+
+            if (ftruncate(fileno(file), 0) != 0) { TEST("Emptied the file", false); }
+            rewind(file);
+            fputs(new_text.c_str(), file);
+            fflush(file);
+            rewind(file);
+            BufferedFileLexerSource file_source(file, chunk_sizes[ix]);
+            same = parser.ParseClassAd(&file_source, chunk1) && chunk1.SameAs(&new1) &&
+                   parser.ParseClassAd(&file_source, chunk2) && chunk2.SameAs(&new2);
+            ended = ! parser.ParseClassAd(&file_source, chunk3) && file_source.AtEnd();
+            TEST("Chunked read of ads", same && ended);
+
+            // read the JSON list through the descriptor, as from a pipe
+            if (ftruncate(fileno(file), 0) != 0) { TEST("Emptied the file", false); }
+            rewind(file);
+            fputs(json_text.c_str(), file);
+            fflush(file);
+            lseek(fileno(file), 0, SEEK_SET);
+            FileDescriptorLexerSource fd_source(fileno(file), chunk_sizes[ix]);
+            int found = 0;
+            same = true;
+            for (int tries = 0; tries < 10 && ! fd_source.AtEnd(); tries++) {
+                if (json_parser.ParseClassAd(&fd_source, chunk1)) {
+                    same = same && chunk1.SameAs(found ? &json2 : &json1);
+                    found++;
+                }
+            }
+            TEST("Chunked read of JSON ads", same && found == 2 && fd_source.AtEnd() && ! fd_source.Failed());
+
+            if (ftruncate(fileno(file), 0) != 0) { TEST("Emptied the file", false); }
+            rewind(file);
+            fputs(xml_text.c_str(), file);
+            fflush(file);
+            rewind(file);
+            file_source.SetNewSource(file);
+            same = xml_parser.ParseClassAd(&file_source, chunk1) && chunk1.SameAs(&xml1) &&
+                   xml_parser.ParseClassAd(&file_source, chunk2) && chunk2.SameAs(&xml2);
+            ended = ! xml_parser.ParseClassAd(&file_source, chunk3) && file_source.AtEnd();
+            TEST("Chunked read of XML ads", same && ended);
+        }
+        if (file) {
+            fclose(file);
+        }
+    }
+    delete ad1;
+    delete ad2;
     return;
 }
 
@@ -543,6 +783,194 @@ static void test_classad(const Parameters &, Results &results)
     TEST("update from chain is merged",(have_attribute==true));
     TEST("update from chain has attribute c==6",(i==6));
 
+    /* ----- Test ClassAds chained to a shared parent ----- */
+    classad_shared_ptr<ClassAd> shared_parent(parser.ParseClassAd("[ a = 1; b = a + 1; c = 3 ]"));
+    ClassAd *shared1 = new ClassAd;
+    ClassAd shared2;
+    shared1->ChainToSharedAd(shared_parent);
+    shared2.ChainToSharedAd(shared_parent);
+    ClassAd *parent_seen = shared_parent.get();
+    shared_parent.reset();
+    TEST("shared parent is kept by the ads chained to it", shared1->GetChainedParentAd() == parent_seen);
+    shared1->InsertAttr("a", 10);
+    have_attribute = shared1->EvaluateAttrInt("b", i);
+    TEST("shared parent expression sees the child's attribute", (have_attribute == true && i == 11));
+    have_attribute = shared2.EvaluateAttrInt("b", i);
+    TEST("other child of shared parent is not changed", (have_attribute == true && i == 2));
+    ExprTree *removed = shared1->Remove("c");
+    TEST("remove from child of shared parent gives a copy", (removed != NULL && removed != parent_seen->Lookup("c")));
+    delete removed;
+    have_attribute = shared1->EvaluateAttrInt("c", i);
+    TEST("removed attribute is undefined in child", (have_attribute == false));
+    have_attribute = shared2.EvaluateAttrInt("c", i);
+    TEST("removed attribute is still in other child", (have_attribute == true && i == 3));
+    ClassAd shared3(*shared1);
+    TEST("copy of child shares its parent", (shared3.GetChainedParentAd() == parent_seen && shared3.size() == shared1->size()));
+    delete shared1;
+    have_attribute = shared3.EvaluateAttrInt("b", i);
+    TEST("copy of child keeps its parent", (have_attribute == true && i == 11));
+    shared3.Unchain();
+    have_attribute = shared3.EvaluateAttrInt("b", i);
+    TEST("unchained copy no longer sees parent", (have_attribute == false));
+    have_attribute = shared2.EvaluateAttrInt("b", i);
+    TEST("shared parent outlives children that let go of it", (have_attribute == true && i == 2));
+
+    /* ----- Test a ClassAd big enough to be indexed ----- */
+    ClassAd big;
+    char big_name[32];
+    for (int ii = 0; ii < 100; ii++) {
+        sprintf(big_name, "Attr%d", ii);
+        big.InsertAttr(big_name, ii);
+    }
+    TEST("big classad has 100 attributes", (big.size() == 100));
+    have_attribute = big.EvaluateAttrInt("aTTr42", i);
+    TEST("big classad lookup ignores case", (have_attribute == true && i == 42));
+    for (int ii = 0; ii < 100; ii += 2) {
+        sprintf(big_name, "ATTR%d", ii);
+        big.Delete(big_name);
+    }
+    TEST("big classad has 50 attributes", (big.size() == 50));
+    have_attribute = big.EvaluateAttrInt("Attr42", i);
+    TEST("big classad deleted attribute", (have_attribute == false));
+    have_attribute = big.EvaluateAttrInt("attr43", i);
+    TEST("big classad kept attribute", (have_attribute == true && i == 43));
+    big.InsertAttr("attr43", 7);
+    have_attribute = big.EvaluateAttrInt("Attr43", i);
+    TEST("big classad replaced attribute", (have_attribute == true && i == 7));
+    for (ClassAd::const_iterator itr = big.begin(); itr != big.end(); itr++) {
+        if (itr->first == "attr43") {
+            i = -1;
+        }
+    }
+    TEST("big classad iterator has first name", (i == 7));
+    ExprTree *sum = parser.ParseExpression("Attr41 + ATTR45");
+    big.Insert("Sum", sum);
+    have_attribute = big.EvaluateAttrInt("Sum", i);
+    TEST("big classad attribute references", (have_attribute == true && i == 86));
+
+    /* ----- Test the cache of compiled regular expressions ----- */
+    unsigned long hits, misses, hits2, misses2;
+    int old_cache_size = ClassAdGetRegexCacheSize();
+    ClassAdSetRegexCacheSize(2);
+    ClassAd regex_ad;
+    regex_ad.Insert("Match", parser.ParseExpression("regexp(\"^ba+r$\", \"baaar\")"));
+    regex_ad.Insert("NoMatch", parser.ParseExpression("regexp(\"^ba+r$\", \"bar!\")"));
+    regex_ad.Insert("Caseless", parser.ParseExpression("regexp(\"^BA+R$\", \"baaar\", \"i\")"));
+    regex_ad.Insert("Bad", parser.ParseExpression("regexp(\"(\", \"baaar\")"));
+    ClassAdGetRegexCacheStats(hits, misses);
+    have_attribute = regex_ad.EvaluateAttrBool("Match", b);
+    TEST("cached regexp matches", (have_attribute == true && b == true));
+    have_attribute = regex_ad.EvaluateAttrBool("NoMatch", b);
+    TEST("cached regexp doesn't match", (have_attribute == true && b == false));
+    ClassAdGetRegexCacheStats(hits2, misses2);
+    TEST("regexp cache hit", (hits2 == hits + 1 && misses2 == misses + 1));
+    have_attribute = regex_ad.EvaluateAttrBool("Caseless", b);
+    TEST("regexp options are part of the cache key", (have_attribute == true && b == true));
+    Value regex_value;
+    regex_ad.EvaluateAttr("Bad", regex_value);
+    TEST("bad regexp is an error", regex_value.IsErrorValue());
+    regex_ad.EvaluateAttr("Bad", regex_value);
+    TEST("cached bad regexp is an error", regex_value.IsErrorValue());
+    ClassAdGetRegexCacheStats(hits, misses);
+    regex_ad.EvaluateAttrBool("Match", b);
+    ClassAdGetRegexCacheStats(hits2, misses2);
+    TEST("regexp cache evicted pattern", (hits2 == hits && misses2 == misses + 1));
+    RegexpMatcher matcher("^ba+r$", "i");
+    ClassAdGetRegexCacheStats(hits, misses);
+    matcher.Match("BAAR", regex_value);
+    TEST("regexp matcher matches", (regex_value.IsBooleanValue(b) && b == true));
+    matcher.Match("bar!", regex_value);
+    TEST("regexp matcher doesn't match", (regex_value.IsBooleanValue(b) && b == false));
+    ClassAdGetRegexCacheStats(hits2, misses2);
+    TEST("regexp matcher compiles once", (matcher.Valid() && hits2 == hits && misses2 == misses));
+    RegexpMatcher bad_matcher("(", "");
+    bad_matcher.Match("(", regex_value);
+    TEST("bad regexp matcher is an error", (!bad_matcher.Valid() && regex_value.IsErrorValue()));
+    ClassAdSetRegexCacheSize(old_cache_size);
+
+    /* ----- Test the evaluation profiler ----- */
+    ClassAd *profiled = parser.ParseClassAd("[ MyType = \"Machine\"; Memory = 100; "
+                                            "Start = Memory > 50 && strcmp(\"a\", \"b\") < 0; ]");
+    EvalProfile::Enable(true);
+    for (int ii = 0; ii < 3; ii++) {
+        profiled->EvaluateAttrBool("START", b);
+    }
+    EvalProfile::Enable(false);
+    profiled->EvaluateAttrBool("Start", b);
+    vector<EvalProfile::Entry> profile_attrs, profile_functions;
+    EvalProfile::GetAttributes(profile_attrs);
+    EvalProfile::GetFunctions(profile_functions);
+    unsigned long start_count = 0, memory_count = 0;
+    for (size_t ii = 0; ii < profile_attrs.size(); ii++) {
+        if (profile_attrs[ii].ad_type == "Machine" && profile_attrs[ii].name == "START") {
+            start_count = profile_attrs[ii].count;
+        }
+        if (profile_attrs[ii].ad_type == "Machine" && profile_attrs[ii].name == "Memory") {
+            memory_count = profile_attrs[ii].count;
+        }
+    }
+    TEST("profiler counted attribute", (start_count == 3));
+    TEST("profiler counted referenced attribute", (memory_count == 3));
+    TEST("profiler counted function", (profile_functions.size() == 1 &&
+         profile_functions[0].name == "strcmp" && profile_functions[0].count == 3));
+    EvalProfile::Reset();
+    EvalProfile::GetAttributes(profile_attrs);
+    TEST("profiler reset", profile_attrs.empty());
+    delete profiled;
+
+    /* ----- Test evaluating one expression in many ClassAds ----- */
+    const char *batch_ads[] = {
+        "[ Owner = \"alice\"; Memory = 200; Cpus = 1; JobStatus = 2 ]",
+        "[ Owner = \"Alice\"; Memory = 50; Cpus = 4; JobStatus = 2.0 ]",
+        "[ Owner = \"bob\"; Memory = 100.5; Cpus = 2; JobStatus = 1 ]",
+        "[ Owner = \"carol\"; Memory = Cpus * 100; Cpus = 2 ]",
+        "[ Owner = 7; Memory = \"lots\"; JobStatus = undefined ]",
+        "[ Memory = 1K; Cpus = error ]",
+        "[ ]",
+    };
+    const char *batch_exprs[] = {
+        "Memory > 100",
+        "Owner == \"alice\" && Memory >= 100",
+        "Owner =?= \"alice\"",
+        "100 < memory && (Cpus > 1 || Owner =!= undefined)",
+        "(JobStatus == 2) && Owner < \"b\" && Cpus isnt undefined",
+        "Memory",
+        "Memory > 10 && Cpus",
+    };
+    vector<ClassAd*> batch;
+    for (size_t ii = 0; ii < sizeof(batch_ads) / sizeof(batch_ads[0]); ii++) {
+        batch.push_back(parser.ParseClassAd(batch_ads[ii]));
+    }
+    batch.push_back(NULL);
+    bool batch_same = true;
+    for (size_t ie = 0; ie < sizeof(batch_exprs) / sizeof(batch_exprs[0]); ie++) {
+        ExprTree *batch_expr = parser.ParseExpression(batch_exprs[ie]);
+        BatchEval batch_eval(batch_expr);
+        vector<bool> batch_results;
+        batch_eval.Evaluate(batch, batch_results);
+        for (size_t ii = 0; ii < batch.size(); ii++) {
+            Value val;
+            bool expected = batch[ii] && batch[ii]->EvaluateExpr(batch_expr, val) &&
+                val.IsBooleanValueEquiv(b) && b;
+            if (batch_results[ii] != expected) {
+                batch_same = false;
+            }
+        }
+        delete batch_expr;
+    }
+    TEST("batch evaluation same as evaluating each ad", batch_same);
+    ExprTree *batch_expr = parser.ParseExpression("Memory > 100 && Owner == \"alice\" && Cpus > 0");
+    BatchEval batch_eval(batch_expr);
+    vector<bool> batch_results;
+    batch_eval.Evaluate(batch, batch_results);
+    TEST("batch evaluation checks comparisons across ads", (batch_eval.Columns() == 3));
+    TEST("batch evaluation results", (batch_results.size() == batch.size() &&
+         batch_results[0] && !batch_results[1] && !batch_results[2] && !batch_results[3]));
+    delete batch_expr;
+    for (size_t ii = 0; ii < batch.size(); ii++) {
+        delete batch[ii];
+    }
+
     return;
 }
 
@@ -779,6 +1207,97 @@ static void test_value(const Parameters &, Results &results)
     return;
 }
 
+/*********************************************************************
+ *
+ * Function: test_match
+ * Purpose:  Test the MatchClassAd class.
+ *
+ *********************************************************************/
+static void test_match(const Parameters &, Results &results)
+{
+    ClassAdParser parser;
+    string        error_msg;
+    string        s;
+    double        r;
+    ClassAdUnParser unparser;
+
+    cout << "Testing the MatchClassAd class...\n";
+
+    for (int old_semantics = 0; old_semantics < 2; old_semantics++) {
+        SetOldClassAdSemantics(old_semantics != 0);
+
+        ClassAd *job = parser.ParseClassAd("[ Requirements = TARGET.Memory >= RequestMemory; "
+                                           "RequestMemory = 100; Rank = TARGET.Memory + 2 * RequestMemory; ]");
+        ClassAd *machine = parser.ParseClassAd("[ Requirements = TARGET.RequestMemory <= Memory; "
+                                               "Memory = 200; Rank = TARGET.RequestMemory; ]");
+        TEST("Parsed job and machine", (job != NULL && machine != NULL));
+        if (!job || !machine) {
+            continue;
+        }
+
+        MatchClassAd mad(job, machine);
+        TEST("Unoptimized ads match", mad.symmetricMatch());
+        mad.RemoveLeftAd();
+        mad.RemoveRightAd();
+
+        TEST("Optimize job ad", MatchClassAd::OptimizeLeftAdForMatchmaking(job, &error_msg));
+        TEST("Optimize machine ad", MatchClassAd::OptimizeRightAdForMatchmaking(machine, &error_msg));
+        s.clear();
+        unparser.Unparse(s, job->Lookup("Rank"));
+        TEST("Optimized rank has no references to its own ad", (s.find("RequestMemory") == string::npos));
+
+        mad.ReplaceLeftAd(job);
+        mad.ReplaceRightAd(machine);
+        TEST("Optimized ads match", mad.symmetricMatch());
+        TEST("Optimized job rank", (job->EvaluateAttrNumber("Rank", r) && r == 400));
+        TEST("Optimized machine rank", (machine->EvaluateAttrNumber("Rank", r) && r == 100));
+        mad.RemoveLeftAd();
+        mad.RemoveRightAd();
+
+            // the flattened rank doesn't depend on which side its ad is on
+        mad.ReplaceLeftAd(machine);
+        mad.ReplaceRightAd(job);
+        TEST("Optimized machine rank on the left", (machine->EvaluateAttrNumber("Rank", r) && r == 100));
+        mad.RemoveLeftAd();
+        mad.RemoveRightAd();
+
+        TEST("Unoptimize job ad", MatchClassAd::UnoptimizeAdForMatchmaking(job));
+        s.clear();
+        unparser.Unparse(s, job->Lookup("Rank"));
+        TEST("Unoptimized rank is restored", (s.find("RequestMemory") != string::npos));
+        TEST("Unoptimized requirements are restored", (job->Lookup("UnoptimizedRequirements") == NULL));
+
+            // an ad chained to the optimized machine ad is unoptimized
+            // on its own, and the shared machine ad stays optimized
+        classad_shared_ptr<ClassAd> slot(new ClassAd(*machine));
+        ClassAd *offer = new ClassAd();
+        offer->ChainToSharedAd(slot);
+        offer->InsertAttr("Memory", 50);
+        TEST("Unoptimize chained ad", MatchClassAd::UnoptimizeAdForMatchmaking(offer));
+        s.clear();
+        unparser.Unparse(s, offer->Lookup("Requirements"));
+        TEST("Unoptimized chained requirements are restored", (s.find("Memory") != string::npos));
+        TEST("Unoptimized chained ad has no saved expressions",
+             (offer->Lookup("UnoptimizedRequirements") == NULL && offer->Lookup("UnoptimizedRank") == NULL));
+        TEST("Unoptimized chained ad is unchained", (offer->GetChainedParentAd() == NULL));
+        TEST("Unoptimized chained ad keeps its own attributes",
+             (offer->EvaluateAttrNumber("Memory", r) && r == 50));
+        TEST("Shared parent ad stays optimized", (slot->Lookup("UnoptimizedRequirements") != NULL));
+        mad.ReplaceLeftAd(job);
+        mad.ReplaceRightAd(offer);
+        TEST("Unoptimized chained ad evaluates its own requirements", !mad.symmetricMatch());
+        mad.RemoveLeftAd();
+        mad.RemoveRightAd();
+        delete offer;
+
+        delete job;
+        delete machine;
+    }
+    SetOldClassAdSemantics(false);
+
+    return;
+}
+
 /*********************************************************************
  *
  * Function: test_collection
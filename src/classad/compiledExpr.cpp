@@ -0,0 +1,321 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/compiledExpr.h"
+
+using namespace std;
+
+namespace classad {
+
+// How many times an operator expression is evaluated before it is
+// compiled.  The default is 0, which means never.
+static int compileThreshold = 0;
+
+void ClassAdSetCompileThreshold(int evaluations)
+{
+	compileThreshold = evaluations > 0 ? evaluations : 0;
+}
+
+int ClassAdGetCompileThreshold()
+{
+	return compileThreshold;
+}
+
+	// values a compiled expression can keep on the C++ stack; deeper
+	// expressions use the heap
+static const int LOCAL_STACK_SIZE = 8;
+
+CompiledExpr *CompiledExpr::
+Compile( const ExprTree *tree )
+{
+	if( !tree || tree->GetKind() != ExprTree::OP_NODE ) {
+		return NULL;
+	}
+	CompiledExpr *compiled = new CompiledExpr;
+	int depth = 0;
+	compiled->compile( tree, depth );
+	return compiled;
+}
+
+int CompiledExpr::
+emit( OpCode opcode, Operation::OpKind op, const ExprTree *tree, const ExprTree *tree2 )
+{
+	Instruction inst;
+	inst.code = opcode;
+	inst.op = op;
+	inst.arg = -1;
+	inst.arg2 = -1;
+	inst.tree = tree;
+	inst.tree2 = tree2;
+	code.push_back( inst );
+	return (int)code.size() - 1;
+}
+
+void CompiledExpr::
+push( int &depth )
+{
+	if( ++depth > max_depth ) {
+		max_depth = depth;
+	}
+}
+
+bool CompiledExpr::
+isConstant( const ExprTree *tree ) const
+{
+	switch( tree->GetKind() ) {
+	case ExprTree::LITERAL_NODE:
+		return true;
+	case ExprTree::OP_NODE: {
+		Operation::OpKind op;
+		ExprTree *t1 = NULL, *t2 = NULL, *t3 = NULL;
+		((const Operation*)tree)->GetComponents( op, t1, t2, t3 );
+		return (!t1 || isConstant(t1)) && (!t2 || isConstant(t2)) &&
+			(!t3 || isConstant(t3));
+	}
+	default:
+		return false;
+	}
+}
+
+void CompiledExpr::
+compile( const ExprTree *tree, int &depth )
+{
+		// literals, and operators applied only to literals, do not
+		// depend on the state, so evaluate them now.  That is done with
+		// a compiled form of their own, which keeps the operators from
+		// compiling themselves while we are compiling them.
+	if( fold && tree->GetKind() != ExprTree::LITERAL_NODE && isConstant( tree ) ) {
+		CompiledExpr folder;
+		folder.fold = false;
+		int folder_depth = 0;
+		folder.compile( tree, folder_depth );
+
+		EvalState state;
+		Value val;
+		if( folder.Evaluate( state, val ) ) {
+			int inst = emit( PUSH_CONST );
+			code[inst].arg = (int)consts.size();
+			consts.push_back( val );
+			push( depth );
+			return;
+		}
+	}
+
+	if( tree->GetKind() == ExprTree::LITERAL_NODE ) {
+		EvalState state;
+		Value val;
+		if( tree->Evaluate( state, val ) ) {
+			int inst = emit( PUSH_CONST );
+			code[inst].arg = (int)consts.size();
+			consts.push_back( val );
+			push( depth );
+			return;
+		}
+	}
+
+	if( tree->GetKind() != ExprTree::OP_NODE ) {
+		emit( EVAL_TREE, Operation::__NO_OP__, tree );
+		push( depth );
+		return;
+	}
+
+	Operation::OpKind op;
+	ExprTree *t1 = NULL, *t2 = NULL, *t3 = NULL;
+	((const Operation*)tree)->GetComponents( op, t1, t2, t3 );
+
+	switch( op ) {
+	case Operation::PARENTHESES_OP:
+		compile( t1, depth );
+		break;
+
+	case Operation::UNARY_PLUS_OP:
+	case Operation::UNARY_MINUS_OP:
+	case Operation::LOGICAL_NOT_OP:
+	case Operation::BITWISE_NOT_OP:
+		compile( t1, depth );
+		emit( UNARY_OP, op );
+		break;
+
+	case Operation::LOGICAL_AND_OP:
+	case Operation::LOGICAL_OR_OP: {
+		compile( t1, depth );
+		int jump = emit( op == Operation::LOGICAL_AND_OP ? AND_JUMP : OR_JUMP );
+		compile( t2, depth );
+		emit( BINARY_OP, op );
+		depth--;
+		code[jump].arg = (int)code.size();
+		break;
+	}
+
+	case Operation::TERNARY_OP: {
+		if( !t2 ) {
+				// the "elvis" form, cond ?: alt, is rare enough that
+				// the tree can handle it
+			emit( EVAL_OP, Operation::__NO_OP__, tree );
+			push( depth );
+			break;
+		}
+			// selector, then the true branch, the false branch, and the
+			// case of a selector that is not boolean, which needs all
+			// three values
+		compile( t1, depth );
+		int select = emit( TERNARY_JUMP );
+		depth--;
+		compile( t2, depth );
+		int jump_true = emit( JUMP );
+		depth--;
+		code[select].arg = (int)code.size();
+		compile( t3, depth );
+		int jump_false = emit( JUMP );
+		code[select].arg2 = (int)code.size();
+		emit( TERNARY_OTHER, op, t2, t3 );
+		code[jump_true].arg = (int)code.size();
+		code[jump_false].arg = (int)code.size();
+		break;
+	}
+
+	default:
+		if( !t1 || !t2 || t3 ) {
+			emit( EVAL_OP, Operation::__NO_OP__, tree );
+			push( depth );
+			break;
+		}
+		compile( t1, depth );
+		compile( t2, depth );
+		emit( BINARY_OP, op );
+		depth--;
+		break;
+	}
+}
+
+bool CompiledExpr::
+Evaluate( EvalState &state, Value &result ) const
+{
+	Value local[LOCAL_STACK_SIZE];
+	vector<Value> heap;
+	Value *stack = local;
+	if( max_depth > LOCAL_STACK_SIZE ) {
+		heap.resize( max_depth );
+		stack = &heap[0];
+	}
+
+	int sp = 0;
+	int pc = 0;
+	int end = (int)code.size();
+	Value none, tmp;
+	bool b;
+
+	while( pc < end ) {
+		const Instruction &inst = code[pc++];
+		switch( inst.code ) {
+		case PUSH_CONST:
+			stack[sp++].CopyFrom( consts[inst.arg] );
+			break;
+
+		case EVAL_TREE:
+			if( !inst.tree->Evaluate( state, stack[sp] ) ) {
+				result.SetErrorValue( );
+				return false;
+			}
+			sp++;
+			break;
+
+		case EVAL_OP:
+			if( !((const Operation*)inst.tree)->evaluateTree( state, stack[sp] ) ) {
+				result.SetErrorValue( );
+				return false;
+			}
+			sp++;
+			break;
+
+		case UNARY_OP:
+			if( Operation::_doOperation( inst.op, stack[sp-1], none, none,
+					true, false, false, tmp, &state ) == Operation::SIG_NONE ) {
+				result.SetErrorValue( );
+				return false;
+			}
+			stack[sp-1].CopyFrom( tmp );
+			break;
+
+		case BINARY_OP:
+			if( Operation::_doOperation( inst.op, stack[sp-2], stack[sp-1], none,
+					true, true, false, tmp, &state ) == Operation::SIG_NONE ) {
+				result.SetErrorValue( );
+				return false;
+			}
+			sp--;
+			stack[sp-1].CopyFrom( tmp );
+			break;
+
+		case AND_JUMP:
+			if( stack[sp-1].IsBooleanValueEquiv( b ) && !b ) {
+				stack[sp-1].SetBooleanValue( false );
+				pc = inst.arg;
+			}
+			break;
+
+		case OR_JUMP:
+			if( stack[sp-1].IsBooleanValueEquiv( b ) && b ) {
+				stack[sp-1].SetBooleanValue( true );
+				pc = inst.arg;
+			}
+			break;
+
+		case TERNARY_JUMP:
+			if( stack[sp-1].IsBooleanValueEquiv( b ) ) {
+				sp--;
+				if( !b ) {
+					pc = inst.arg;
+				}
+			} else {
+				pc = inst.arg2;
+			}
+			break;
+
+		case TERNARY_OTHER: {
+				// like the tree, evaluate both branches before finding
+				// that the selector is undefined or an error
+			Value val2, val3;
+			if( !inst.tree->Evaluate( state, val2 ) ||
+				!inst.tree2->Evaluate( state, val3 ) ) {
+				result.SetErrorValue( );
+				return false;
+			}
+			if( Operation::_doOperation( inst.op, stack[sp-1], val2, val3,
+					true, true, true, tmp, &state ) == Operation::SIG_NONE ) {
+				result.SetErrorValue( );
+				return false;
+			}
+			stack[sp-1].CopyFrom( tmp );
+			break;
+		}
+
+		case JUMP:
+			pc = inst.arg;
+			break;
+		}
+	}
+
+	result.CopyFrom( stack[0] );
+	return true;
+}
+
+} // classad
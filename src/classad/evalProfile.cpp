@@ -0,0 +1,160 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "classad/common.h"
+#include "classad/classad.h"
+#include "classad/literals.h"
+#include "classad/evalProfile.h"
+#include <map>
+#include <mutex>
+#include <algorithm>
+
+using namespace std;
+
+namespace classad {
+
+std::atomic<bool> EvalProfile::enabled( false );
+
+struct EvalCounts {
+	EvalCounts( ) : count( 0 ), seconds( 0 ) {}
+	unsigned long	count;
+	double			seconds;
+};
+
+	// attributes are keyed by ad type and name, functions by name
+typedef map<string, EvalCounts, CaseIgnLTStr> EvalCountMap;
+
+struct EvalProfileData {
+	mutex			lock;
+	EvalCountMap	attributes;
+	EvalCountMap	functions;
+};
+
+static EvalProfileData &
+theProfile( )
+{
+		// never destroyed, so it outlives anything that evaluates
+	static EvalProfileData *profile = new EvalProfileData;
+	return *profile;
+}
+
+	// the MyType of an ad, if it is a plain string; evaluating it would
+	// be counted in turn
+static void
+adType( const ClassAd *ad, string &type )
+{
+	const ExprTree *tree = ad ? ad->Lookup( "MyType" ) : NULL;
+	if( tree ) {
+		tree = tree->self( );
+	}
+	if( tree && tree->GetKind( ) == ExprTree::LITERAL_NODE ) {
+		Value val;
+		((const Literal *)tree)->GetValue( val );
+		val.IsStringValue( type );
+	}
+}
+
+static bool
+moreTime( const EvalProfile::Entry &a, const EvalProfile::Entry &b )
+{
+	return a.seconds > b.seconds;
+}
+
+static void
+getEntries( const EvalCountMap &counts, bool typed, vector<EvalProfile::Entry> &entries )
+{
+	entries.clear( );
+	entries.reserve( counts.size( ) );
+	for( EvalCountMap::const_iterator it = counts.begin( ); it != counts.end( ); it++ ) {
+		EvalProfile::Entry entry;
+		if( typed ) {
+			size_t sep = it->first.find( '\n' );
+			entry.ad_type = it->first.substr( 0, sep );
+			entry.name = it->first.substr( sep + 1 );
+		} else {
+			entry.name = it->first;
+		}
+		entry.count = it->second.count;
+		entry.seconds = it->second.seconds;
+		entries.push_back( entry );
+	}
+	sort( entries.begin( ), entries.end( ), moreTime );
+}
+
+void EvalProfile::
+Enable( bool enable )
+{
+	if( enable && !enabled.load( memory_order_relaxed ) ) {
+		Reset( );
+	}
+	enabled.store( enable, memory_order_relaxed );
+}
+
+void EvalProfile::
+GetAttributes( vector<Entry> &entries )
+{
+	EvalProfileData &profile = theProfile( );
+	lock_guard<mutex> guard( profile.lock );
+	getEntries( profile.attributes, true, entries );
+}
+
+void EvalProfile::
+GetFunctions( vector<Entry> &entries )
+{
+	EvalProfileData &profile = theProfile( );
+	lock_guard<mutex> guard( profile.lock );
+	getEntries( profile.functions, false, entries );
+}
+
+void EvalProfile::
+Reset( )
+{
+	EvalProfileData &profile = theProfile( );
+	lock_guard<mutex> guard( profile.lock );
+	profile.attributes.clear( );
+	profile.functions.clear( );
+}
+
+void EvalProfile::
+CountAttribute( const string &name, const ClassAd *ad, double seconds )
+{
+	string key;
+	adType( ad, key );
+	key += '\n';
+	key += name;
+
+	EvalProfileData &profile = theProfile( );
+	lock_guard<mutex> guard( profile.lock );
+	EvalCounts &counts = profile.attributes[key];
+	counts.count++;
+	counts.seconds += seconds;
+}
+
+void EvalProfile::
+CountFunction( const string &name, double seconds )
+{
+	EvalProfileData &profile = theProfile( );
+	lock_guard<mutex> guard( profile.lock );
+	EvalCounts &counts = profile.functions[name];
+	counts.count++;
+	counts.seconds += seconds;
+}
+
+} // classad
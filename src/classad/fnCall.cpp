@@ -27,6 +27,7 @@
 #include "classad/source.h"
 #include "classad/sink.h"
 #include "classad/util.h"
+#include "classad/evalProfile.h"
 
 #ifdef WIN32
  #if _MSC_VER < 1900
@@ -55,6 +56,9 @@
 #include <dlfcn.h>
 #endif
 
+#include <list>
+#include <mutex>
+
 using namespace std;
 
 namespace classad {
@@ -470,6 +474,12 @@ bool FunctionCall::
 _Evaluate (EvalState &state, Value &value) const
 {
 	if( function ) {
+		if( EvalProfile::Enabled( ) ) {
+			EvalProfile::Timer timer;
+			bool rval = (*function)( functionName.c_str( ), arguments, state, value );
+			EvalProfile::CountFunction( functionName, timer.Seconds( ) );
+			return rval;
+		}
 		return( (*function)( functionName.c_str( ), arguments, state, value ) );
 	} else {
 		value.SetErrorValue();
@@ -2598,10 +2608,160 @@ debug( const char* name,const ArgumentList &argList,EvalState &state,
 	return true;
 }
 
+// How many compiled patterns the regular expression functions keep,
+// and whether they compile them to machine code
+static int regexCacheSize = 0;
+static bool regexJIT = false;
+
 #if defined USE_POSIX_REGEX || defined USE_PCRE
+
+// A compiled pattern.  Evaluations in several threads may use one at the
+// same time, so matching must not change it.
+struct CompiledRegex
+{
+	CompiledRegex( const char *pattern, int options, bool keep );
+	~CompiledRegex( );
+
+	bool		valid;
+#if defined (USE_POSIX_REGEX)
+	regex_t		re;
+#else
+	pcre		*re;
+	pcre_extra	*extra;
+	int			group_count;
+#endif
+};
+
+CompiledRegex::
+CompiledRegex( const char *pattern, int options, bool keep )
+{
+#if defined (USE_POSIX_REGEX)
+	(void)keep;
+	valid = ( regcomp( &re, pattern, options ) == 0 );
+#else
+	const char	*error_message;
+	int			error_offset;
+	extra = NULL;
+	group_count = 0;
+	re = pcre_compile( pattern, options, &error_message, &error_offset, NULL );
+	valid = ( re != NULL );
+	if( valid ) {
+		pcre_fullinfo( re, NULL, PCRE_INFO_CAPTURECOUNT, &group_count );
+			// studying a pattern only pays off if it will be used again
+		if( keep ) {
+			int study_options = 0;
+#ifdef PCRE_STUDY_JIT_COMPILE
+			if( regexJIT ) {
+				study_options |= PCRE_STUDY_JIT_COMPILE;
+			}
+#endif
+			extra = pcre_study( re, study_options, &error_message );
+		}
+	}
+#endif
+}
+
+CompiledRegex::
+~CompiledRegex( )
+{
+#if defined (USE_POSIX_REGEX)
+	if( valid ) {
+		regfree( &re );
+	}
+#else
+	if( extra ) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study( extra );
+#else
+		pcre_free( extra );
+#endif
+	}
+	if( re ) {
+		pcre_free( re );
+	}
+#endif
+}
+
+// The compiled patterns, keyed by the compile options and the pattern,
+// in order of use
+class RegexCache
+{
+	public:
+		RegexCache( ) : hits( 0 ), misses( 0 ) {}
+
+		std::shared_ptr<const CompiledRegex> Get( const char *pattern, int options );
+		void Trim( );
+
+		unsigned long		hits;
+		unsigned long		misses;
+		std::mutex			lock;
+
+	private:
+		typedef std::pair<std::string, std::shared_ptr<const CompiledRegex> > Entry;
+		typedef std::list<Entry> EntryList;
+		typedef classad_unordered<std::string, EntryList::iterator> EntryMap;
+
+		EntryList			entries;	// most recently used first
+		EntryMap			index;
+};
+
+static RegexCache &
+theRegexCache( )
+{
+		// never destroyed, so it outlives anything that evaluates
+	static RegexCache *cache = new RegexCache;
+	return *cache;
+}
+
+std::shared_ptr<const CompiledRegex> RegexCache::
+Get( const char *pattern, int options )
+{
+	if( regexCacheSize <= 0 ) {
+		return std::shared_ptr<const CompiledRegex>( new CompiledRegex( pattern, options, false ) );
+	}
+
+	std::string key( (const char *)&options, sizeof( options ) );
+	key += pattern;
+	{
+		std::lock_guard<std::mutex> guard( lock );
+		EntryMap::iterator found = index.find( key );
+		if( found != index.end( ) ) {
+			hits++;
+			entries.splice( entries.begin( ), entries, found->second );
+			return found->second->second;
+		}
+		misses++;
+	}
+
+		// compile without holding the lock; if another thread compiles
+		// the same pattern meanwhile, the first one in is kept
+	std::shared_ptr<const CompiledRegex> regex( new CompiledRegex( pattern, options, true ) );
+
+	std::lock_guard<std::mutex> guard( lock );
+	EntryMap::iterator found = index.find( key );
+	if( found != index.end( ) ) {
+		return found->second->second;
+	}
+	entries.push_front( Entry( key, regex ) );
+	index[key] = entries.begin( );
+	Trim( );
+	return regex;
+}
+
+	// drop the least recently used patterns that don't fit; the caller
+	// holds the lock.  Evaluations still using them keep them until done.
+void RegexCache::
+Trim( )
+{
+	while( !entries.empty( ) && entries.size( ) > (size_t)regexCacheSize ) {
+		index.erase( entries.back( ).first );
+		entries.pop_back( );
+	}
+}
+
 static bool regexp_helper(const char *pattern, const char *target,
                           const char *replace,
-                          bool have_options, string options_string,
+                          bool have_options, const string &options_string,
                           Value &result);
 
 bool FunctionCall::
@@ -2848,26 +3008,21 @@ matchPatternMember( const char*,const ArgumentList &argList,EvalState &state,
     return true;
 }
 
-static bool regexp_helper(
-    const char *pattern,
-    const char *target,
-	const char *replace,
+	// the compile options for the option letters that regexp() and the
+	// other regular expression functions take, and whether a replacement
+	// is of the full target and of every match
+static int regexp_options(
+	bool		replace,
     bool       have_options,
-    string     options_string,
-    Value      &result)
+    const string &options_string,
+	bool		&full_target,
+	bool		&find_all)
 {
     int         options;
-	int			status;
-	bool		full_target = false;
-	bool		find_all = false;
 
+	full_target = false;
+	find_all = false;
 #if defined (USE_POSIX_REGEX)
-	regex_t		re;
-
-	const int MAX_REGEX_GROUPS=11;
-	regmatch_t pmatch[MAX_REGEX_GROUPS];
-	size_t      nmatch = MAX_REGEX_GROUPS;
-
     options = REG_EXTENDED;
 	if( !replace ) {
 		options |= REG_NOSUB;
@@ -2883,19 +3038,68 @@ static bool regexp_helper(
             full_target = true;
         }
     }
+#else
+    options     = 0;
+    if( have_options ){
+        // We look for the options we understand, and ignore
+        // any others that we might find, hopefully allowing
+        // forwards compatibility.
+        if ( options_string.find( 'i' ) != string::npos ) {
+            options |= PCRE_CASELESS;
+        } 
+        if ( options_string.find( 'm' ) != string::npos ) {
+            options |= PCRE_MULTILINE;
+        }
+        if ( options_string.find( 's' ) != string::npos ) {
+            options |= PCRE_DOTALL;
+        }
+        if ( options_string.find( 'x' ) != string::npos ) {
+            options |= PCRE_EXTENDED;
+        }
+		if ( replace ) {
+			// The 'f' option means that the result should consist of
+			// the full target string with any replacement(s) applied
+			// in-place.
+			if ( options_string.find( 'f' ) != string::npos ) {
+				full_target = true;
+			}
+			// The 'g' option means that all matches to the pattern
+			// should be found in the target string (without overlaps).
+			if ( options_string.find( 'g' ) != string::npos ) {
+				find_all = true;
+			}
+		}
+    }
+#endif
+	return options;
+}
 
-		// compile the patern
-	if( regcomp( &re, pattern, options ) != 0 ) {
+	// match a compiled pattern against the target, and make the
+	// replacement if one is given
+static bool regexp_match(
+	const CompiledRegex &regex,
+    const char *target,
+	const char *replace,
+	bool		full_target,
+	bool		find_all,
+    Value      &result)
+{
+	int			status;
+
+	if( !regex.valid ) {
 			// error in pattern
 		result.SetErrorValue( );
 		return( true );
 	}
 
-		// test the match
-	status = regexec( &re, target, nmatch, pmatch, 0 );
+#if defined (USE_POSIX_REGEX)
+	(void)find_all;
+	const int MAX_REGEX_GROUPS=11;
+	regmatch_t pmatch[MAX_REGEX_GROUPS];
+	size_t      nmatch = MAX_REGEX_GROUPS;
 
-		// dispose memory created by regcomp()
-	regfree( &re );
+		// test the match
+	status = regexec( &regex.re, target, nmatch, pmatch, 0 );
 
 	if( status == 0 && replace ) {
 		string group_buffers[MAX_REGEX_GROUPS];
@@ -2973,10 +3177,8 @@ static bool regexp_helper(
 		return( true );
 	}
 #elif defined (USE_PCRE)
-    const char  *error_message;
-    int         error_offset;
-    pcre        *re = NULL;
-	int group_count = 0;
+	const int OVECTOR_SIZE = 3 * 16;
+	int ovector_buf[OVECTOR_SIZE];
 	int oveccount = 0;
 	int *ovector = NULL;
 	bool empty_match = false;
@@ -2985,50 +3187,13 @@ static bool regexp_helper(
 	int target_idx = 0;
 	string output;
 
-    options     = 0;
-    if( have_options ){
-        // We look for the options we understand, and ignore
-        // any others that we might find, hopefully allowing
-        // forwards compatibility.
-        if ( options_string.find( 'i' ) != string::npos ) {
-            options |= PCRE_CASELESS;
-        } 
-        if ( options_string.find( 'm' ) != string::npos ) {
-            options |= PCRE_MULTILINE;
-        }
-        if ( options_string.find( 's' ) != string::npos ) {
-            options |= PCRE_DOTALL;
-        }
-        if ( options_string.find( 'x' ) != string::npos ) {
-            options |= PCRE_EXTENDED;
-        }
-		if ( replace ) {
-			// The 'f' option means that the result should consist of
-			// the full target string with any replacement(s) applied
-			// in-place.
-			if ( options_string.find( 'f' ) != string::npos ) {
-				full_target = true;
-			}
-			// The 'g' option means that all matches to the pattern
-			// should be found in the target string (without overlaps).
-			if ( options_string.find( 'g' ) != string::npos ) {
-				find_all = true;
-			}
-		}
-    }
-
-    re = pcre_compile( pattern, options, &error_message,
-                      &error_offset, NULL );
-    if ( re == NULL ){
-			// error in pattern
-		result.SetErrorValue( );
-		goto cleanup;
+	oveccount = 3 * (regex.group_count + 1); // +1 for the string itself
+	if ( oveccount <= OVECTOR_SIZE ) {
+		ovector = ovector_buf;
+	} else {
+		ovector = (int *) malloc(oveccount * sizeof(int));
 	}
 
-	pcre_fullinfo(re, NULL, PCRE_INFO_CAPTURECOUNT, &group_count);
-	oveccount = 3 * (group_count + 1); // +1 for the string itself
-	ovector = (int *) malloc(oveccount * sizeof(int));
-
 	// NOTE: For global replacement option 'g', we don't properly
 	//   handle situations where a single character of the target
 	//   consists of multiple bytes. These are UTF-8 strings and
@@ -3043,7 +3208,7 @@ static bool regexp_helper(
 			addl_opts = 0;
 		}
 
-        status = pcre_exec(re, NULL, target, target_len,
+        status = pcre_exec(regex.re, regex.extra, target, target_len,
                            target_idx, addl_opts, ovector, oveccount);
 
 		if (empty_match && status == PCRE_ERROR_NOMATCH) {
@@ -3108,16 +3273,98 @@ static bool regexp_helper(
 		result.SetStringValue(output);
 	}
  cleanup:
-	if ( re ) {
-		pcre_free(re);
+	if ( ovector != ovector_buf ) {
+		free(ovector);
 	}
-	free(ovector);
     return true;
 #endif
 }
 
+static bool regexp_helper(
+    const char *pattern,
+    const char *target,
+	const char *replace,
+    bool       have_options,
+    const string &options_string,
+    Value      &result)
+{
+	bool full_target, find_all;
+	int options = regexp_options( replace != NULL, have_options, options_string, full_target, find_all );
+
+		// compile the patern, or find it already compiled
+	std::shared_ptr<const CompiledRegex> regex = theRegexCache( ).Get( pattern, options );
+	return regexp_match( *regex, target, replace, full_target, find_all, result );
+}
+
 #endif /* defined USE_POSIX_REGEX || defined USE_PCRE */
 
+RegexpMatcher::
+RegexpMatcher( const char *pattern, const string &options )
+{
+#if defined USE_POSIX_REGEX || defined USE_PCRE
+	bool full_target, find_all;
+	regex = theRegexCache( ).Get( pattern,
+		regexp_options( false, true, options, full_target, find_all ) );
+#else
+	(void)pattern; (void)options;
+#endif
+}
+
+bool RegexpMatcher::
+Valid( ) const
+{
+#if defined USE_POSIX_REGEX || defined USE_PCRE
+	return regex && regex->valid;
+#else
+	return false;
+#endif
+}
+
+void RegexpMatcher::
+Match( const char *target, Value &result ) const
+{
+#if defined USE_POSIX_REGEX || defined USE_PCRE
+	if( regex ) {
+		regexp_match( *regex, target, NULL, false, false, result );
+		return;
+	}
+#else
+	(void)target;
+#endif
+	result.SetErrorValue( );
+}
+
+void ClassAdSetRegexCacheSize( int patterns )
+{
+	regexCacheSize = patterns > 0 ? patterns : 0;
+#if defined USE_POSIX_REGEX || defined USE_PCRE
+	RegexCache &cache = theRegexCache( );
+	std::lock_guard<std::mutex> guard( cache.lock );
+	cache.Trim( );
+#endif
+}
+
+int ClassAdGetRegexCacheSize( )
+{
+	return regexCacheSize;
+}
+
+void ClassAdSetRegexJIT( bool jit )
+{
+	regexJIT = jit;
+}
+
+void ClassAdGetRegexCacheStats( unsigned long &hits, unsigned long &misses )
+{
+	hits = misses = 0;
+#if defined USE_POSIX_REGEX || defined USE_PCRE
+	RegexCache &cache = theRegexCache( );
+	std::lock_guard<std::mutex> guard( cache.lock );
+	hits = cache.hits;
+	misses = cache.misses;
+#endif
+}
+
 static bool 
 doSplitTime(const Value &time, ClassAd * &splitClassAd)
 {
@@ -24,12 +24,142 @@
 #include "classad/util.h"
 #include "classad/classad.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#include <stdint.h>
+#define LEXER_SSE2 1
+#endif
+
 using namespace std;
 
 #define EMPTY -2
 
+	// the buffer scans load whole aligned blocks, which may go past the
+	// end of the buffer, but never past the page it ends in
+#if defined(__SANITIZE_ADDRESS__)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef NO_SANITIZE_ADDRESS
+#define NO_SANITIZE_ADDRESS
+#endif
+
 namespace classad {
 
+// Scanners for the buffers of in-memory sources: each returns the length
+// of the run of characters at str that belong to an identifier, are
+// white space, or are in a string literal up to the closing quote, the
+// first backslash (if escapes) or the end.  None of them get past the
+// NUL that ends the buffer.
+
+static inline bool
+isIdentChar( int c )
+{
+	return (unsigned)((c | 0x20) - 'a') < 26 || (unsigned)(c - '0') < 10 || c == '_';
+}
+
+#ifdef LEXER_SSE2
+
+	// a bit for each character of the 16 at p that is in the run
+template <class Match>
+NO_SANITIZE_ADDRESS static inline size_t
+scanRun( const char *str, Match match )
+{
+	const char *block = (const char *)( (uintptr_t)str & ~(uintptr_t)15 );
+	unsigned int stops = ~match( _mm_load_si128( (const __m128i *)block ) )
+		& ( 0xffffu << ( str - block ) ) & 0xffffu;
+	while( !stops ) {
+		block += 16;
+		stops = ~match( _mm_load_si128( (const __m128i *)block ) ) & 0xffffu;
+	}
+	return block + __builtin_ctz( stops ) - str;
+}
+
+static inline __m128i
+inRange( __m128i v, char lo, char hi )
+{
+		// signed compares, but characters past 0x7f are never in range
+	return _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( lo - 1 ) ),
+						  _mm_cmplt_epi8( v, _mm_set1_epi8( hi + 1 ) ) );
+}
+
+struct IdentMatch {
+	int operator()( __m128i v ) const {
+		__m128i alpha = inRange( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ), 'a', 'z' );
+		__m128i digit = inRange( v, '0', '9' );
+		__m128i under = _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) );
+		return _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( alpha, digit ), under ) );
+	}
+};
+
+struct SpaceMatch {
+	int operator()( __m128i v ) const {
+		__m128i blank = _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) );
+		return _mm_movemask_epi8( _mm_or_si128( blank, inRange( v, '\t', '\r' ) ) );
+	}
+};
+
+struct StringMatch {
+	StringMatch( char d, bool e ) : delim( _mm_set1_epi8( d ) ),
+		backslash( _mm_set1_epi8( e ? '\\' : 0 ) ) {}
+	int operator()( __m128i v ) const {
+		__m128i stop = _mm_or_si128( _mm_cmpeq_epi8( v, delim ), _mm_cmpeq_epi8( v, backslash ) );
+		stop = _mm_or_si128( stop, _mm_cmpeq_epi8( v, _mm_setzero_si128( ) ) );
+		return ~_mm_movemask_epi8( stop );
+	}
+	__m128i delim;
+	__m128i backslash;
+};
+
+static size_t
+scanIdentifier( const char *str )
+{
+	return scanRun( str, IdentMatch( ) );
+}
+
+static size_t
+scanSpace( const char *str )
+{
+	return scanRun( str, SpaceMatch( ) );
+}
+
+static size_t
+scanString( const char *str, char delim, bool escapes )
+{
+	return scanRun( str, StringMatch( delim, escapes ) );
+}
+
+#else
+
+static size_t
+scanIdentifier( const char *str )
+{
+	const char *p = str;
+	while( isIdentChar( (unsigned char)*p ) ) p++;
+	return p - str;
+}
+
+static size_t
+scanSpace( const char *str )
+{
+	const char *p = str;
+	while( *p == ' ' || ( *p >= '\t' && *p <= '\r' ) ) p++;
+	return p - str;
+}
+
+static size_t
+scanString( const char *str, char delim, bool escapes )
+{
+	const char *p = str;
+	while( *p && *p != delim && !( escapes && *p == '\\' ) ) p++;
+	return p - str;
+}
+
+#endif
+
 // ctor
 Lexer::
 Lexer ()
@@ -131,7 +261,7 @@ void Lexer::
 fetch (void)
 {
 	if (ch == EMPTY) {
-		ch = lexSource->ReadCharacter();
+		ch = lexSource->NextCharacter();
 	}
 }
 
@@ -167,12 +297,26 @@ wind (bool fetch)
 		lexBuffer += ch;
 	}
 	if (fetch) {
-		ch = lexSource->ReadCharacter();
+		ch = lexSource->NextCharacter();
 	} else {
 		ch = EMPTY;
 	}
 }
 
+// WindRun:  Like wind(), for a source with a buffer, but also consumes
+//           the count characters after the current one, which the caller
+//           has scanned in the buffer.
+void Lexer::
+windRun (size_t count)
+{
+	if (accumulating) {
+		lexBuffer += ch;
+		lexBuffer.append(lexSource->Buffer() + lexSource->Position(), count);
+	}
+	lexSource->Skip((int)count);
+	ch = lexSource->NextCharacter();
+}
+
 			
 Lexer::TokenType Lexer::
 ConsumeToken (TokenValue *lvalp)
@@ -209,7 +353,11 @@ PeekToken (TokenValue *lvalp)
 	// consume white space
 	while( 1 ) {
 		if( isspace( ch ) ) {
-			wind( );
+			if( lexSource->Buffer( ) ) {
+				windRun( scanSpace( lexSource->Buffer( ) + lexSource->Position( ) ) );
+			} else {
+				wind( );
+			}
 			continue;
 		} else if( ch == '/' ) {
 			mark( );
@@ -327,7 +475,7 @@ tokenizeNumber (void)
 		} else if ( ch == '.' ) {
 			// This could be a real number or an attribute reference
 			// starting with dot. Look at the second character.
-			int ch2 = lexSource->ReadCharacter();
+			int ch2 = lexSource->NextCharacter();
 			if ( ch2 >= 0 ) {
 				lexSource->UnreadCharacter();
 			}
@@ -493,29 +641,49 @@ int Lexer::
 tokenizeAlphaHead (void)
 {
 	mark( );
-	while (isalpha (ch)) {
-		wind ();
-		// in Visual Studio 2017 x64 isalpha returns 258 when ch==EOF
-		// which could make this an infinite loop if we don't test for EOF explicitly here.
-		if (ch == EOF) break;
-	}
-
-	if (isdigit (ch) || ch == '_') {
-		// The token is an identifier; consume the rest of the token
-		wind ();
-		while (isalnum (ch) || ch == '_') {
+	if (lexSource->Buffer()) {
+		// take the whole token at once; it is a reserved word only if
+		// it is short and all letters
+		windRun (scanIdentifier (lexSource->Buffer() + lexSource->Position()));
+		// a source read in chunks may end a run in the middle of a token
+		while (ch > 0 && isIdentChar (ch)) {
+			windRun (scanIdentifier (lexSource->Buffer() + lexSource->Position()));
+		}
+		cut ();
+		bool letters = lexBuffer.length() <= 9;
+		for (size_t ix = 0; letters && ix < lexBuffer.length(); ix++) {
+			letters = isalpha ((unsigned char)lexBuffer[ix]) != 0;
+		}
+		if ( ! letters) {
+			tokenType = LEX_IDENTIFIER;
+			yylval.SetStringValue( lexBuffer );
+			return tokenType;
+		}
+	} else {
+		while (isalpha (ch)) {
 			wind ();
 			// in Visual Studio 2017 x64 isalpha returns 258 when ch==EOF
 			// which could make this an infinite loop if we don't test for EOF explicitly here.
 			if (ch == EOF) break;
 		}
-		cut ();
 
-		tokenType = LEX_IDENTIFIER;
-		yylval.SetStringValue( lexBuffer.c_str( ) );
-		
-		return tokenType;
-	}	
+		if (isdigit (ch) || ch == '_') {
+			// The token is an identifier; consume the rest of the token
+			wind ();
+			while (isalnum (ch) || ch == '_') {
+				wind ();
+				// in Visual Studio 2017 x64 isalpha returns 258 when ch==EOF
+				// which could make this an infinite loop if we don't test for EOF explicitly here.
+				if (ch == EOF) break;
+			}
+			cut ();
+
+			tokenType = LEX_IDENTIFIER;
+			yylval.SetStringValue( lexBuffer.c_str( ) );
+			
+			return tokenType;
+		}	
+	}
 
 	// check if the string is one of the reserved words; Case insensitive
 	cut ();
@@ -564,6 +732,18 @@ tokenizeString(char delim)
 	while (!stringComplete) {
 		bool oddBackWhacks = false;
 		int oldCh = 0;
+		if( lexSource->Buffer( ) ) {
+			// consume the string literal a run at a time; a backslash
+			// and the character after it are always part of it
+			while( ( ch > 0 ) && ( ch != delim ) ) {
+				if( ch == '\\' ) {
+					wind( );
+					if( ch > 0 ) wind( );
+				} else {
+					windRun( scanString( lexSource->Buffer( ) + lexSource->Position( ), delim, true ) );
+				}
+			}
+		}
 		// consume the string literal; read upto " ignoring \"
 		while( ( ch > 0 ) && ( ch != delim || ( ch == delim && oldCh == '\\' && oddBackWhacks ) ) ) {
 			if( !oddBackWhacks && ch == '\\' ) {
@@ -580,7 +760,7 @@ tokenizeString(char delim)
 			int tempch = ' ';
 			// read past the whitespace characters
 			while (isspace(tempch)) {
-				tempch = lexSource->ReadCharacter();
+				tempch = lexSource->NextCharacter();
 			}
 			if (tempch != delim) {  // a new token exists after the string
 				ch = tempch;
@@ -640,6 +820,12 @@ tokenizeStringOld(char delim)
 	while (!stringComplete) {
 		int oldCh = 0;
 		// consume the string literal; read upto " ignoring \"
+		if( lexSource->Buffer( ) && ( ch > 0 ) && ( ch != delim ) ) {
+			const char *run = lexSource->Buffer( ) + lexSource->Position( );
+			size_t len = scanString( run, delim, false );
+			oldCh = len ? (unsigned char)run[len - 1] : ch;
+			windRun( len );
+		}
 		while( ( ch > 0 ) && ( ch != delim ) ) {
 			oldCh = ch;
 			wind( );
@@ -656,7 +842,7 @@ tokenizeStringOld(char delim)
 			//   continues onwards. So you can't have trailing
 			//   whitespace after a string that ends with a backslash.
 			//   With some contortions, we can handle trailing whitespace.
-			tempch = lexSource->ReadCharacter();
+			tempch = lexSource->NextCharacter();
 			if ( tempch > 0 && tempch != '\n' ) {
 				// more text after quote, quote is part of the string value
 				// remove backslash before quote
@@ -889,7 +1075,7 @@ tokenizePunctOperator (void)
 					break;
 
 				case '!':
-					extra_lookahead = lexSource->ReadCharacter();
+					extra_lookahead = lexSource->NextCharacter();
 					lexSource->UnreadCharacter();
 					if (extra_lookahead == '=') {
 						tokenType = LEX_META_NOT_EQUAL;
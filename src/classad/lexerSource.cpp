@@ -101,6 +101,7 @@ CharLexerSource::~CharLexerSource()
 void CharLexerSource::SetNewSource(const char *string, int offset)
 {
     _string = string;
+    _buffer = string;
     _offset = offset;
 	return;
 }
@@ -169,6 +170,7 @@ StringLexerSource::~StringLexerSource()
 void StringLexerSource::SetNewSource(const string *string, int offset)
 {
 	_string = string;
+	_buffer = string->c_str();
 	_offset = offset;
 	return;
 }
@@ -216,4 +218,167 @@ StringLexerSource::GetCurrentLocation(void) const
 	return _offset;
 }
 
+/*--------------------------------------------------------------------
+ *
+ * ChunkedLexerSource
+ *
+ *-------------------------------------------------------------------*/
+
+ChunkedLexerSource::ChunkedLexerSource(size_t chunk_size)
+{
+	if (chunk_size < 1) {
+		chunk_size = 1;
+	}
+	_chunk_size = chunk_size;
+	// room for the kept character, the chunk and its NUL
+	_chunk = new char[chunk_size + 2];
+	_buffer = _chunk;
+	Reset();
+	return;
+}
+
+ChunkedLexerSource::~ChunkedLexerSource()
+{
+	delete [] _chunk;
+	return;
+}
+
+void
+ChunkedLexerSource::Reset(void)
+{
+	_chunk[0] = 0;
+	_chunk[1] = 0;
+	_offset = 1;
+	_length = 1;
+	_ended = false;
+	_failed = false;
+	_previous_character = EOF;
+	return;
+}
+
+bool
+ChunkedLexerSource::Refill(void)
+{
+	if (_ended || _offset < _length) {
+		// a NUL in the input ends it, as it does for a string
+		return false;
+	}
+
+	_chunk[0] = _chunk[_length - 1];
+	_offset = 1;
+
+	long count = ReadChunk(_chunk + 1, _chunk_size);
+	if (count <= 0) {
+		_ended = true;
+		_failed = (count < 0);
+		count = 0;
+	}
+	_length = 1 + (int)count;
+	_chunk[_length] = 0;
+	return count > 0;
+}
+
+int 
+ChunkedLexerSource::ReadCharacter(void)
+{
+	return NextCharacter();
+}
+
+void 
+ChunkedLexerSource::UnreadCharacter(void)
+{
+	if (_offset > 0) {
+		_offset--;
+	}
+	return;
+}
+
+bool 
+ChunkedLexerSource::AtEnd(void) const
+{
+	if (_offset < _length) {
+		return false;
+	}
+	// we can't tell until we try to read more
+	return ! const_cast<ChunkedLexerSource *>(this)->Refill();
+}
+
+/*--------------------------------------------------------------------
+ *
+ * FileDescriptorLexerSource
+ *
+ *-------------------------------------------------------------------*/
+
+FileDescriptorLexerSource::FileDescriptorLexerSource(int fd, size_t chunk_size)
+	: ChunkedLexerSource(chunk_size)
+{
+	SetNewSource(fd);
+	return;
+}
+
+FileDescriptorLexerSource::~FileDescriptorLexerSource()
+{
+	_fd = -1;
+	return;
+}
+
+void FileDescriptorLexerSource::SetNewSource(int fd)
+{
+	_fd = fd;
+	Reset();
+	return;
+}
+
+long
+FileDescriptorLexerSource::ReadChunk(char *buf, size_t size)
+{
+	if (_fd < 0) {
+		return 0;
+	}
+	long count;
+	do {
+		count = (long)read(_fd, buf, (unsigned int)size);
+	} while (count < 0 && errno == EINTR);
+	return count;
+}
+
+/*--------------------------------------------------------------------
+ *
+ * BufferedFileLexerSource
+ *
+ *-------------------------------------------------------------------*/
+
+BufferedFileLexerSource::BufferedFileLexerSource(FILE *file, size_t chunk_size)
+	: ChunkedLexerSource(chunk_size)
+{
+	SetNewSource(file);
+	return;
+}
+
+BufferedFileLexerSource::~BufferedFileLexerSource()
+{
+	_file = NULL;
+	return;
+}
+
+void BufferedFileLexerSource::SetNewSource(FILE *file)
+{
+	_file = file;
+	Reset();
+	return;
+}
+
+long
+BufferedFileLexerSource::ReadChunk(char *buf, size_t size)
+{
+	if (_file == NULL) {
+		return 0;
+	}
+	size_t count = fread(buf, 1, size, _file);
+	if (count == 0 && ferror(_file)) {
+		return -1;
+	}
+	return (long)count;
+}
+
 }
@@ -25,6 +25,7 @@
 using namespace std;
 
 static char const *ATTR_UNOPTIMIZED_REQUIREMENTS = "UnoptimizedRequirements";
+static char const *ATTR_UNOPTIMIZED_RANK = "UnoptimizedRank";
 
 namespace classad {
 
@@ -328,10 +329,11 @@ OptimizeAdForMatchmaking( ClassAd *ad, bool is_right, std::string *error_msg, co
 		ad->Lookup("other") ||
 		( !left_alias.empty() && ad->Lookup(left_alias) ) ||
 		( !right_alias.empty() && ad->Lookup(right_alias) ) ||
-		ad->Lookup(ATTR_UNOPTIMIZED_REQUIREMENTS) )
+		ad->Lookup(ATTR_UNOPTIMIZED_REQUIREMENTS) ||
+		ad->Lookup(ATTR_UNOPTIMIZED_RANK) )
 	{
 		if( error_msg ) {
-			*error_msg = "Optimization of matchmaking requirements failed, because ad already contains one of my, target, other, or UnoptimizedRequirements.";
+			*error_msg = "Optimization of matchmaking requirements failed, because ad already contains one of my, target, other, UnoptimizedRequirements, or UnoptimizedRank.";
 		}
 		return false;
 	}
@@ -377,48 +379,14 @@ OptimizeAdForMatchmaking( ClassAd *ad, bool is_right, std::string *error_msg, co
 	}
 
 
-	ExprTree *flat_requirements = NULL;
-	Value flat_val;
-
-	if( ad->FlattenAndInline(requirements,flat_val,flat_requirements) ) {
-		if( !flat_requirements ) {
-				// flattened to a value
-			flat_requirements = Literal::MakeLiteral(flat_val);
-		}
-		if( flat_requirements ) {
-				// save original requirements
-			ExprTree *orig_requirements = ad->Remove(ATTR_REQUIREMENTS);
-			if( orig_requirements ) {
-				if( !ad->Insert(ATTR_UNOPTIMIZED_REQUIREMENTS,orig_requirements) )
-				{
-						// Now we have no requirements.  Very bad!
-					if( error_msg ) {
-						*error_msg = "Failed to rename original requirements.";
-					}
-					delete orig_requirements;
-					delete flat_requirements;
-					return false;
-				}
-			}
-
-				// insert new flattened requirements
-			if( !ad->Insert(ATTR_REQUIREMENTS,flat_requirements) ) {
-				if( error_msg ) {
-					*error_msg = "Failed to insert optimized requirements.";
-				}
-				delete flat_requirements;
-				return false;
-			}
-		}
+	if( !FlattenForMatchmaking( ad, ATTR_REQUIREMENTS, ATTR_UNOPTIMIZED_REQUIREMENTS, error_msg ) ) {
+		return false;
 	}
 
 		// After flatenning, no references should remain to MY or TARGET.
 		// Even if there are, those can be resolved by the context ads, so
 		// we don't need to leave these attributes in the ad.
 	// TODO The failure cases above should run this cleanup code
-	if ( !_useOldClassAdSemantics ) {
-		ad->Delete("my");
-	}
 	ad->Delete("other"); 
 	ad->Delete("target");
 	if ( !left_alias.empty() ) {
@@ -428,18 +396,98 @@ OptimizeAdForMatchmaking( ClassAd *ad, bool is_right, std::string *error_msg, co
 		ad->Delete( right_alias );
 	}
 
+		// Rank is flattened without target, other or the aliases, so
+		// what is left of it still works whichever side of a match the
+		// ad is evaluated on.  That way the parts of it that only depend
+		// on this ad are evaluated once here rather than for every
+		// candidate.
+	bool rank_ok = FlattenForMatchmaking( ad, ATTR_RANK, ATTR_UNOPTIMIZED_RANK, error_msg );
+
+	if ( !_useOldClassAdSemantics ) {
+		ad->Delete("my");
+	}
+
+		// a caller that sees the failure won't unoptimize the ad, so
+		// put back the Requirements that was already replaced
+	if( !rank_ok ) {
+		UnoptimizeAdForMatchmaking( ad );
+	}
+
+	return rank_ok;
+}
+
+bool MatchClassAd::
+FlattenForMatchmaking( ClassAd *ad, const char *name, const char *saved_name, std::string *error_msg )
+{
+	ExprTree *expr = ad->Lookup(name);
+	if( !expr ) {
+		return true;
+	}
+
+	ExprTree *flat_expr = NULL;
+	Value flat_val;
+
+	if( !ad->FlattenAndInline(expr,flat_val,flat_expr) ) {
+		return true;
+	}
+	if( !flat_expr ) {
+			// flattened to a value
+		flat_expr = Literal::MakeLiteral(flat_val);
+		if( !flat_expr ) {
+			return true;
+		}
+	}
+
+		// save original expression
+	ExprTree *orig_expr = ad->Remove(name);
+	if( orig_expr ) {
+		if( !ad->Insert(saved_name,orig_expr) )
+		{
+				// Now we have no expression.  Very bad!
+			if( error_msg ) {
+				*error_msg = std::string("Failed to rename original ") + name + ".";
+			}
+			delete orig_expr;
+			delete flat_expr;
+			return false;
+		}
+	}
+
+		// insert new flattened expression
+	if( !ad->Insert(name,flat_expr) ) {
+		if( error_msg ) {
+			*error_msg = std::string("Failed to insert optimized ") + name + ".";
+		}
+		delete flat_expr;
+		return false;
+	}
 	return true;
 }
 
 bool MatchClassAd::
 UnoptimizeAdForMatchmaking( ClassAd *ad )
 {
+		// Remove() would only hide expressions saved in a chained
+		// parent behind undefined ones, so stand the ad on its own
+	if( ad->GetChainedParentAd() &&
+		( ad->Lookup(ATTR_UNOPTIMIZED_REQUIREMENTS) ||
+		  ad->Lookup(ATTR_UNOPTIMIZED_RANK) ) )
+	{
+		ad->ChainCollapse();
+	}
+
 	ExprTree *orig_requirements = ad->Remove(ATTR_UNOPTIMIZED_REQUIREMENTS);
 	if( orig_requirements ) {
 		if( !ad->Insert(ATTR_REQUIREMENTS,orig_requirements) ) {
 			return false;
 		}
 	}
+	ExprTree *orig_rank = ad->Remove(ATTR_UNOPTIMIZED_RANK);
+	if( orig_rank ) {
+		if( !ad->Insert(ATTR_RANK,orig_rank) ) {
+			return false;
+		}
+	}
 	return true;
 }
 
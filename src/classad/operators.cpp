@@ -19,6 +19,7 @@
 
 #include "classad/common.h"
 #include "classad/operators.h"
+#include "classad/compiledExpr.h"
 #include "classad/sink.h"
 #include "classad/util.h"
 
@@ -29,6 +30,7 @@ namespace classad {
 Operation::
 ~Operation ()
 {
+	delete compiled.load();
 }
 
 Operation1::
@@ -481,6 +483,44 @@ _Evaluate (EvalState &state, Value &result) const
 
 bool Operation::
 _Evaluate (EvalState &state, Value &result) const
+{
+	const CompiledExpr *code = compiledForm();
+	if( code ) {
+		return code->Evaluate( state, result );
+	}
+	return evaluateTree( state, result );
+}
+
+const CompiledExpr *Operation::
+compiledForm( ) const
+{
+	int threshold = ClassAdGetCompileThreshold();
+	if( threshold <= 0 ) {
+		return NULL;
+	}
+
+	CompiledExpr *code = compiled.load( std::memory_order_acquire );
+	if( code ) {
+		return code->OldSemantics() == _useOldClassAdSemantics ? code : NULL;
+	}
+	if( evaluations.load( std::memory_order_relaxed ) < threshold - 1 ) {
+		evaluations.fetch_add( 1, std::memory_order_relaxed );
+		return NULL;
+	}
+
+		// several threads may get here at once; the first one to finish
+		// compiling wins
+	code = CompiledExpr::Compile( this );
+	CompiledExpr *expected = NULL;
+	if( !compiled.compare_exchange_strong( expected, code, std::memory_order_acq_rel ) ) {
+		delete code;
+		code = expected;
+	}
+	return code;
+}
+
+bool Operation::
+evaluateTree (EvalState &state, Value &result) const
 {
 	Value	val1, val2, val3;
 	bool	valid1, valid2, valid3;
@@ -23,6 +23,7 @@
 #include "classad/classad.h"
 #include "classad/lexer.h"
 #include "classad/util.h"
+#include "classad/classadArena.h"
 
 using namespace std;
 
@@ -63,6 +64,7 @@ GetOldClassAd()
 bool ClassAdParser::
 ParseExpression( const string &buffer, ExprTree *&tree, bool full )
 {
+	ClassAdArena::Parsing parsing;
 	bool              success;
 	StringLexerSource lexer_source(&buffer);
 
@@ -77,6 +79,7 @@ ParseExpression( const string &buffer, ExprTree *&tree, bool full )
 bool ClassAdParser::
 ParseExpression( const char *buffer, ExprTree *&tree, bool full )
 {
+	ClassAdArena::Parsing parsing;
 	bool              success;
 	CharLexerSource lexer_source(buffer);
 
@@ -91,6 +94,7 @@ ParseExpression( const char *buffer, ExprTree *&tree, bool full )
 bool ClassAdParser::
 ParseExpression( LexerSource *lexer_source, ExprTree *&tree, bool full )
 {
+	ClassAdArena::Parsing parsing;
 	bool              success;
 
 	success      = false;
@@ -105,6 +109,7 @@ ParseExpression( LexerSource *lexer_source, ExprTree *&tree, bool full )
 ExprTree *ClassAdParser::
 ParseExpression( const string &buffer, bool full)
 {
+	ClassAdArena::Parsing parsing;
 	ExprTree          *tree;
 	StringLexerSource lexer_source(&buffer);
 
@@ -124,6 +129,7 @@ ParseExpression( const string &buffer, bool full)
 ExprTree *ClassAdParser::
 ParseExpression( const char *buffer, bool full)
 {
+	ClassAdArena::Parsing parsing;
 	ExprTree          *tree;
 	CharLexerSource lexer_source(buffer);
 
@@ -143,6 +149,7 @@ ParseExpression( const char *buffer, bool full)
 ExprTree *ClassAdParser::
 ParseExpression( LexerSource *lexer_source, bool full )
 {
+	ClassAdArena::Parsing parsing;
 	ExprTree          *tree;
 
 	tree = NULL;
@@ -161,6 +168,7 @@ ParseExpression( LexerSource *lexer_source, bool full )
 ExprTree *ClassAdParser::
 ParseNextExpression(void)
 {
+	ClassAdArena::Parsing parsing;
     ExprTree *tree;
 
     tree = NULL;
@@ -241,6 +249,7 @@ bool ClassAdParser::ParseClassAd(FILE *file, ClassAd &classad, bool full)
 bool ClassAdParser::
 ParseClassAd(LexerSource *lexer_source, ClassAd &classad, bool full)
 {
+	ClassAdArena::Parsing parsing;
 	bool              success;
 
 	success      = false;
@@ -321,6 +330,7 @@ ParseClassAd(FILE *file, bool full)
 ClassAd *ClassAdParser::
 ParseClassAd(LexerSource *lexer_source, bool full)
 {
+	ClassAdArena::Parsing parsing;
 	ClassAd  *ad;
 
 	ad = new ClassAd;
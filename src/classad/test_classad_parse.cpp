@@ -22,7 +22,14 @@
 #include <time.h>
 
 #include "classad/classad.h"
+#include "classad/classadArena.h"
 #include "classad/classadCache.h"
+#include "classad/binarySink.h"
+#include "classad/matchClassad.h"
+#include "classad/source.h"
+#include "classad/lexerSource.h"
+#include "classad/sink.h"
+#include "classad/binarySource.h"
 
 using namespace std;
 using namespace classad;
@@ -275,7 +282,316 @@ static int get_image_size()
 #endif
 
 // --------------------------------------------------------------------
-int parse_ads(bool with_cache, bool verbose=false, bool lazy=false)
+// Time writing the ads out and reading them back in, once as the
+// "attr = value" text that putClassAd sends and once in the binary
+// encoding.  The binary name table is kept across ads as it would be
+// for the ads of one query reply.
+int time_encodings(vector< classad_shared_ptr<ClassAd> > &ads, int passes)
+{
+	int mismatches = 0;
+	size_t text_bytes = 0, binary_bytes = 0;
+
+	ClassAdUnParser unparser;
+	unparser.SetOldClassAd(true, true);
+	ClassAdParser parser;
+	parser.SetOldClassAd(true);
+	string line;
+
+	clock_t Start = clock();
+	for (int pass = 0; pass < passes; ++pass) {
+		for (size_t ix = 0; ix < ads.size(); ++ix) {
+			ClassAd copy;
+			for (AttrList::const_iterator it = ads[ix]->begin(); it != ads[ix]->end(); ++it) {
+				line = it->first;
+				line += " = ";
+				unparser.Unparse(line, it->second);
+				text_bytes += line.size();
+				ExprTree *tree = parser.ParseExpression(line.c_str() + it->first.size() + 3);
+				if ( ! tree || ! copy.Insert(it->first, tree)) {
+					++mismatches;
+				}
+			}
+			if (pass == 0 && ! copy.SameAs(ads[ix].get())) { ++mismatches; }
+		}
+	}
+	clock_t textTime = clock() - Start;
+
+	ClassAdBinaryUnParser binary_unparser;
+	ClassAdBinaryParser binary_parser;
+	string buf;
+
+	Start = clock();
+	for (int pass = 0; pass < passes; ++pass) {
+		for (size_t ix = 0; ix < ads.size(); ++ix) {
+			ClassAd copy;
+			buf.clear();
+			if ( ! binary_unparser.Unparse(buf, ads[ix].get()) ||
+				! binary_parser.ParseClassAd(buf.data(), buf.size(), copy)) {
+				++mismatches;
+			}
+			binary_bytes += buf.size();
+			if (pass == 0 && ! copy.SameAs(ads[ix].get())) { ++mismatches; }
+		}
+	}
+	clock_t binaryTime = clock() - Start;
+
+	double text_secs = (1.0*textTime)/CLOCKS_PER_SEC;
+	double binary_secs = (1.0*binaryTime)/CLOCKS_PER_SEC;
+	fprintf(stdout, "text Serialize+Parse Time: %.6f (%d ads, %d passes, %lu bytes)\n",
+		text_secs, (int)ads.size(), passes, (unsigned long)text_bytes);
+	fprintf(stdout, "binary Serialize+Parse Time: %.6f (%d ads, %d passes, %lu bytes)\n",
+		binary_secs, (int)ads.size(), passes, (unsigned long)binary_bytes);
+	if (binary_secs > 0) {
+		fprintf(stdout, "binary speedup: %.2fx, size %.0f%% of text\n",
+			text_secs / binary_secs, text_bytes ? (100.0 * binary_bytes) / text_bytes : 0.0);
+	}
+	if (mismatches) {
+		fprintf(stdout, "ERROR: %d ads or attributes did not survive the round trip\n", mismatches);
+		return 1;
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------------
+// Time evaluating the match expressions of each ad against the next one,
+// first by walking the trees and then using their compiled forms, and
+// check that both give the same values.
+int time_compiled(vector< classad_shared_ptr<ClassAd> > &ads, int passes)
+{
+	static const char * match_attrs[] = { "Requirements", "Rank", "START", "PeriodicHold" };
+	int mismatches = 0;
+	vector<Value> tree_values;
+	clock_t times[2] = { 0, 0 };
+
+	for (int compiled = 0; compiled < 2; ++compiled) {
+		ClassAdSetCompileThreshold(compiled ? 1 : 0);
+		clock_t Start = clock();
+		for (int pass = 0; pass < passes; ++pass) {
+			size_t iv = 0;
+			for (size_t ix = 0; ix + 1 < ads.size(); ++ix) {
+				MatchClassAd mad(ads[ix].get(), ads[ix+1].get());
+				for (int ia = 0; ia < NUMELMS(match_attrs); ++ia) {
+					Value val;
+					if ( ! ads[ix]->Lookup(match_attrs[ia])) continue;
+					ads[ix]->EvaluateAttr(match_attrs[ia], val);
+					if (pass > 0) continue;
+					if ( ! compiled) {
+						tree_values.push_back(val);
+					} else if ( ! tree_values[iv++].SameAs(val)) {
+						++mismatches;
+					}
+				}
+				mad.RemoveLeftAd();
+				mad.RemoveRightAd();
+			}
+		}
+		times[compiled] = clock() - Start;
+	}
+	ClassAdSetCompileThreshold(0);
+
+	double tree_secs = (1.0*times[0])/CLOCKS_PER_SEC;
+	double compiled_secs = (1.0*times[1])/CLOCKS_PER_SEC;
+	fprintf(stdout, "tree Eval Time: %.6f (%d values, %d passes)\n",
+		tree_secs, (int)tree_values.size(), passes);
+	fprintf(stdout, "compiled Eval Time: %.6f\n", compiled_secs);
+	if (compiled_secs > 0) {
+		fprintf(stdout, "compiled speedup: %.2fx\n", tree_secs / compiled_secs);
+	}
+	if (mismatches) {
+		fprintf(stdout, "ERROR: %d values differ between the tree and the compiled form\n", mismatches);
+		return 1;
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------------
+// Time making a working copy of each ad, as the negotiator does with the
+// slot ads it keeps between cycles, changing it and matching it against
+// the next ad; first with deep copies and then with ads chained to the
+// shared originals.  Check that both give the same values.
+int time_chained(vector< classad_shared_ptr<ClassAd> > &ads, int passes)
+{
+	static const char * match_attrs[] = { "Requirements", "Rank", "START", "PeriodicHold" };
+	int mismatches = 0;
+	vector<Value> copy_values;
+	clock_t times[2] = { 0, 0 };
+	int mem[2] = { 0, 0 };
+
+	for (int chained = 0; chained < 2; ++chained) {
+		clock_t Start = clock();
+		for (int pass = 0; pass < passes; ++pass) {
+			int before_size = get_image_size();
+			vector<ClassAd *> copies;
+			copies.reserve(ads.size());
+			for (size_t ix = 0; ix < ads.size(); ++ix) {
+				ClassAd *copy;
+				if (chained) {
+					copy = new ClassAd();
+					copy->ChainToSharedAd(ads[ix]);
+				} else {
+					copy = new ClassAd(*ads[ix]);
+				}
+				copy->InsertAttr("RemoteUser", "user@example.org");
+				copy->InsertAttr("CurrentRank", 1.0);
+				copies.push_back(copy);
+			}
+			if (pass == 0) {
+				mem[chained] = get_image_size() - before_size;
+			}
+
+			size_t iv = 0;
+			for (size_t ix = 0; ix + 1 < copies.size(); ++ix) {
+				MatchClassAd mad(copies[ix], copies[ix+1]);
+				for (int ia = 0; ia < NUMELMS(match_attrs); ++ia) {
+					Value val;
+					if ( ! copies[ix]->Lookup(match_attrs[ia])) continue;
+					copies[ix]->EvaluateAttr(match_attrs[ia], val);
+					if (pass > 0) continue;
+					if ( ! chained) {
+						copy_values.push_back(val);
+					} else if ( ! copy_values[iv++].SameAs(val)) {
+						++mismatches;
+					}
+				}
+				mad.RemoveLeftAd();
+				mad.RemoveRightAd();
+			}
+			for (size_t ix = 0; ix < copies.size(); ++ix) {
+				delete copies[ix];
+			}
+		}
+		times[chained] = clock() - Start;
+	}
+
+	double copy_secs = (1.0*times[0])/CLOCKS_PER_SEC;
+	double chained_secs = (1.0*times[1])/CLOCKS_PER_SEC;
+	fprintf(stdout, "copied Copy+Match Time: %.6f (%d ads, %d passes, %d Kb)\n",
+		copy_secs, (int)ads.size(), passes, mem[0]);
+	fprintf(stdout, "chained Copy+Match Time: %.6f (%d Kb)\n", chained_secs, mem[1]);
+	if (chained_secs > 0) {
+		fprintf(stdout, "chained speedup: %.2fx\n", copy_secs / chained_secs);
+	}
+	if (mismatches) {
+		fprintf(stdout, "ERROR: %d values differ between copied and chained ads\n", mismatches);
+		return 1;
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------------
+// Hands the lexer one character per virtual call, as all sources did
+// before the lexer learned to scan the buffers of in-memory sources.
+class SlowLexerSource : public LexerSource
+{
+public:
+	SlowLexerSource(const char *str) : _str(str), _pos(0) {}
+	virtual int ReadCharacter(void) {
+		int character = (unsigned char)_str[_pos];
+		if (character == 0) { character = EOF; } else { _pos++; }
+		_previous_character = character;
+		return character;
+	}
+	virtual void UnreadCharacter(void) { if (_pos > 0) _pos--; }
+	virtual bool AtEnd(void) const { return _str[_pos] == 0; }
+private:
+	const char *_str;
+	int         _pos;
+};
+
+// Time parsing the values of "attr = value" lines with the lexer reading
+// a character at a time and scanning the buffer, and check that both give
+// the same expressions.  The lines come from the given file, a history
+// file or job_queue.log, or else from the ads.
+int time_lexing(vector< classad_shared_ptr<ClassAd> > &ads, const char * filename, int passes)
+{
+	vector<string> values;
+	size_t bytes = 0;
+	if (filename) {
+		FILE *file = fopen(filename, "r");
+		if ( ! file) {
+			fprintf(stdout, "ERROR: cannot open %s\n", filename);
+			return 1;
+		}
+		char line[64*1024];
+		while (fgets(line, sizeof(line), file)) {
+			line[strcspn(line, "\r\n")] = 0;
+			const char *rhs = NULL;
+			int op = 0, pos = 0;
+			if (sscanf(line, "%d %*s %*s %n", &op, &pos) >= 1 && op == 103 && pos > 0) {
+				rhs = line + pos;	// job_queue.log SetAttribute
+			} else if (line[0] != '*' && strchr(line, '=')) {
+				rhs = strchr(line, '=') + 1;	// history or -long form
+				while (*rhs == ' ') ++rhs;
+			}
+			if (rhs && *rhs) { values.push_back(rhs); }
+		}
+		fclose(file);
+	} else {
+		ClassAdUnParser unparser;
+		unparser.SetOldClassAd(true, true);
+		for (size_t ix = 0; ix < ads.size(); ++ix) {
+			for (AttrList::const_iterator it = ads[ix]->begin(); it != ads[ix]->end(); ++it) {
+				values.push_back("");
+				unparser.Unparse(values.back(), it->second);
+			}
+		}
+	}
+	for (size_t ix = 0; ix < values.size(); ++ix) { bytes += values[ix].size(); }
+
+	int mismatches = 0;
+	ClassAdParser parser;
+	parser.SetOldClassAd(true);
+	for (size_t ix = 0; ix < values.size(); ++ix) {
+		SlowLexerSource slow_source(values[ix].c_str());
+		ExprTree *slow = parser.ParseExpression(&slow_source, true);
+		CharLexerSource source(values[ix].c_str());
+		ExprTree *tree = parser.ParseExpression(&source, true);
+		if ((slow == NULL) != (tree == NULL) || (tree && ! tree->SameAs(slow))) {
+			++mismatches;
+		}
+		delete slow;
+		delete tree;
+	}
+
+	clock_t times[2] = { 0, 0 };
+	for (int scan = 0; scan < 2; ++scan) {
+		clock_t Start = clock();
+		for (int pass = 0; pass < passes; ++pass) {
+			for (size_t ix = 0; ix < values.size(); ++ix) {
+				ExprTree *tree;
+				if (scan) {
+					CharLexerSource source(values[ix].c_str());
+					tree = parser.ParseExpression(&source, true);
+				} else {
+					SlowLexerSource source(values[ix].c_str());
+					tree = parser.ParseExpression(&source, true);
+				}
+				delete tree;
+			}
+		}
+		times[scan] = clock() - Start;
+	}
+
+	double slow_secs = (1.0*times[0])/CLOCKS_PER_SEC;
+	double scan_secs = (1.0*times[1])/CLOCKS_PER_SEC;
+	double mb = (1.0 * bytes * passes) / (1024*1024);
+	fprintf(stdout, "char-at-a-time Lex+Parse Time: %.6f (%d values, %d passes, %.1f MB/s)\n",
+		slow_secs, (int)values.size(), passes, slow_secs > 0 ? mb / slow_secs : 0.0);
+	fprintf(stdout, "buffer-scan Lex+Parse Time: %.6f (%.1f MB/s)\n",
+		scan_secs, scan_secs > 0 ? mb / scan_secs : 0.0);
+	if (scan_secs > 0) {
+		fprintf(stdout, "buffer-scan speedup: %.2fx\n", slow_secs / scan_secs);
+	}
+	if (mismatches) {
+		fprintf(stdout, "ERROR: %d values parse differently when the buffer is scanned\n", mismatches);
+		return 1;
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------------
+int parse_ads(bool with_cache, bool verbose=false, bool lazy=false, int encoding_passes=0, int compile_passes=0, bool use_arena=false,
+	int lex_passes=0, const char * lex_file=NULL, int chain_passes=0)
 {
 	int barf_counter = 0;
 	int rval = 0;
@@ -299,6 +615,11 @@ int parse_ads(bool with_cache, bool verbose=false, bool lazy=false)
 
 	string szInput, name, szValue;
 	szInput.reserve(longest_kvp);
+
+	// with -arena, parse all of the ads into one arena; compare the Parse and Delete times with a run without it
+	classad_shared_ptr<ClassAdArena::Batch> batch;
+	if (use_arena) { batch.reset(new ClassAdArena::Batch()); }
+
 	clock_t Start = clock();
 
 	while ( !infile.fail() && !infile.eof() )
@@ -349,6 +670,12 @@ int parse_ads(bool with_cache, bool verbose=false, bool lazy=false)
 
 	int after_size = get_image_size();
 	fprintf(stdout, "%s Parse Mem (Kb): %d (%d - %d)\n", mode, after_size - before_size, after_size, before_size);
+	if (batch) {
+		fprintf(stdout, "%s Arena: %lu nodes in %lu blocks (%lu bytes)\n", mode,
+			(unsigned long)batch->Arena().Allocations(), (unsigned long)batch->Arena().Blocks(),
+			(unsigned long)batch->Arena().Bytes());
+		batch.reset();
+	}
 
 	// enable this to look at the cache contents and debug data
 #ifdef TJ_NEWCACHE
@@ -356,6 +683,19 @@ int parse_ads(bool with_cache, bool verbose=false, bool lazy=false)
 	CachedExprEnvelope::_debug_dump_keys("output.txt");
 #endif
 
+	if (encoding_passes > 0 && ! rval) {
+		rval = time_encodings(ads, encoding_passes);
+	}
+	if (compile_passes > 0 && ! rval) {
+		rval = time_compiled(ads, compile_passes);
+	}
+	if (lex_passes > 0 && ! rval) {
+		rval = time_lexing(ads, lex_file, lex_passes);
+	}
+	if (chain_passes > 0 && ! rval) {
+		rval = time_chained(ads, chain_passes);
+	}
+
 	clock_t delBegin = clock();
 	ads.clear();
 	clock_t delEnd = clock();
@@ -373,6 +713,12 @@ int main(int argc, const char ** argv)
 	bool verbose = false;
 	bool lazy = false;
 	bool generate_ads_only = false;
+	int encoding_passes = 0;
+	int compile_passes = 0;
+	bool use_arena = false;
+	int lex_passes = 0;
+	const char * lex_file = NULL;
+	int chain_passes = 0;
 	for (int ii = 0; ii < argc; ++ii) {
 		if (strcmp(argv[ii],"-cache") == 0) {
 			with_cache = true;
@@ -384,6 +730,36 @@ int main(int argc, const char ** argv)
 			verbose = true;
 		} else if (strcmp(argv[ii], "-g") == 0) {
 			generate_ads_only = true;
+		} else if (strcmp(argv[ii], "-encode") == 0) {
+			// -encode [passes] : compare text and binary serialize+parse time
+			encoding_passes = 10;
+			if (ii+1 < argc && argv[ii+1][0] != '-') {
+				encoding_passes = atoi(argv[++ii]);
+			}
+		} else if (strcmp(argv[ii], "-compile") == 0) {
+			// -compile [passes] : compare tree and compiled evaluation time
+			compile_passes = 10;
+			if (ii+1 < argc && argv[ii+1][0] != '-') {
+				compile_passes = atoi(argv[++ii]);
+			}
+		} else if (strcmp(argv[ii], "-arena") == 0) {
+			use_arena = true;
+		} else if (strcmp(argv[ii], "-lex") == 0) {
+			// -lex [file] [passes] : compare char-at-a-time and buffer-scan lexing
+			// of the values in a history file or job_queue.log, or of the generated ads
+			lex_passes = 10;
+			if (ii+1 < argc && argv[ii+1][0] != '-' && ! isdigit(argv[ii+1][0])) {
+				lex_file = argv[++ii];
+			}
+			if (ii+1 < argc && isdigit(argv[ii+1][0])) {
+				lex_passes = atoi(argv[++ii]);
+			}
+		} else if (strcmp(argv[ii], "-chain") == 0) {
+			// -chain [passes] : compare deep copies and chained copies of the ads
+			chain_passes = 10;
+			if (ii+1 < argc && argv[ii+1][0] != '-') {
+				chain_passes = atoi(argv[++ii]);
+			}
 		}
 	}
 
@@ -402,5 +778,5 @@ int main(int argc, const char ** argv)
 		return 0;
 	}
 
-	return parse_ads(with_cache, verbose, lazy);
+	return parse_ads(with_cache, verbose, lazy, encoding_passes, compile_passes, use_arena, lex_passes, lex_file, chain_passes);
 }
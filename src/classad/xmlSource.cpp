@@ -108,6 +108,26 @@ ParseClassAd(FILE *file)
 	return classad;
 }
 
+bool ClassAdXMLParser::
+ParseClassAd(LexerSource *lexer_source, ClassAd &ad)
+{
+	ClassAd *classad_out;
+
+	lexer.SetLexerSource(lexer_source);
+	classad_out = ParseClassAd(&ad);
+	return classad_out != NULL;
+}
+
+ClassAd *ClassAdXMLParser::
+ParseClassAd(LexerSource *lexer_source)
+{
+	ClassAd *classad;
+
+	lexer.SetLexerSource(lexer_source);
+	classad = ParseClassAd();
+	return classad;
+}
+
 ClassAd *ClassAdXMLParser::
 ParseClassAd(ClassAd *classad_in)
 {
@@ -73,9 +73,13 @@ ClassAd* CollectorDaemon::__query__;
 int CollectorDaemon::__numAds__;
 int CollectorDaemon::__resultLimit__;
 int CollectorDaemon::__failed__;
-List<ClassAd>* CollectorDaemon::__ClassAdResultList__;
+CollectorDaemon::QueryResultSink CollectorDaemon::__resultSink__;
+void * CollectorDaemon::__resultSinkData__;
 std::string CollectorDaemon::__adType__;
 ExprTree *CollectorDaemon::__filter__;
+classad::BatchEval *CollectorDaemon::__batchEval__;
+vector<ClassAd*> CollectorDaemon::__batch__;
+int CollectorDaemon::__batchLimit__;
 
 TrackTotals* CollectorDaemon::normalTotals = NULL;
 int CollectorDaemon::submittorRunningJobs;
@@ -112,6 +116,8 @@ int CollectorDaemon::max_pending_query_workers = 50;
 int CollectorDaemon::max_query_worktime = 0;
 int CollectorDaemon::active_query_workers = 0;
 int CollectorDaemon::pending_query_workers = 0;
+bool CollectorDaemon::snapshot_queries = false;
+int CollectorDaemon::max_watches = 100;
 
 #ifdef TRACK_QUERIES_BY_SUBSYS
 bool CollectorDaemon::want_track_queries_by_subsys = false;
@@ -349,6 +355,8 @@ void CollectorDaemon::Init()
 		receive_query_cedar,"receive_query_cedar",READ);
 	daemonCore->Register_CommandWithPayload(QUERY_GENERIC_ADS,"QUERY_GENERIC_ADS",
 		receive_query_cedar,"receive_query_cedar",READ);
+	daemonCore->Register_CommandWithPayload(WATCH_ADS,"WATCH_ADS",
+		receive_watch,"receive_watch",READ);
 	
 	// install command handlers for invalidations
 	daemonCore->Register_CommandWithPayload(INVALIDATE_STARTD_ADS,"INVALIDATE_STARTD_ADS",
@@ -393,6 +401,8 @@ void CollectorDaemon::Init()
 		receive_update,"receive_update",ADVERTISE_STARTD_PERM);
 	daemonCore->Register_CommandWithPayload(MERGE_STARTD_AD,"MERGE_STARTD_AD",
 		receive_update,"receive_update",NEGOTIATOR);
+	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_AD_DELTA,"UPDATE_STARTD_AD_DELTA",
+		receive_update,"receive_update",ADVERTISE_STARTD_PERM);
 	daemonCore->Register_CommandWithPayload(UPDATE_SCHEDD_AD,"UPDATE_SCHEDD_AD",
 		receive_update,"receive_update",ADVERTISE_SCHEDD_PERM);
 	daemonCore->Register_CommandWithPayload(UPDATE_SUBMITTOR_AD,"UPDATE_SUBMITTOR_AD",
@@ -475,6 +485,45 @@ void CollectorDaemon::Init()
 	}	
 }
 
+// In-process query handler used when COLLECTOR_SNAPSHOT_QUERIES is true.
+// Rather than forking a worker, the query is evaluated against the tables
+// immediately and the matching ads are held in a snapshot; the collector
+// engine will not free any of those ads until the snapshot is released.
+// The results are then written to the client without blocking: whenever
+// the socket would block, we register it with DaemonCore and return to the
+// event loop, so updates and other queries are handled while a slow client
+// drains its results.
+class CollectorQueryContinuation : public Service {
+public:
+	CollectorQueryContinuation(ClassAd *query, AdTypes whichAds, bool is_locate, const char *subsys);
+	~CollectorQueryContinuation();
+
+	int start(Stream *sock);
+	int finish(Stream *sock);
+
+private:
+	void logQueryInfo(Stream *sock);
+
+	ClassAd *m_query;
+	List<ClassAd> m_results;
+	AdTypes m_whichAds;
+	bool m_is_locate;
+	bool m_filter_private_ads;
+	bool m_evaluate_projection;
+	bool m_unfinished_eom;
+	bool m_registered_socket;
+	unsigned long m_epoch;
+	std::string m_projection;
+	classad::References m_proj;
+	std::string m_subsys;
+	std::string m_requirements;
+	int m_matched;
+	int m_skipped;
+	int m_limit;
+	double m_begin;
+	double m_end_query;
+};
+
 collector_runtime_probe HandleQuery_runtime;
 collector_runtime_probe HandleLocate_runtime;
 collector_runtime_probe HandleQueryForked_runtime;
@@ -557,7 +606,7 @@ int CollectorDaemon::receive_query_cedar(int command,
 		}
 	}
 	// If we are not allowed any forked query workers, i guess we are going in-proc
-	if ( max_query_workers < 1 ) {
+	if ( max_query_workers < 1 || snapshot_queries ) {
 		handle_in_proc = true;
 	}
 
@@ -599,7 +648,14 @@ int CollectorDaemon::receive_query_cedar(int command,
 
 	// Now we are ready to either invoke a worker thread directly to handle the query,
 	// or enqueue a request to run the worker thread later.
-	if ( handle_in_proc ) {
+	if ( snapshot_queries ) {
+		// Serve the query from a snapshot of the tables in this process,
+		// writing results without blocking the rest of the collector.
+		dprintf(D_FULLDEBUG,"QuerySnapshot: about to handle query in-process\n");
+		CollectorQueryContinuation *cont = new CollectorQueryContinuation(cad, whichAds, is_locate, query_entry->subsys);
+		cad = NULL; // the continuation owns the query ad now
+		return_status = cont->start(sock);
+	} else if ( handle_in_proc ) {
 		// We want to immediately handle the query inline in this process.
 		// So in this case, we simply directly invoke our worker thread function.
 		dprintf(D_FULLDEBUG,"QueryWorker: about to handle query in-process\n");
@@ -829,57 +885,34 @@ int CollectorDaemon::QueryReaper(int pid, int /* exit_status */ )
 }
 
 
-int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Stream* sock)
+bool CollectorDaemon::filter_private_ads_for_peer(Stream *sock, AdTypes whichAds)
 {
-	int return_status = TRUE;
-	double begin = condor_gettimestamp_double();
-	List<ClassAd> results;
+		// Always send private attributes in private ads.
+	if (whichAds == STARTD_PVT_AD) {
+		return false;
+	}
 
 		// If our peer is at least 8.9.3 and has NEGOTIATOR authz, then we'll
 		// trust it to handle our capabilities.
-	bool filter_private_ads = true;
 	auto *verinfo = sock->get_peer_version();
 	if (verinfo && verinfo->built_since_version(8, 9, 3)) {
 		auto addr = static_cast<ReliSock*>(sock)->peer_addr();
 			// Given failure here is non-fatal, do not log at D_ALWAYS.
 		if (static_cast<Sock*>(sock)->isAuthorizationInBoundingSet("NEGOTIATOR") &&
 			(USER_AUTH_SUCCESS == daemonCore->Verify("send private ads", NEGOTIATOR, addr, static_cast<ReliSock*>(sock)->getFullyQualifiedUser(), D_SECURITY|D_FULLDEBUG))) {
-			filter_private_ads = false;
+			return false;
 		}
 	}
+	return true;
+}
 
-	// Pull out relavent state from query_entry
-	pending_query_entry_t *query_entry = (pending_query_entry_t *) in_query_entry;
-	ClassAd *cad = query_entry->cad;
-	bool is_locate = query_entry->is_locate;
-	AdTypes whichAds = query_entry->whichAds;
-
-		// Always send private attributes in private ads.
-	if (whichAds == STARTD_PVT_AD) {
-		filter_private_ads = false;
-	}
-
-	// Perform the query
-
-	if (whichAds != (AdTypes) -1) {
-		process_query_public (whichAds, cad, &results);
-	}
-
-	double end_query = condor_gettimestamp_double();
-	double end_write = 0.0;
-
-	// send the results via cedar			
-	sock->timeout(QueryTimeout); // set up a network timeout of a longer duration
-	sock->encode();
-	results.Rewind();
-	ClassAd *curr_ad = NULL;
-	int more = 1;
-	
-		// See if query ad asks for server-side projection
-	string projection = "";
-		// turn projection string into a set of attributes
-	classad::References proj;
-	bool evaluate_projection = false;
+// turn the projection in the query ad into a set of attributes.
+// returns true if the projection is not a simple string and must instead
+// be evaluated against each result ad.
+bool CollectorDaemon::parse_query_projection(ClassAd *cad, std::string &projection, classad::References &proj)
+{
+	projection.clear();
+	proj.clear();
 	if (cad->LookupString(ATTR_PROJECTION, projection) && ! projection.empty()) {
 		StringTokenIterator list(projection);
 		const std::string * attr;
@@ -887,70 +920,144 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 	} else if (cad->Lookup(ATTR_PROJECTION)) {
 		// if projection is not a simple string, then assume that evaluating it as a string in the context of the ad will work better
 		// (the negotiator sends this sort of projection)
-		evaluate_projection = true;
+		return true;
 	}
+	return false;
+}
 
-	while ( (curr_ad=results.Next()) )
-	{
-		// if querying collector ads, and the collectors own ad appears in this list.
-		// then we want to shove in current statistics. we do this by chaining a
-		// temporary stats ad into the ad to be returned, and publishing updated
-		// statistics into the stats ad.  we do this because if the verbosity level
-		// is increased we do NOT want to put the high-verbosity attributes into
-		// our persistent collector ad.
-		ClassAd * stats_ad = NULL;
-		if ((whichAds == COLLECTOR_AD) && collector.isSelfAd(curr_ad)) {
-			dprintf(D_ALWAYS,"Query includes collector's self ad\n");
-			// update stats in the collector ad before we return it.
-			std::string stats_config;
-			cad->LookupString("STATISTICS_TO_PUBLISH",stats_config);
-			if (stats_config != "stored") {
-				dprintf(D_ALWAYS,"Updating collector stats using a chained ad and config=%s\n", stats_config.c_str());
-				stats_ad = new ClassAd();
-				daemonCore->dc_stats.Publish(*stats_ad, stats_config.c_str());
-				daemonCore->monitor_data.ExportData(stats_ad, true);
-				collectorStats.publishGlobal(stats_ad, stats_config.c_str());
-				stats_ad->ChainToAd(curr_ad);
-				curr_ad = stats_ad; // send the stats ad instead of the self ad.
-			}
+// write a single query result to the socket, preceded by the 'more' flag
+// (or, for a watch, by the event code).
+// returns the same as putClassAd, i.e. 0 on failure, 1 on success,
+// and 2 if the socket is non-blocking and the write was backlogged.
+int CollectorDaemon::put_query_result(Stream *sock, ClassAd *cad, ClassAd *curr_ad, AdTypes whichAds,
+	bool filter_private_ads, bool evaluate_projection,
+	std::string &projection, classad::References &proj, int put_options, int more)
+{
+	// if querying collector ads, and the collectors own ad appears in this list.
+	// then we want to shove in current statistics. we do this by chaining a
+	// temporary stats ad into the ad to be returned, and publishing updated
+	// statistics into the stats ad.  we do this because if the verbosity level
+	// is increased we do NOT want to put the high-verbosity attributes into
+	// our persistent collector ad.
+	ClassAd * stats_ad = NULL;
+	if ((whichAds == COLLECTOR_AD) && collector.isSelfAd(curr_ad)) {
+		dprintf(D_ALWAYS,"Query includes collector's self ad\n");
+		// update stats in the collector ad before we return it.
+		std::string stats_config;
+		cad->LookupString("STATISTICS_TO_PUBLISH",stats_config);
+		if (stats_config != "stored") {
+			dprintf(D_ALWAYS,"Updating collector stats using a chained ad and config=%s\n", stats_config.c_str());
+			stats_ad = new ClassAd();
+			daemonCore->dc_stats.Publish(*stats_ad, stats_config.c_str());
+			daemonCore->monitor_data.ExportData(stats_ad, true);
+			collectorStats.publishGlobal(stats_ad, stats_config.c_str());
+			stats_ad->ChainToAd(curr_ad);
+			curr_ad = stats_ad; // send the stats ad instead of the self ad.
 		}
+	}
 
-		if (evaluate_projection) {
-			proj.clear();
-			projection.clear();
-			if (EvalString(ATTR_PROJECTION, cad, curr_ad, projection) && ! projection.empty()) {
-				StringTokenIterator list(projection);
-				const std::string * attr;
-				while ((attr = list.next_string())) { proj.insert(*attr); }
-			}
+	if (evaluate_projection) {
+		proj.clear();
+		projection.clear();
+		if (EvalString(ATTR_PROJECTION, cad, curr_ad, projection) && ! projection.empty()) {
+			StringTokenIterator list(projection);
+			const std::string * attr;
+			while ((attr = list.next_string())) { proj.insert(*attr); }
 		}
+	}
 
-		bool send_failed = (!sock->code(more) || !putClassAd(sock, *curr_ad, filter_private_ads ? PUT_CLASSAD_NO_PRIVATE : 0, proj.empty() ? NULL : &proj));
-        
-		if (stats_ad) {
-			stats_ad->Unchain();
-			delete stats_ad;
-		}
+	if (filter_private_ads) { put_options |= PUT_CLASSAD_NO_PRIVATE; }
 
-		if (send_failed)
-        {
-            dprintf (D_ALWAYS,
-                    "Error sending query result to client -- aborting\n");
-            return_status = 0;
-			goto END;
-        }
+	int retval = 0;
+	if (sock->code(more)) {
+		retval = putClassAd(sock, *curr_ad, put_options, proj.empty() ? NULL : &proj);
+	}
 
-		if (sock->deadline_expired()) {
-			dprintf( D_ALWAYS,
-				"QueryWorker: max_worktime expired while sending query result to client -- aborting\n");
-			return_status = 0;
-			goto END;
-		}
+	if (stats_ad) {
+		stats_ad->Unchain();
+		delete stats_ad;
+	}
+
+	return retval;
+}
+
+// state of a query whose results are written to the socket during the scan
+struct query_result_stream_t {
+	Stream *sock;
+	ClassAd *query;
+	AdTypes whichAds;
+	bool filter_private_ads;
+	bool evaluate_projection;
+	std::string projection;
+	classad::References proj;
+	bool failed;
+};
+
+bool CollectorDaemon::stream_query_result(ClassAd *curr_ad, void *pv)
+{
+	query_result_stream_t *qrs = (query_result_stream_t *)pv;
+
+	if ( ! put_query_result(qrs->sock, qrs->query, curr_ad, qrs->whichAds,
+			qrs->filter_private_ads, qrs->evaluate_projection, qrs->projection, qrs->proj, 0))
+	{
+		dprintf (D_ALWAYS,
+				"Error sending query result to client -- aborting\n");
+		qrs->failed = true;
+		return false;
+	}
+
+	if (qrs->sock->deadline_expired()) {
+		dprintf( D_ALWAYS,
+			"QueryWorker: max_worktime expired while sending query result to client -- aborting\n");
+		qrs->failed = true;
+		return false;
+	}
+
+	return true;
+}
+
+int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Stream* sock)
+{
+	int return_status = TRUE;
+	double begin = condor_gettimestamp_double();
+
+	// Pull out relavent state from query_entry
+	pending_query_entry_t *query_entry = (pending_query_entry_t *) in_query_entry;
+	ClassAd *cad = query_entry->cad;
+	bool is_locate = query_entry->is_locate;
+	AdTypes whichAds = query_entry->whichAds;
+
+	query_result_stream_t qrs;
+	qrs.sock = sock;
+	qrs.query = cad;
+	qrs.whichAds = whichAds;
+	qrs.filter_private_ads = filter_private_ads_for_peer(sock, whichAds);
+	qrs.failed = false;
+
+		// See if query ad asks for server-side projection
+	qrs.evaluate_projection = parse_query_projection(cad, qrs.projection, qrs.proj);
+
+	// set up the socket before the scan, since each matching ad is
+	// written to it as soon as it is found.
+	sock->timeout(QueryTimeout); // set up a network timeout of a longer duration
+	sock->encode();
 
-	} // end of while loop for next result ad to send
+	// Perform the query, sending the results as we go
+
+	if (whichAds != (AdTypes) -1) {
+		process_query_public (whichAds, cad, stream_query_result, &qrs);
+	}
+
+	double end_query = condor_gettimestamp_double();
+	double end_write = 0.0;
+	int more = 0;
+
+	if (qrs.failed) {
+		return_status = 0;
+		goto END;
+	}
 
 	// end of query response ...
-	more = 0;
 	if (!sock->code(more))
 	{
 		dprintf (D_ALWAYS, "Error sending EndOfResponse (0) to client\n");
@@ -964,6 +1071,8 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 
 	end_write = condor_gettimestamp_double();
 
+	// since results are sent during the scan, query_time includes the time
+	// spent writing all but the last buffer of results.
 	dprintf (D_ALWAYS,
 			 "Query info: matched=%d; skipped=%d; query_time=%f; send_time=%f; type=%s; requirements={%s}; locate=%d; limit=%d; from=%s; peer=%s; projection={%s}; filter_private_ads=%d\n",
 			 __numAds__,
@@ -976,8 +1085,8 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 			 (__resultLimit__ == INT_MAX) ? 0 : __resultLimit__,
 			 query_entry->subsys,
 			 sock->peer_description(),
-			 projection.c_str(),
-			 filter_private_ads);
+			 qrs.projection.c_str(),
+			 qrs.filter_private_ads);
 END:
 	
 	// All done.  Deallocate memory allocated in this method.  Note that DaemonCore 
@@ -986,6 +1095,648 @@ END:
 	return return_status;
 }
 
+CollectorQueryContinuation::CollectorQueryContinuation(ClassAd *query, AdTypes whichAds, bool is_locate, const char *subsys)
+	: m_query(query)
+	, m_whichAds(whichAds)
+	, m_is_locate(is_locate)
+	, m_filter_private_ads(true)
+	, m_evaluate_projection(false)
+	, m_unfinished_eom(false)
+	, m_registered_socket(false)
+	, m_subsys(subsys ? subsys : "")
+	, m_matched(0)
+	, m_skipped(0)
+	, m_limit(0)
+	, m_begin(condor_gettimestamp_double())
+	, m_end_query(0.0)
+{
+	m_epoch = CollectorDaemon::collector.beginSnapshot();
+	CollectorDaemon::collectorStats.global.ActiveQuerySnapshots = CollectorDaemon::collector.activeSnapshots();
+	CollectorDaemon::collectorStats.global.SnapshotQueries += 1;
+}
+
+CollectorQueryContinuation::~CollectorQueryContinuation()
+{
+	CollectorDaemon::collector.endSnapshot(m_epoch);
+	CollectorDaemon::collectorStats.global.ActiveQuerySnapshots = CollectorDaemon::collector.activeSnapshots();
+	delete m_query;
+}
+
+int
+CollectorQueryContinuation::start(Stream *sock)
+{
+	m_filter_private_ads = CollectorDaemon::filter_private_ads_for_peer(sock, m_whichAds);
+
+	if (m_whichAds != (AdTypes) -1) {
+		CollectorDaemon::process_query_public(m_whichAds, m_query, &m_results);
+	}
+
+	// process_query_public leaves the details of the scan in the static query state,
+	// capture them now since other queries may run before we are done writing.
+	m_matched = CollectorDaemon::__numAds__;
+	m_skipped = CollectorDaemon::__failed__;
+	m_limit = (CollectorDaemon::__resultLimit__ == INT_MAX) ? 0 : CollectorDaemon::__resultLimit__;
+	m_requirements = ExprTreeToString(CollectorDaemon::__filter__);
+	m_end_query = condor_gettimestamp_double();
+
+	m_evaluate_projection = CollectorDaemon::parse_query_projection(m_query, m_projection, m_proj);
+	m_results.Rewind();
+
+	sock->timeout(CollectorDaemon::QueryTimeout); // set up a network timeout of a longer duration
+	sock->encode();
+
+	return finish(sock);
+}
+
+int
+CollectorQueryContinuation::finish(Stream *sock)
+{
+	ReliSock *rsock = static_cast<ReliSock*>(sock);
+	bool has_backlog = false;
+
+	if (sock->deadline_expired()) {
+		dprintf(D_ALWAYS,
+			"QuerySnapshot: max_worktime expired while sending query result to client -- aborting\n");
+		CollectorDaemon::collectorStats.global.DroppedQueries += 1;
+		delete this;
+		return FALSE;
+	}
+
+	if (m_unfinished_eom) {
+		int retval = rsock->finish_end_of_message();
+		if (rsock->clear_backlog_flag()) {
+			return KEEP_STREAM;
+		} else if (retval == 1) {
+			logQueryInfo(sock);
+			delete this;
+			return TRUE;
+		} else {
+			dprintf(D_ALWAYS, "Error flushing CEDAR socket\n");
+			delete this;
+			return FALSE;
+		}
+	}
+
+	ClassAd *curr_ad = NULL;
+	while ( ! has_backlog && (curr_ad = m_results.Next())) {
+		int retval;
+		{
+			BlockingModeGuard guard(rsock, true);
+			retval = CollectorDaemon::put_query_result(sock, m_query, curr_ad, m_whichAds,
+				m_filter_private_ads, m_evaluate_projection, m_projection, m_proj,
+				PUT_CLASSAD_NON_BLOCKING);
+			if (retval && rsock->clear_backlog_flag()) { retval = 2; }
+		}
+		if ( ! retval) {
+			dprintf(D_ALWAYS, "Error sending query result to client -- aborting\n");
+			delete this;
+			return FALSE;
+		}
+		has_backlog = (retval == 2);
+	}
+
+	if ( ! has_backlog) {
+		// end of query response ...
+		int more = 0;
+		int retval;
+		{
+			BlockingModeGuard guard(rsock, true);
+			retval = sock->code(more);
+		}
+		if ( ! retval) {
+			dprintf(D_ALWAYS, "Error sending EndOfResponse (0) to client\n");
+			delete this;
+			return FALSE;
+		}
+		retval = rsock->end_of_message_nonblocking();
+		if (rsock->clear_backlog_flag()) {
+			m_unfinished_eom = true;
+			has_backlog = true;
+		} else {
+			if ( ! retval) {
+				dprintf(D_ALWAYS, "Error flushing CEDAR socket\n");
+			}
+			logQueryInfo(sock);
+			delete this;
+			return retval ? TRUE : FALSE;
+		}
+	}
+
+	if ( ! m_registered_socket) {
+		int rc = daemonCore->Register_Socket(sock, "Collector Query Response",
+			(SocketHandlercpp)&CollectorQueryContinuation::finish,
+			"CollectorQueryContinuation::finish", this, ALLOW, HANDLE_WRITE);
+		if (rc < 0) {
+			dprintf(D_ALWAYS, "QuerySnapshot: failed to register socket for query response -- aborting\n");
+			delete this;
+			return FALSE;
+		}
+		m_registered_socket = true;
+	}
+	return KEEP_STREAM;
+}
+
+void
+CollectorQueryContinuation::logQueryInfo(Stream *sock)
+{
+	double end_write = condor_gettimestamp_double();
+	dprintf (D_ALWAYS,
+			 "Query info: matched=%d; skipped=%d; query_time=%f; send_time=%f; type=%s; requirements={%s}; locate=%d; limit=%d; from=%s; peer=%s; projection={%s}; filter_private_ads=%d; snapshot=%lu\n",
+			 m_matched,
+			 m_skipped,
+			 m_end_query - m_begin,
+			 end_write - m_end_query,
+			 AdTypeToString(m_whichAds),
+			 m_requirements.c_str(),
+			 m_is_locate,
+			 m_limit,
+			 m_subsys.c_str(),
+			 sock->peer_description(),
+			 m_projection.c_str(),
+			 m_filter_private_ads,
+			 m_epoch);
+}
+
+// Handler for WATCH_ADS.  The client sends a query ad, just as for a query,
+// and gets the same reply a query would get.  After that, the connection is
+// kept open and each time an ad that matches the query is inserted, updated
+// or removed, a message is written with the event code and the (projected) ad.
+// Changes to an ad that have not been written yet are merged, so a slow client
+// sees the current state of the ad rather than every update.  The socket is
+// never written while it would block; a client that has had writes backlogged
+// for longer than QUERY_TIMEOUT is dropped.
+class CollectorWatch : public CollectorAdWatcher, public Service {
+public:
+	CollectorWatch(ClassAd *query, AdTypes whichAds);
+	~CollectorWatch();
+
+	int start(Stream *sock);
+	int handle_write(Stream *sock);
+	int handle_read(Stream *sock);
+
+	virtual void adChanged(CollectorHashTable &table, ClassAd *old_ad, ClassAd *new_ad);
+	virtual void adRemoved(ClassAd *ad);
+
+private:
+	struct Event {
+		int code;
+		ClassAd *ad;
+		bool owned; // ad is a copy of a removed ad that we must delete
+	};
+	typedef std::list<Event> EventList;
+
+	bool wantsTable(CollectorHashTable &table, ClassAd *ad);
+	bool matches(ClassAd *ad);
+	void queueEvent(int code, ClassAd *ad);
+	void queueRemove(ClassAd *ad);
+	int flush();
+	int endMessage();
+	bool listen(int handler_type);
+	bool write();
+	void pump();
+	void drop();
+
+	ClassAd *m_query;
+	AdTypes m_whichAds;
+	std::string m_adType;
+	CollectorHashTable *m_table;
+	CollectorHashTable *m_pvtTable;
+	ReliSock *m_sock;
+	bool m_filter_private_ads;
+	bool m_evaluate_projection;
+	std::string m_projection;
+	classad::References m_proj;
+
+	std::set<ClassAd*> m_known;  // ads the client has, or will have once the pending events are written
+	EventList m_events;
+	std::map<ClassAd*, EventList::iterator> m_pending; // pending insert or update for each live ad
+
+	List<ClassAd> m_snapshot;
+	unsigned long m_epoch;
+	bool m_in_snapshot;
+	bool m_need_eom;
+	bool m_unfinished_eom;
+	int m_registered;  // HANDLE_READ, HANDLE_WRITE or 0 if not registered
+	time_t m_backlog_since;
+};
+
+CollectorWatch::CollectorWatch(ClassAd *query, AdTypes whichAds)
+	: m_query(query)
+	, m_whichAds(whichAds)
+	, m_table(NULL)
+	, m_pvtTable(NULL)
+	, m_sock(NULL)
+	, m_filter_private_ads(true)
+	, m_evaluate_projection(false)
+	, m_epoch(0)
+	, m_in_snapshot(false)
+	, m_need_eom(false)
+	, m_unfinished_eom(false)
+	, m_registered(0)
+	, m_backlog_since(0)
+{
+	if (m_whichAds == GENERIC_AD || m_whichAds == ANY_AD) {
+		m_query->LookupString(ATTR_TARGET_TYPE, m_adType);
+		if (strcasecmp(m_adType.c_str(), "any") == 0) {
+			m_adType.clear();
+		}
+	} else {
+		m_table = CollectorDaemon::collector.getTable(m_whichAds);
+	}
+	m_pvtTable = CollectorDaemon::collector.getTable(STARTD_PVT_AD);
+}
+
+CollectorWatch::~CollectorWatch()
+{
+	CollectorDaemon::collector.removeWatcher(this);
+	if (m_in_snapshot) {
+		CollectorDaemon::collector.endSnapshot(m_epoch);
+	}
+	for (auto it = m_events.begin(); it != m_events.end(); ++it) {
+		if (it->owned) { delete it->ad; }
+	}
+	CollectorDaemon::collectorStats.global.ActiveWatches = CollectorDaemon::collector.watcherCount();
+	CollectorDaemon::collectorStats.global.ActiveQuerySnapshots = CollectorDaemon::collector.activeSnapshots();
+	delete m_query;
+}
+
+int
+CollectorWatch::start(Stream *sock)
+{
+	m_sock = static_cast<ReliSock*>(sock);
+	m_filter_private_ads = CollectorDaemon::filter_private_ads_for_peer(sock, m_whichAds);
+
+	// the initial reply is every matching ad, however many there are
+	m_query->Delete(ATTR_LIMIT_RESULTS);
+
+	m_epoch = CollectorDaemon::collector.beginSnapshot();
+	m_in_snapshot = true;
+	CollectorDaemon::process_query_public(m_whichAds, m_query, &m_snapshot);
+	m_evaluate_projection = CollectorDaemon::parse_query_projection(m_query, m_projection, m_proj);
+
+	ClassAd *ad;
+	m_snapshot.Rewind();
+	while ((ad = m_snapshot.Next())) {
+		m_known.insert(ad);
+	}
+	m_snapshot.Rewind();
+
+	CollectorDaemon::collector.addWatcher(this);
+	CollectorDaemon::collectorStats.global.ActiveWatches = CollectorDaemon::collector.watcherCount();
+	CollectorDaemon::collectorStats.global.ActiveQuerySnapshots = CollectorDaemon::collector.activeSnapshots();
+
+	dprintf(D_ALWAYS, "Watch from %s: type=%s; requirements={%s}; projection={%s}; initial=%d\n",
+		sock->peer_description(), AdTypeToString(m_whichAds),
+		ExprTreeToString(m_query->LookupExpr(ATTR_REQUIREMENTS)),
+		m_projection.c_str(), (int)m_known.size());
+
+	sock->timeout(CollectorDaemon::QueryTimeout); // set up a network timeout of a longer duration
+	sock->encode();
+
+	return handle_write(sock);
+}
+
+// true if a change to this ad in this table is one the watch could care about
+bool
+CollectorWatch::wantsTable(CollectorHashTable &table, ClassAd *ad)
+{
+	if (m_table) {
+		return &table == m_table;
+	}
+	if (&table == m_pvtTable) {
+		return false;
+	}
+	if ( ! m_adType.empty()) {
+		std::string type;
+		ad->LookupString(ATTR_MY_TYPE, type);
+		return strcasecmp(type.c_str(), m_adType.c_str()) == 0;
+	}
+	return true;
+}
+
+bool
+CollectorWatch::matches(ClassAd *ad)
+{
+	classad::ExprTree *filter = m_query->LookupExpr(ATTR_REQUIREMENTS);
+	classad::Value result;
+	bool val;
+	return filter && EvalExprTree(filter, ad, NULL, result) && result.IsBooleanValueEquiv(val) && val;
+}
+
+void
+CollectorWatch::queueEvent(int code, ClassAd *ad)
+{
+	// an ad that already has a pending insert or update is written once, as it is when written
+	if (m_pending.count(ad)) {
+		return;
+	}
+	Event ev = { code, ad, false };
+	m_pending[ad] = m_events.insert(m_events.end(), ev);
+}
+
+// the client knew about this ad, tell it the ad is gone
+void
+CollectorWatch::queueRemove(ClassAd *ad)
+{
+	m_known.erase(ad);
+	auto found = m_pending.find(ad);
+	if (found != m_pending.end()) {
+		bool was_insert = found->second->code == WATCH_ADS_EVENT_INSERT;
+		m_events.erase(found->second);
+		m_pending.erase(found);
+		if (was_insert) {
+			return; // the client never saw the ad
+		}
+	}
+	Event ev = { WATCH_ADS_EVENT_REMOVE, new ClassAd(*ad), true };
+	m_events.push_back(ev);
+}
+
+void
+CollectorWatch::adChanged(CollectorHashTable &table, ClassAd *old_ad, ClassAd *new_ad)
+{
+	if ( ! wantsTable(table, new_ad)) {
+		return;
+	}
+
+	// the old ad is about to be deleted, so follow the ad to its replacement
+	if (old_ad && old_ad != new_ad) {
+		if (m_known.erase(old_ad)) {
+			m_known.insert(new_ad);
+		}
+		auto found = m_pending.find(old_ad);
+		if (found != m_pending.end()) {
+			found->second->ad = new_ad;
+			m_pending[new_ad] = found->second;
+			m_pending.erase(found);
+		}
+	}
+
+	if (matches(new_ad)) {
+		if (m_known.insert(new_ad).second) {
+			queueEvent(WATCH_ADS_EVENT_INSERT, new_ad);
+		} else {
+			queueEvent(WATCH_ADS_EVENT_UPDATE, new_ad);
+		}
+	} else if (m_known.count(new_ad)) {
+		queueRemove(new_ad);
+	} else {
+		return;
+	}
+	pump();
+}
+
+void
+CollectorWatch::adRemoved(ClassAd *ad)
+{
+	if (m_known.count(ad)) {
+		queueRemove(ad);
+		pump();
+	}
+}
+
+// write what we can of the pending events if the socket is not already
+// waiting to drain, and drop the client if it has fallen too far behind.
+void
+CollectorWatch::pump()
+{
+	if (m_registered == HANDLE_WRITE) {
+		if (m_backlog_since && time(NULL) - m_backlog_since > CollectorDaemon::QueryTimeout) {
+			dprintf(D_ALWAYS, "Watch from %s has not read its events for %d seconds -- dropping it\n",
+				m_sock->peer_description(), (int)(time(NULL) - m_backlog_since));
+			CollectorDaemon::collectorStats.global.DroppedQueries += 1;
+			drop();
+		}
+		return;
+	}
+	if ( ! write()) {
+		drop();
+	}
+}
+
+// close the watch from outside of a socket handler
+void
+CollectorWatch::drop()
+{
+	ReliSock *sock = m_sock;
+	if (m_registered) {
+		daemonCore->Cancel_Socket(sock);
+	}
+	delete sock;
+	delete this;
+}
+
+// returns the same as end_of_message_nonblocking, or 2 if the end of message
+// is backlogged and must be finished later.
+int
+CollectorWatch::endMessage()
+{
+	m_need_eom = false;
+	int retval = m_sock->end_of_message_nonblocking();
+	if (m_sock->clear_backlog_flag()) {
+		m_unfinished_eom = true;
+		return 2;
+	}
+	return retval ? 1 : 0;
+}
+
+// write as much as the socket will take without blocking.
+// returns 0 on error, 1 when everything has been written
+// and 2 if the socket is backlogged.
+int
+CollectorWatch::flush()
+{
+	int retval;
+
+	if (m_unfinished_eom) {
+		retval = m_sock->finish_end_of_message();
+		if (m_sock->clear_backlog_flag()) {
+			return 2;
+		} else if (retval != 1) {
+			dprintf(D_ALWAYS, "Error flushing CEDAR socket\n");
+			return 0;
+		}
+		m_unfinished_eom = false;
+	}
+	if (m_need_eom && (retval = endMessage()) != 1) {
+		return retval;
+	}
+
+	while (m_in_snapshot) {
+		ClassAd *curr_ad = m_snapshot.Next();
+		if (curr_ad) {
+			BlockingModeGuard guard(m_sock, true);
+			retval = CollectorDaemon::put_query_result(m_sock, m_query, curr_ad, m_whichAds,
+				m_filter_private_ads, m_evaluate_projection, m_projection, m_proj,
+				PUT_CLASSAD_NON_BLOCKING);
+			if (retval && m_sock->clear_backlog_flag()) { retval = 2; }
+			if (retval != 1) {
+				return retval;
+			}
+			continue;
+		}
+
+		// end of the initial reply ...
+		int more = 0;
+		{
+			BlockingModeGuard guard(m_sock, true);
+			retval = m_sock->code(more);
+		}
+		if ( ! retval) {
+			dprintf(D_ALWAYS, "Error sending EndOfResponse (0) to client\n");
+			return 0;
+		}
+		// every snapshot ad is in the socket buffer now, so the tables may free them
+		m_in_snapshot = false;
+		m_snapshot.Clear();
+		CollectorDaemon::collector.endSnapshot(m_epoch);
+		CollectorDaemon::collectorStats.global.ActiveQuerySnapshots = CollectorDaemon::collector.activeSnapshots();
+		if ((retval = endMessage()) != 1) {
+			return retval;
+		}
+	}
+
+	while ( ! m_events.empty()) {
+		Event ev = m_events.front();
+		m_events.pop_front();
+		if ( ! ev.owned) {
+			m_pending.erase(ev.ad);
+		}
+		{
+			BlockingModeGuard guard(m_sock, true);
+			retval = CollectorDaemon::put_query_result(m_sock, m_query, ev.ad, m_whichAds,
+				m_filter_private_ads, m_evaluate_projection, m_projection, m_proj,
+				PUT_CLASSAD_NON_BLOCKING, ev.code);
+			if (retval && m_sock->clear_backlog_flag()) { retval = 2; }
+		}
+		if (ev.owned) {
+			delete ev.ad;
+		}
+		if ( ! retval) {
+			dprintf(D_ALWAYS, "Error sending watch event to client\n");
+			return 0;
+		}
+		CollectorDaemon::collectorStats.global.WatchEvents += 1;
+		if (retval == 2) {
+			m_need_eom = true;
+			return 2;
+		}
+		if ((retval = endMessage()) != 1) {
+			return retval;
+		}
+	}
+	return 1;
+}
+
+// (re)register the socket so that DaemonCore calls us when it is writable,
+// or, while we have nothing to write, when the client closes it.
+bool
+CollectorWatch::listen(int handler_type)
+{
+	if (m_registered == handler_type) {
+		return true;
+	}
+	if (m_registered) {
+		daemonCore->Cancel_Socket(m_sock);
+		m_registered = 0;
+	}
+	int rc;
+	if (handler_type == HANDLE_WRITE) {
+		rc = daemonCore->Register_Socket(m_sock, "Collector Watch Events",
+			(SocketHandlercpp)&CollectorWatch::handle_write,
+			"CollectorWatch::handle_write", this, ALLOW, HANDLE_WRITE);
+	} else {
+		rc = daemonCore->Register_Socket(m_sock, "Collector Watch",
+			(SocketHandlercpp)&CollectorWatch::handle_read,
+			"CollectorWatch::handle_read", this, ALLOW, HANDLE_READ);
+	}
+	if (rc < 0) {
+		dprintf(D_ALWAYS, "Watch: failed to register socket -- aborting\n");
+		return false;
+	}
+	m_registered = handler_type;
+	return true;
+}
+
+// write the pending events and register the socket for whatever comes next.
+// returns false if the watch should be closed.
+bool
+CollectorWatch::write()
+{
+	int retval = flush();
+	if (retval == 2) {
+		if ( ! m_backlog_since) { m_backlog_since = time(NULL); }
+	} else {
+		m_backlog_since = 0;
+	}
+	return retval && listen(retval == 2 ? HANDLE_WRITE : HANDLE_READ);
+}
+
+int
+CollectorWatch::handle_write(Stream * /*sock*/)
+{
+	if (write()) {
+		return KEEP_STREAM;
+	}
+	delete this;
+	return FALSE;
+}
+
+// the client does not send anything once the watch is started, so the socket
+// becoming readable means the client has closed it (or broken the protocol).
+int
+CollectorWatch::handle_read(Stream *sock)
+{
+	dprintf(D_FULLDEBUG, "Watch from %s closed\n", sock->peer_description());
+	delete this;
+	return FALSE;
+}
+
+int CollectorDaemon::receive_watch(int /*command*/, Stream* sock)
+{
+	ClassAd *cad = new ClassAd();
+
+	sock->decode();
+	sock->timeout(1);
+	if ( ! getClassAd(sock, *cad) || ! sock->end_of_message()) {
+		dprintf(D_ALWAYS, "Failed to receive watch query on TCP: aborting\n");
+		delete cad;
+		return FALSE;
+	}
+
+	// any type the query names that does not have its own table is generic
+	AdTypes whichAds = ANY_AD;
+	std::string target_type;
+	if (cad->LookupString(ATTR_TARGET_TYPE, target_type)) {
+		whichAds = AdTypeFromString(target_type.c_str());
+		if (whichAds == NO_AD) {
+			whichAds = GENERIC_AD;
+		}
+	}
+
+	const char *refused = NULL;
+	if (sock->type() != Stream::reli_sock) {
+		refused = "not on a TCP connection";
+	} else if (whichAds == STARTD_PVT_AD) {
+		refused = "private ads cannot be watched";
+	} else if (collector.watcherCount() >= max_watches) {
+		refused = "too many watches";
+	}
+	if (refused) {
+		dprintf(D_ALWAYS, "Refusing watch from %s: %s\n", sock->peer_description(), refused);
+		delete cad;
+		int more = 0;
+		sock->encode();
+		if ( ! sock->code(more) || ! sock->end_of_message()) {
+			dprintf(D_ALWAYS, "Error sending EndOfResponse (0) to client\n");
+		}
+		return FALSE;
+	}
+
+	CollectorWatch *watch = new CollectorWatch(cad, whichAds);
+	return watch->start(sock);
+}
+
 AdTypes
 CollectorDaemon::receive_query_public( int command )
 {
@@ -1210,6 +1961,7 @@ int CollectorDaemon::receive_invalidation(int command,
 
 
 collector_runtime_probe CollectorEngine_receive_update_runtime;
+collector_runtime_probe UpdateStageForward_runtime;
 #ifdef PROFILE_RECEIVE_UPDATE
 collector_runtime_probe CollectorEngine_ru_pre_collect_runtime;
 collector_runtime_probe CollectorEngine_ru_collect_runtime;
@@ -1272,6 +2024,13 @@ int CollectorDaemon::receive_update(int command, Stream* sock)
 #ifdef PROFILE_RECEIVE_UPDATE
 	CollectorEngine_ru_collect_runtime += rt.tick(rt_last);
 #endif
+	double rt_forward = _condor_debug_get_time_double();
+
+	// once a delta has been applied, the ad in our table is a complete
+	// startd ad, so the plugins and view collectors see a normal update.
+	if (command == UPDATE_STARTD_AD_DELTA) {
+		command = UPDATE_STARTD_AD;
+	}
 
 	/* let the off-line plug-in have at it */
 	offline_plugin_.update ( command, *cad );
@@ -1295,6 +2054,14 @@ int CollectorDaemon::receive_update(int command, Stream* sock)
 #ifdef PROFILE_RECEIVE_UPDATE
 	CollectorEngine_ru_forward_runtime += rt.tick(rt_last);
 #endif
+	UpdateStageForward_runtime += rt.tick(rt_forward);
+
+	// Bytes of further updates already waiting on this socket.  This is
+	// the socket's backlog, not a count of queued updates; UDP updates all
+	// share one socket, so a value that stays high means we are not keeping
+	// up with the rate updates arrive at.
+	int backlog = sock->bytes_available_to_read();
+	collectorStats.global.UpdateSocketBacklogBytes = (backlog > 0) ? backlog : 0;
 
 	if( sock->type() == Stream::reli_sock ) {
 			// stash this socket for future updates...
@@ -1469,6 +2236,13 @@ CollectorDaemon::stashSocket( ReliSock* sock )
 	return KEEP_STREAM;
 }
 
+// how many ads query_scanFunc gathers before evaluating the Requirements.
+// the first batch is small, so that a streamed query sends its first
+// results without waiting for a full batch, and each one after that is
+// twice as large, up to QUERY_BATCH_ADS.
+static const int QUERY_FIRST_BATCH_ADS = 16;
+static const int QUERY_BATCH_ADS = 1024;
+
 int CollectorDaemon::query_scanFunc (ClassAd *cad)
 {
 	if ( !__adType__.empty() ) {
@@ -1479,33 +2253,72 @@ int CollectorDaemon::query_scanFunc (ClassAd *cad)
 		}
 	}
 
-	classad::Value result;
-	bool val;
-	if ( EvalExprTree( __filter__, cad, NULL, result ) &&
-		 result.IsBooleanValueEquiv(val) && val ) {
-		// Found a match 
-        __numAds__++;
-		__ClassAdResultList__->Append(cad);
+	// the Requirements are evaluated a batch of ads at a time, but no more
+	// ads are gathered than could still be results
+	__batch__.push_back(cad);
+	if ( (int)__batch__.size() < __batchLimit__ &&
+		 (int)__batch__.size() < __resultLimit__ - __numAds__ ) {
+		return 1;
+	}
+	return query_flushBatch();
+}
+
+// Evaluate the Requirements in the ads gathered by query_scanFunc, and
+// hand the ones that match to the result sink in the order they were found.
+int CollectorDaemon::query_flushBatch ()
+{
+	std::vector<bool> matches;
+	__batchEval__->Evaluate(__batch__, matches);
+
+	int rval = 1;
+	for (size_t ix = 0; ix < __batch__.size(); ++ix) {
+		if ( ! matches[ix]) {
+			__failed__++;
+			continue;
+		}
+		// Found a match
+		__numAds__++;
+		if ( ! __resultSink__(__batch__[ix], __resultSinkData__)) {
+			rval = 0; // the consumer of the results wants no more
+			break;
+		}
 		if (__numAds__ >= __resultLimit__) {
-			return 0; // tell it to stop iterating, we have all the results we want
+			rval = 0; // tell it to stop iterating, we have all the results we want
+			break;
 		}
-    } else {
-		__failed__++;
 	}
-
-    return 1;
+	__batch__.clear();
+	if (__batchLimit__ < QUERY_BATCH_ADS) {
+		__batchLimit__ = MIN(__batchLimit__ * 2, QUERY_BATCH_ADS);
+	}
+	return rval;
 }
 
 
+static bool append_query_result(ClassAd *ad, void *pv)
+{
+	((List<ClassAd>*)pv)->Append(ad);
+	return true;
+}
+
 void CollectorDaemon::process_query_public (AdTypes whichAds,
 											ClassAd *query,
 											List<ClassAd>* results)
+{
+	process_query_public(whichAds, query, append_query_result, results);
+}
+
+void CollectorDaemon::process_query_public (AdTypes whichAds,
+											ClassAd *query,
+											QueryResultSink sink,
+											void *pv)
 {
 	// set up for hashtable scan
 	__query__ = query;
 	__numAds__ = 0;
 	__failed__ = 0;
-	__ClassAdResultList__ = results;
+	__resultSink__ = sink;
+	__resultSinkData__ = pv;
 	// An empty adType means don't check the MyType of the ads.
 	// This means either the command indicates we're only checking one
 	// type of ad, or the query's TargetType is "Any" (match all ad types).
@@ -1571,10 +2384,21 @@ void CollectorDaemon::process_query_public (AdTypes whichAds,
 		}
 	}
 
-	if (!collector.walkHashTable (whichAds, query_scanFunc))
+	classad::BatchEval batch_eval(__filter__);
+	__batchEval__ = &batch_eval;
+	__batch__.clear();
+	__batchLimit__ = QUERY_FIRST_BATCH_ADS;
+	bool walked = collector.walkIndexedTable (whichAds, __filter__, query_scanFunc);
+	// the ads gathered since the last batch was evaluated.  the sink can
+	// fail on these just as on any earlier batch.
+	if ( ! __batch__.empty() && ! query_flushBatch()) {
+		walked = false;
+	}
+	if ( ! walked)
 	{
 		dprintf (D_ALWAYS, "Error sending query response\n");
 	}
+	__batchEval__ = NULL;
 
 	dprintf (D_ALWAYS, "(Sending %d ads in response to query)\n", __numAds__);
 }	
@@ -1834,10 +2658,11 @@ void CollectorDaemon::Config()
 
 	collector.m_allowOnlyOneNegotiator = param_boolean("COLLECTOR_ALLOW_ONLY_ONE_NEGOTIATOR", false);
 	// This it temporary (for 8.7.0) just in case we need to turn off the new getClassAdEx options
-	collector.m_get_ad_options = param_integer("COLLECTOR_GETAD_OPTIONS", GET_CLASSAD_FAST | GET_CLASSAD_LAZY_PARSE);
-	collector.m_get_ad_options &= (GET_CLASSAD_LAZY_PARSE | GET_CLASSAD_FAST | GET_CLASSAD_NO_CACHE);
+	collector.m_get_ad_options = param_integer("COLLECTOR_GETAD_OPTIONS", GET_CLASSAD_FAST | GET_CLASSAD_LAZY_PARSE | GET_CLASSAD_SHARE_STRINGS);
+	collector.m_get_ad_options &= (GET_CLASSAD_LAZY_PARSE | GET_CLASSAD_FAST | GET_CLASSAD_NO_CACHE | GET_CLASSAD_SHARE_STRINGS);
 	MyString opts;
 	if (collector.m_get_ad_options & GET_CLASSAD_FAST) { opts += "fast "; }
+	if (collector.m_get_ad_options & GET_CLASSAD_SHARE_STRINGS) { opts += "share-strings "; }
 	if (collector.m_get_ad_options & GET_CLASSAD_NO_CACHE) { opts += "no-cache "; }
 	else if (collector.m_get_ad_options & GET_CLASSAD_LAZY_PARSE) { opts += "lazy-parse "; }
 	if (opts.empty()) { opts = "none "; }
@@ -1941,6 +2766,20 @@ void CollectorDaemon::Config()
     max_query_workers = param_integer ("COLLECTOR_QUERY_WORKERS", 4, 0);
 	max_pending_query_workers = param_integer ("COLLECTOR_QUERY_WORKERS_PENDING", 50, 0);
 	max_query_worktime = param_integer("COLLECTOR_QUERY_MAX_WORKTIME",0,0);
+	snapshot_queries = param_boolean("COLLECTOR_SNAPSHOT_QUERIES", false);
+	max_watches = param_integer("COLLECTOR_MAX_WATCHES", 100, 0);
+
+	{
+		classad::References index_attrs;
+		auto_free_ptr attrs(param("COLLECTOR_INDEX_ATTRS"));
+		if (attrs) {
+			StringTokenIterator it(attrs);
+			for (const char * attr = it.first(); attr; attr = it.next()) {
+				index_attrs.insert(attr);
+			}
+		}
+		collector.setIndexAttributes(index_attrs);
+	}
 	reserved_for_highprio_query_workers = param_integer("COLLECTOR_QUERY_WORKERS_RESERVE_FOR_HIGH_PRIO",1,0);
 
 	// max_query_workers had better be at least one greater than reserved_for_highprio_query_workers,
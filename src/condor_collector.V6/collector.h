@@ -55,6 +55,9 @@ class CollectorUniverseStats {
 };
 
 
+class CollectorQueryContinuation;
+class CollectorWatch;
+
 /**----------------------------------------------------------------
  *Collector daemon class declaration
  *
@@ -86,6 +89,9 @@ class CollectorUniverseStats {
  *----------------------------------------------------------------*/
 class CollectorDaemon {
 
+	friend class CollectorQueryContinuation;
+	friend class CollectorWatch;
+
 public:
 
 	CollectorDaemon() {};
@@ -102,13 +108,19 @@ public:
 	static int receive_invalidation(int, Stream*);
 	static int receive_update(int, Stream*);
     static int receive_update_expect_ack(int, Stream*);
+	static int receive_watch(int, Stream*);
 
+	// receives each ad that matches a query as the scan finds it,
+	// returns false to stop the scan.
+	typedef bool (*QueryResultSink)(ClassAd *ad, void *pv);
 	static void process_query_public(AdTypes, ClassAd*, List<ClassAd>*);
+	static void process_query_public(AdTypes, ClassAd*, QueryResultSink, void *pv);
 	static ClassAd * process_global_query( const char *constraint, void *arg );
 	static int select_by_match( ClassAd *cad );
 	static void process_invalidation(AdTypes, ClassAd&, Stream*);
 
 	static int query_scanFunc(ClassAd*);
+	static int query_flushBatch();
 	static int invalidation_scanFunc(ClassAd*);
 	static int expiration_scanFunc(ClassAd*);
 
@@ -166,6 +178,8 @@ public:
 	static int reserved_for_highprio_query_workers; // from config file
 	static int active_query_workers;
 	static int pending_query_workers;
+	static bool snapshot_queries;  // from config file
+	static int max_watches;  // from config file
 
 #ifdef TRACK_QUERIES_BY_SUBSYS
 	static bool want_track_queries_by_subsys;
@@ -184,12 +198,16 @@ protected:
 	static char* CollectorName;
 
 	static ClassAd* __query__;
-	static List<ClassAd>* __ClassAdResultList__;
+	static QueryResultSink __resultSink__;
+	static void * __resultSinkData__;
 	static int __numAds__;
 	static int __resultLimit__;
 	static int __failed__;
 	static std::string __adType__;
 	static ExprTree *__filter__;
+	static classad::BatchEval *__batchEval__;
+	static std::vector<ClassAd*> __batch__;
+	static int __batchLimit__;
 
 	static TrackTotals* normalTotals;
 	static int submittorRunningJobs;
@@ -217,6 +235,15 @@ private:
 
 	static int setAttrLastHeardFrom( ClassAd* cad, unsigned long time );
 
+	// helpers shared by the forked query worker and the in-process snapshot query
+	static bool filter_private_ads_for_peer( Stream *sock, AdTypes whichAds );
+	static bool parse_query_projection( ClassAd *query, std::string &projection, classad::References &proj );
+	static int put_query_result( Stream *sock, ClassAd *query, ClassAd *curr_ad, AdTypes whichAds,
+		bool filter_private_ads, bool evaluate_projection,
+		std::string &projection, classad::References &proj, int put_options, int more = 1 );
+	// QueryResultSink that writes each result to the socket as the scan finds it
+	static bool stream_query_result( ClassAd *ad, void *pv );
+
 };
 
 #endif
@@ -19,6 +19,8 @@
 
 #include "condor_common.h"
 
+#include <algorithm>
+
 extern "C" void event_mgr (void);
 
 //-------------------------------------------------------------
@@ -38,7 +40,6 @@ extern "C" void event_mgr (void);
 
 static void killHashTable (CollectorHashTable &);
 static int killGenericHashTable(CollectorHashTable *);
-static void purgeHashTable (CollectorHashTable &);
 
 int 	engine_clientTimeoutHandler (Service *);
 int 	engine_housekeepingHandler  (Service *);
@@ -59,13 +60,15 @@ CollectorEngine::CollectorEngine (CollectorStats *stats ) :
 	HadAds        (&adNameHashFunction),
 	GridAds       (&adNameHashFunction),
 	GenericAds    (&hashFunction),
-	__self_ad__(0)
+	__self_ad__(0),
+	m_snapshotEpoch(0)
 {
 	clientTimeout = 20;
 	machineUpdateInterval = 30;
 	m_forwardInterval = machineUpdateInterval / 3;
 	m_forwardFilteringEnabled = false;
 	housekeeperTimerID = -1;
+	m_expiryResync = false;
 
 	m_allowOnlyOneNegotiator = param_boolean("COLLECTOR_ALLOW_ONLY_ONE_NEGOTIATOR", false);
 
@@ -78,6 +81,8 @@ CollectorEngine::CollectorEngine (CollectorStats *stats ) :
 CollectorEngine::
 ~CollectorEngine ()
 {
+	m_indexes.clear();
+	m_expiry.clear();
 	killHashTable (StartdAds);
 	killHashTable (StartdPrivateAds);
 	killHashTable (ScheddAds);
@@ -94,6 +99,11 @@ CollectorEngine::
 	killHashTable (GridAds);
 	GenericAds.walk(killGenericHashTable);
 
+	while ( ! m_retiredAds.empty()) {
+		delete m_retiredAds.front().second;
+		m_retiredAds.pop_front();
+	}
+
 	if(m_collector_requirements) {
 		delete m_collector_requirements;
 		m_collector_requirements = NULL;
@@ -156,6 +166,12 @@ scheduleHousekeeper (int timeout)
 	if (timeout < 0)
 		return 0;
 
+	// ads without a ClassAdLifetime expire after this interval, so if it
+	// changes the expiration queue must be rebuilt.
+	if (timeout != machineUpdateInterval && m_expiry.size() > 0) {
+		m_expiryResync = true;
+	}
+
 	// set to new timeout interval
 	machineUpdateInterval = timeout;
 
@@ -192,13 +208,13 @@ invokeHousekeeper (AdTypes adType)
 	CollectorHashTable *table=0;
 	CollectorEngine::HashFunc func;
 	if (LookupByAdType(adType, table, func)) {
-		cleanHashTable(*table, now, func);
+		cleanHashTable(*table, now);
 	} else {
 		if (GENERIC_AD == adType) {
 			CollectorHashTable *cht=0;
 			GenericAds.startIterations();
 			while (GenericAds.iterate(cht)) {
-				cleanHashTable (*cht, now, makeGenericAdHashKey);
+				cleanHashTable (*cht, now);
 			}
 		} else {
 			return 0;
@@ -235,7 +251,7 @@ CollectorEngine::invalidateAds(AdTypes adType, ClassAd &query)
 				dprintf(D_ALWAYS,
 						"\t\t**** Invalidating ad: \"%s\"\n",
 						hkString.Value());
-				delete ad;
+				retireAd(ad);
 				count++;
 			}
 		}
@@ -311,6 +327,72 @@ walkHashTable (AdTypes adType, int (*scanFunction)(ClassAd *))
 }
 
 
+int CollectorEngine::
+walkIndexedTable (AdTypes adType, classad::ExprTree *constraint, int (*scanFunction)(ClassAd *))
+{
+	CollectorHashTable *table;
+	CollectorEngine::HashFunc func;
+	if (ANY_AD == adType || GENERIC_AD == adType || !LookupByAdType(adType, table, func)) {
+		return walkHashTable(adType, scanFunction);
+	}
+
+	CollectorAdIndex *index = findIndex(*table);
+	std::vector<ClassAd*> ads;
+	if ( ! index || ! index->candidates(constraint, ads)) {
+		return walkHashTable(adType, scanFunction);
+	}
+
+	dprintf(D_FULLDEBUG, "Using attribute index, %d of %d %s ads are candidates\n",
+			(int)ads.size(), table->getNumElements(), AdTypeToString(adType));
+	if (collectorStats) {
+		collectorStats->global.IndexedQueries += 1;
+	}
+
+	for (std::vector<ClassAd*>::iterator it = ads.begin(); it != ads.end(); ++it) {
+		if (!scanFunction(*it)) {
+			break;
+		}
+	}
+
+	return 1;
+}
+
+CollectorAdIndex * CollectorEngine::
+findIndex (CollectorHashTable &table)
+{
+	std::map<CollectorHashTable*, CollectorAdIndex>::iterator it = m_indexes.find(&table);
+	if (it == m_indexes.end() || ! it->second.enabled()) {
+		return NULL;
+	}
+	return &it->second;
+}
+
+void CollectorEngine::
+setIndexAttributes(const classad::References &attrs)
+{
+	// nothing to do if the indexed attributes have not changed
+	if ( ! m_indexes.empty() && m_indexes.begin()->second.attributes() == attrs) {
+		return;
+	}
+
+	m_indexes.clear();
+	if (attrs.empty()) {
+		return;
+	}
+
+	CollectorHashTable *tables[] = { &StartdAds, &StartdPrivateAds, &ScheddAds, &SubmittorAds, &MasterAds };
+	for (size_t ii = 0; ii < sizeof(tables)/sizeof(tables[0]); ++ii) {
+		CollectorAdIndex &index = m_indexes[tables[ii]];
+		index.configure(attrs);
+
+		ClassAd *ad;
+		tables[ii]->startIterations();
+		while (tables[ii]->iterate(ad)) {
+			index.insert(ad);
+		}
+	}
+}
+
 CollectorHashTable *CollectorEngine::findOrCreateTable(MyString &type)
 {
 	CollectorHashTable *table=0;
@@ -327,6 +409,8 @@ CollectorHashTable *CollectorEngine::findOrCreateTable(MyString &type)
 	return table;
 }
 
+collector_runtime_probe UpdateStageRead_runtime;
+collector_runtime_probe UpdateStageApply_runtime;
 #ifdef PROFILE_RECEIVE_UPDATE
 collector_runtime_probe CollectorEngine_ruc_runtime;
 collector_runtime_probe CollectorEngine_ruc_getAd_runtime;
@@ -355,6 +439,7 @@ collect (int command, Sock *sock, const condor_sockaddr& from, int &insert)
 	_condor_auto_accum_runtime<collector_runtime_probe> rt(CollectorEngine_ruc_runtime);
 	double rt_last = rt.begin;
 #endif
+	_condor_runtime stage;
 
 		// Avoid lengthy blocking on communication with our peer.
 		// This command-handler should not get called until data
@@ -393,8 +478,11 @@ collect (int command, Sock *sock, const condor_sockaddr& from, int &insert)
 #ifdef PROFILE_RECEIVE_UPDATE
 	CollectorEngine_ruc_authid_runtime.Add(rt.tick(rt_last));
 #endif
+	UpdateStageRead_runtime += stage.reset();
 
+	// for startd ads this also reads the private ad that follows
 	rval = collect(command, clientAd, from, insert, sock);
+	UpdateStageApply_runtime += stage.reset();
 #ifdef PROFILE_RECEIVE_UPDATE
 	CollectorEngine_ruc_collect_runtime.Add(rt.tick(rt_last));
 #endif
@@ -431,6 +519,7 @@ bool CollectorEngine::ValidateClassAd(int command,ClassAd *clientAd,Sock *sock)
 	  case MERGE_STARTD_AD:
 	  case UPDATE_STARTD_AD:
 	  case UPDATE_STARTD_AD_WITH_ACK:
+	  case UPDATE_STARTD_AD_DELTA:
 		  ipattr = ATTR_STARTD_IP_ADDR;
 		  break;
 	  case UPDATE_OWN_SUBMITTOR_AD:
@@ -555,7 +644,21 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 		repeatStartdAds = param_integer("COLLECTOR_REPEAT_STARTD_ADS",0);
 	}
 
-	if( !ValidateClassAd(command,clientAd,sock) ) {
+	// A delta update only carries the attributes that changed, so validate
+	// it as if it had been applied to the ad that it will be applied to.
+	ClassAd *deltaBase = NULL;
+	if (command == UPDATE_STARTD_AD_DELTA && makeStartdAdHashKey(hk, clientAd)) {
+		if (StartdAds.lookup(hk, deltaBase) == 0) {
+			clientAd->ChainToAd(deltaBase);
+		} else {
+			deltaBase = NULL;
+		}
+	}
+	bool valid = ValidateClassAd(command,clientAd,sock);
+	if (deltaBase) {
+		clientAd->Unchain();
+	}
+	if( !valid ) {
 	    insert = -4;
 		return NULL;
 	}
@@ -686,6 +789,36 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 							  clientAd, hk, hashString, insert, from );
 		break;
 
+	  case UPDATE_STARTD_AD_DELTA:
+		if (!makeStartdAdHashKey (hk, clientAd))
+		{
+			dprintf (D_ALWAYS, "Could not make hashkey --- ignoring ad\n");
+			insert = -3;
+			retVal = 0;
+			break;
+		}
+		hashString.Build( hk );
+		retVal=applyDeltaClassAd (StartdAds, "StartdAd     ", "Start",
+							  clientAd, hk, hashString, insert );
+
+		// the private ad delta follows the public one
+		if (retVal && sock)
+		{
+			pvtAd = new ClassAd;
+			if( !getClassAdEx(sock, *pvtAd, m_get_ad_options) )
+			{
+				dprintf(D_FULLDEBUG,"\t(Could not get startd's private ad delta)\n");
+				delete pvtAd;
+				break;
+			}
+			if ( ! applyDeltaClassAd (StartdPrivateAds, "StartdPvtAd  ",
+								  "StartdPvt", pvtAd, hk, hashString, insPvt ) )
+			{
+				delete pvtAd;
+			}
+		}
+		break;
+
 	  case UPDATE_SCHEDD_AD:
 		if (!makeScheddAdHashKey (hk, clientAd))
 		{
@@ -957,7 +1090,7 @@ int CollectorEngine::remove (AdTypes t_AddType, const ClassAd & c_query, bool *q
 				hk.sprint( hkString );
 				iRet = !table->remove(hk);
 				dprintf (D_ALWAYS,"\t\t**** Removed(%d) ad(s): \"%s\"\n", iRet, hkString.Value() );
-				delete pAd;
+				retireAd(pAd);
 			}
 		}
 	}
@@ -981,6 +1114,10 @@ int CollectorEngine::expire( AdTypes adType, const ClassAd & query, bool * query
                 cAd->Assign( ATTR_LAST_HEARD_FROM, 1 );
                 
                 if( CollectorDaemon::offline_plugin_.expire( * cAd ) == true ) {
+                    CollectorAdIndex * index = findIndex( * hTable );
+                    if( index ) { index->insert( cAd ); }
+                    scheduleExpiry( * hTable, cAd, hKey );
+                    notifyChanged( * hTable, cAd, cAd );
                     return rVal;
                 }
                 
@@ -995,7 +1132,7 @@ int CollectorEngine::expire( AdTypes adType, const ClassAd & query, bool * query
                 hKey.sprint( hkString );                
                 dprintf( D_ALWAYS, "\t\t**** Removed(%d) stale ad(s): \"%s\"\n", rVal, hkString.Value() );
 
-                delete cAd;
+                retireAd( cAd );
             }
         }
     }
@@ -1011,6 +1148,13 @@ remove (AdTypes adType, AdNameHashKey &hk)
 	if (!LookupByAdType(adType, table, func)) {
 		return 0;
 	}
+	ClassAd *ad = NULL;
+	if (table->lookup(hk, ad) == 0) {
+		CollectorAdIndex *index = findIndex(*table);
+		if (index) { index->remove(ad); }
+		m_expiry.cancel(ad);
+		notifyRemoved(ad);
+	}
 	return !table->remove(hk);
 }
 
@@ -1075,6 +1219,11 @@ updateClassAd (CollectorHashTable &hashTable,
 			new_ad->Assign( ATTR_LAST_FORWARDED, (int)time(NULL) );
 		}
 
+		CollectorAdIndex *index = findIndex(hashTable);
+		if (index) { index->insert(new_ad); }
+		scheduleExpiry(hashTable, new_ad, hk);
+		notifyChanged(hashTable, NULL, new_ad);
+
 		return new_ad;
 	}
 	else
@@ -1124,7 +1273,12 @@ updateClassAd (CollectorHashTable &hashTable,
 
 		if (isSelfAd(old_ad)) { __self_ad__ = new_ad; }
 
-		delete old_ad;
+		notifyChanged(hashTable, old_ad, new_ad);
+		retireAd(old_ad);
+
+		CollectorAdIndex *index = findIndex(hashTable);
+		if (index) { index->insert(new_ad); }
+		scheduleExpiry(hashTable, new_ad, hk);
 
 		insert = 0;
 		return new_ad;
@@ -1167,12 +1321,98 @@ mergeClassAd (CollectorHashTable &hashTable,
 		new_ad_copy.Delete(ATTR_TARGET_TYPE);
 
 		// Now, finally, merge the new ClassAd into the old one
+		// and re-file it under the merged values.
 		MergeClassAds(old_ad,&new_ad_copy,true);
+
+		CollectorAdIndex *index = findIndex(hashTable);
+		if (index) { index->insert(old_ad); }
+		scheduleExpiry(hashTable, old_ad, hk);
+		notifyChanged(hashTable, old_ad, old_ad);
 	}
 	delete new_ad;
 	return old_ad;
 }
 
+ClassAd * CollectorEngine::
+applyDeltaClassAd (CollectorHashTable &hashTable,
+				   const char *adType,
+				   const char *label,
+				   ClassAd *delta,
+				   AdNameHashKey &hk,
+				   const MyString &hashString,
+				   int  &insert )
+{
+	ClassAd		*cur_ad = NULL;
+	long long	base_seq = -1, cur_seq = -1;
+	long long	delta_stime = -1, cur_stime = -1;
+
+	insert = 0;
+
+	// The delta can only be applied to the ad that it was made from.
+	// If we don't have that ad, (we missed an update or were restarted)
+	// drop the delta; the daemon periodically sends a full ad, which
+	// brings us back in sync.
+	if ( hashTable.lookup (hk, cur_ad) == -1 )
+	{
+		dprintf (D_FULLDEBUG, "%s: Ignoring delta update for \"%s\" because "
+				 "no existing ad matches.\n", adType, hashString.Value() );
+		collectorStats->global.DeltaUpdatesRejected += 1;
+		insert = -5;
+		return NULL;
+	}
+	if ( ! ClassAdDeltaAppliesTo(*cur_ad, *delta) ||
+		 ! delta->LookupInteger(ATTR_DAEMON_START_TIME, delta_stime) ||
+		 ! cur_ad->LookupInteger(ATTR_DAEMON_START_TIME, cur_stime) ||
+		 delta_stime != cur_stime )
+	{
+		delta->LookupInteger(ATTR_UPDATE_DELTA_BASE, base_seq);
+		cur_ad->LookupInteger(ATTR_UPDATE_SEQUENCE_NUMBER, cur_seq);
+		dprintf (D_FULLDEBUG, "%s: Ignoring delta update for \"%s\" because "
+				 "it is based on update %lld, but we have update %lld.\n",
+				 adType, hashString.Value(), base_seq, cur_seq );
+		collectorStats->global.DeltaUpdatesRejected += 1;
+		insert = -5;
+		return NULL;
+	}
+
+	dprintf (D_FULLDEBUG, "%s: Applying delta update for ... \"%s\"\n",
+			 adType, hashString.Value() );
+
+	// Update statistics, but not for private ads we can't see
+	if (strcmp(label, "StartdPvt") != 0) {
+		collectorStats->update( label, cur_ad, delta );
+		collectorStats->global.DeltaUpdates += 1;
+	}
+
+	// Take the ad out of the index while we change it
+	CollectorAdIndex *index = findIndex(hashTable);
+	if (index) { index->remove(cur_ad); }
+
+	static AttrNameSet ignore;
+	if (ignore.empty()) {
+		ignore.insert(ATTR_MY_TYPE);
+		ignore.insert(ATTR_TARGET_TYPE);
+		ignore.insert(ATTR_AUTHENTICATED_IDENTITY);
+		ignore.insert("AuthenticationMethod");
+	}
+	ApplyClassAdDelta(cur_ad, *delta, &ignore);
+
+	// The authenticated identity is that of the sender of this update
+	// rather than the one that sent the full ad.
+	CopyAttribute(ATTR_AUTHENTICATED_IDENTITY, *cur_ad, *delta);
+	CopyAttribute("AuthenticationMethod", *cur_ad, *delta);
+	if ( ! delta->LookupExpr(ATTR_LAST_HEARD_FROM)) {
+		cur_ad->Assign(ATTR_LAST_HEARD_FROM, (int)time(NULL));
+	}
+
+	if (index) { index->insert(cur_ad); }
+	scheduleExpiry(hashTable, cur_ad, hk);
+	notifyChanged(hashTable, cur_ad, cur_ad);
+
+	delete delta;
+	return cur_ad;
+}
+
 
 void
 CollectorEngine::
@@ -1188,52 +1428,66 @@ housekeeper()
 		return;
 	}
 
+	if ( ! m_expiryResync) {
+		dprintf (D_ALWAYS, "Housekeeper:  Ready to clean old ads (%d scheduled)\n", (int)m_expiry.size());
+		expireDueAds(now);
+
+		// cron manager
+		event_mgr();
+
+		dprintf (D_ALWAYS, "Housekeeper:  Done cleaning\n");
+		return;
+	}
+
+	// the default lifetime changed, scan all of the tables once to expire
+	// the ads that are now stale and reschedule the rest.
+	m_expiryResync = false;
 	dprintf (D_ALWAYS, "Housekeeper:  Ready to clean old ads\n");
 
 	dprintf (D_ALWAYS, "\tCleaning StartdAds ...\n");
-	cleanHashTable (StartdAds, now, makeStartdAdHashKey);
+	cleanHashTable (StartdAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning StartdPrivateAds ...\n");
-	cleanHashTable (StartdPrivateAds, now, makeStartdAdHashKey);
+	cleanHashTable (StartdPrivateAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning ScheddAds ...\n");
-	cleanHashTable (ScheddAds, now, makeScheddAdHashKey);
+	cleanHashTable (ScheddAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning SubmittorAds ...\n");
-	cleanHashTable (SubmittorAds, now, makeScheddAdHashKey);
+	cleanHashTable (SubmittorAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning LicenseAds ...\n");
-	cleanHashTable (LicenseAds, now, makeLicenseAdHashKey);
+	cleanHashTable (LicenseAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning MasterAds ...\n");
-	cleanHashTable (MasterAds, now, makeMasterAdHashKey);
+	cleanHashTable (MasterAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning CkptServerAds ...\n");
-	cleanHashTable (CkptServerAds, now, makeCkptSrvrAdHashKey);
+	cleanHashTable (CkptServerAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning CollectorAds ...\n");
-	cleanHashTable (CollectorAds, now, makeCollectorAdHashKey);
+	cleanHashTable (CollectorAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning StorageAds ...\n");
-	cleanHashTable (StorageAds, now, makeStorageAdHashKey);
+	cleanHashTable (StorageAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning AccountingAds ...\n");
-	cleanHashTable (AccountingAds, now, makeAccountingAdHashKey);
+	cleanHashTable (AccountingAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning NegotiatorAds ...\n");
-	cleanHashTable (NegotiatorAds, now, makeNegotiatorAdHashKey);
+	cleanHashTable (NegotiatorAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning HadAds ...\n");
-	cleanHashTable (HadAds, now, makeHadAdHashKey);
+	cleanHashTable (HadAds, now);
 
     dprintf (D_ALWAYS, "\tCleaning GridAds ...\n");
-	cleanHashTable (GridAds, now, makeGridAdHashKey);
+	cleanHashTable (GridAds, now);
 
 	dprintf (D_ALWAYS, "\tCleaning Generic Ads ...\n");
 	CollectorHashTable *cht;
 	GenericAds.startIterations();
 	while (GenericAds.iterate(cht)) {
-		cleanHashTable (*cht, now, makeGenericAdHashKey);
+		cleanHashTable (*cht, now);
 	}
 
 	// cron manager
@@ -1243,62 +1497,239 @@ housekeeper()
 }
 
 void CollectorEngine::
-cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey)
+cleanHashTable (CollectorHashTable &hashTable, time_t now)
 {
 	ClassAd  *ad;
 	int   	 timeStamp;
-	int		 max_lifetime;
+	time_t   expires;
 	AdNameHashKey  hk;
-	double   timeDiff;
-	MyString	hkString;
 
 	hashTable.startIterations ();
-	while (hashTable.iterate (ad))
+	while (hashTable.iterate (hk, ad))
 	{
 		// Read the timestamp of the ad
-		if (!ad->LookupInteger (ATTR_LAST_HEARD_FROM, timeStamp)) {
+		if ( ! getExpiryTime(ad, timeStamp, expires)) {
 			dprintf (D_ALWAYS, "\t\tError looking up time stamp on ad\n");
 			continue;
 		}
 
-		// how long has it been since the last update?
-		timeDiff = difftime( now, timeStamp );
+		// check if it has expired
+		if (expires < now) {
+			expireAd(hashTable, ad, hk, timeStamp, now);
+		} else {
+			m_expiry.schedule(ad, expires, &hashTable, hk);
+		}
+	}
+}
+
+// when an ad that was last heard from at timeStamp expires.
+// returns false if the ad has no timestamp.
+bool CollectorEngine::
+getExpiryTime (ClassAd *ad, int &timeStamp, time_t &expires)
+{
+	int max_lifetime;
 
-		if( !ad->LookupInteger( ATTR_CLASSAD_LIFETIME, max_lifetime ) ) {
-			max_lifetime = machineUpdateInterval;
+	if ( ! ad->LookupInteger(ATTR_LAST_HEARD_FROM, timeStamp)) {
+		return false;
+	}
+	if ( ! ad->LookupInteger(ATTR_CLASSAD_LIFETIME, max_lifetime)) {
+		max_lifetime = machineUpdateInterval;
+	}
+	expires = (time_t)timeStamp + max_lifetime;
+	return true;
+}
+
+void CollectorEngine::
+scheduleExpiry (CollectorHashTable &hashTable, ClassAd *ad, const AdNameHashKey &hk, time_t not_before)
+{
+	int timeStamp;
+	time_t expires;
+	if ( ! getExpiryTime(ad, timeStamp, expires)) {
+		m_expiry.cancel(ad);
+		return;
+	}
+	if (expires < not_before) {
+		expires = not_before;
+	}
+	m_expiry.schedule(ad, expires, &hashTable, hk);
+}
+
+void CollectorEngine::
+expireDueAds (time_t now)
+{
+	ClassAd *ad;
+	CollectorHashTable *table;
+	AdNameHashKey hk;
+	int timeStamp;
+	time_t expires;
+
+	while (m_expiry.popExpired(now, ad, table, hk)) {
+		// skip entries for ads that are no longer in the table. this
+		// compares the pointers before looking at the ad, since an ad
+		// that was taken out of its table may already have been deleted.
+		ClassAd *cur_ad = NULL;
+		if (table->lookup(hk, cur_ad) == -1 || cur_ad != ad) {
+			continue;
 		}
 
-		// check if it has expired
-		if ( timeDiff > (double) max_lifetime )
-		{
-			// then remove it from the segregated table
-			(*makeKey) (hk, ad);
-			hk.sprint( hkString );
-			if( timeStamp == 0 ) {
-				dprintf (D_ALWAYS,"\t\t**** Removing invalidated ad: \"%s\"\n", hkString.Value() );
-			}
-			else {
-				dprintf (D_ALWAYS,"\t\t**** Removing stale ad: \"%s\"\n", hkString.Value() );
-			    /* let the off-line plug-in know we are about to expire this ad, so it can
-				   potentially mark the ad absent. if expire() returns false, then delete
-				   the ad as planned; if it return true, it was likely marked as absent,
-				   so then this ad should NOT be deleted. */
-				if ( CollectorDaemon::offline_plugin_.expire( *ad ) == true ) {
-					// plugin say to not delete this ad, so continue
-					continue;
-				} else {
-					dprintf (D_ALWAYS,"\t\t**** Removing stale ad: \"%s\"\n", hkString.Value() );
-				}
-			}
-			if (hashTable.remove (hk) == -1)
-			{
-				dprintf (D_ALWAYS, "\t\tError while removing ad\n");
-			}
-			delete ad;
+		if ( ! getExpiryTime(ad, timeStamp, expires)) {
+			dprintf (D_ALWAYS, "\t\tError looking up time stamp on ad\n");
+			continue;
+		}
+
+		// the ad may have been changed since it was scheduled
+		if (expires >= now) {
+			m_expiry.schedule(ad, expires, table, hk);
+			continue;
+		}
+
+		expireAd(*table, ad, hk, timeStamp, now);
+	}
+}
+
+// remove a stale ad from its table. returns false if the offline plugin
+// decided to keep the ad.
+bool CollectorEngine::
+expireAd (CollectorHashTable &hashTable, ClassAd *ad, AdNameHashKey &hk, int timeStamp, time_t now)
+{
+	MyString	hkString;
+
+	hk.sprint( hkString );
+	if( timeStamp == 0 ) {
+		dprintf (D_ALWAYS,"\t\t**** Removing invalidated ad: \"%s\"\n", hkString.Value() );
+	}
+	else {
+		dprintf (D_ALWAYS,"\t\t**** Removing stale ad: \"%s\"\n", hkString.Value() );
+	    /* let the off-line plug-in know we are about to expire this ad, so it can
+		   potentially mark the ad absent. if expire() returns false, then delete
+		   the ad as planned; if it return true, it was likely marked as absent,
+		   so then this ad should NOT be deleted. */
+		if ( CollectorDaemon::offline_plugin_.expire( *ad ) == true ) {
+			// plugin say to not delete this ad, so continue
+			// the plugin may have changed the ad, so re-index it.
+			CollectorAdIndex *index = findIndex(hashTable);
+			if (index) { index->insert(ad); }
+			// and check it again on the next pass at the earliest
+			scheduleExpiry(hashTable, ad, hk, now);
+			notifyChanged(hashTable, ad, ad);
+			return false;
+		} else {
+			dprintf (D_ALWAYS,"\t\t**** Removing stale ad: \"%s\"\n", hkString.Value() );
+		}
+	}
+	if (hashTable.remove (hk) == -1)
+	{
+		dprintf (D_ALWAYS, "\t\tError while removing ad\n");
+	}
+	retireAd(ad);
+	return true;
+}
+
+void CollectorEngine::
+addWatcher(CollectorAdWatcher *watcher)
+{
+	m_watchers.push_back(watcher);
+}
+
+void CollectorEngine::
+removeWatcher(CollectorAdWatcher *watcher)
+{
+	m_watchers.erase(std::remove(m_watchers.begin(), m_watchers.end(), watcher), m_watchers.end());
+}
+
+CollectorHashTable * CollectorEngine::
+getTable(AdTypes adType)
+{
+	CollectorHashTable *table = NULL;
+	CollectorEngine::HashFunc func;
+	if ( ! LookupByAdType(adType, table, func)) {
+		return NULL;
+	}
+	return table;
+}
+
+// the watchers may remove themselves while being notified, so walk a copy of the list
+void CollectorEngine::
+notifyChanged(CollectorHashTable &table, ClassAd *old_ad, ClassAd *new_ad)
+{
+	if (m_watchers.empty()) {
+		return;
+	}
+	std::vector<CollectorAdWatcher*> watchers(m_watchers);
+	for (auto it = watchers.begin(); it != watchers.end(); ++it) {
+		if (std::find(m_watchers.begin(), m_watchers.end(), *it) != m_watchers.end()) {
+			(*it)->adChanged(table, old_ad, new_ad);
 		}
 	}
 }
 
+void CollectorEngine::
+notifyRemoved(ClassAd *ad)
+{
+	if (m_watchers.empty()) {
+		return;
+	}
+	std::vector<CollectorAdWatcher*> watchers(m_watchers);
+	for (auto it = watchers.begin(); it != watchers.end(); ++it) {
+		if (std::find(m_watchers.begin(), m_watchers.end(), *it) != m_watchers.end()) {
+			(*it)->adRemoved(ad);
+		}
+	}
+}
+
+unsigned long CollectorEngine::
+beginSnapshot()
+{
+	unsigned long epoch = ++m_snapshotEpoch;
+	m_activeSnapshots[epoch] += 1;
+	return epoch;
+}
+
+void CollectorEngine::
+endSnapshot(unsigned long epoch)
+{
+	std::map<unsigned long, int>::iterator it = m_activeSnapshots.find(epoch);
+	if (it == m_activeSnapshots.end()) {
+		dprintf(D_ALWAYS, "endSnapshot called for unknown snapshot epoch %lu\n", epoch);
+		return;
+	}
+	if (--(it->second) <= 0) {
+		m_activeSnapshots.erase(it);
+	}
+	reclaimRetiredAds();
+}
+
+void CollectorEngine::
+retireAd(ClassAd *ad)
+{
+	if ( ! ad) {
+		return;
+	}
+	for (std::map<CollectorHashTable*, CollectorAdIndex>::iterator it = m_indexes.begin(); it != m_indexes.end(); ++it) {
+		it->second.remove(ad);
+	}
+	m_expiry.cancel(ad);
+	notifyRemoved(ad);
+	if (m_activeSnapshots.empty()) {
+		delete ad;
+		return;
+	}
+	// any snapshot begun at or before the current epoch may still hold this pointer
+	m_retiredAds.push_back(std::make_pair(m_snapshotEpoch, ad));
+}
+
+void CollectorEngine::
+reclaimRetiredAds()
+{
+	// ads are retired in epoch order, so we can stop at the first one
+	// that is still visible to the oldest active snapshot.
+	unsigned long oldest = m_activeSnapshots.empty() ? (unsigned long)-1 : m_activeSnapshots.begin()->first;
+	while ( ! m_retiredAds.empty() && m_retiredAds.front().first < oldest) {
+		delete m_retiredAds.front().second;
+		m_retiredAds.pop_front();
+	}
+}
+
 
 bool
 CollectorEngine::LookupByAdType(AdTypes adType,
@@ -1367,7 +1798,7 @@ CollectorEngine::LookupByAdType(AdTypes adType,
 }
 
 
-static void
+void CollectorEngine::
 purgeHashTable( CollectorHashTable &table )
 {
 	ClassAd* ad;
@@ -1377,7 +1808,7 @@ purgeHashTable( CollectorHashTable &table )
 		if( table.remove(hk) == -1 ) {
 			dprintf( D_ALWAYS, "\t\tError while removing ad\n" );
 		}		
-		delete ad;
+		retireAd(ad);
 	}
 }
 
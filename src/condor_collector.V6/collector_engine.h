@@ -22,9 +22,31 @@
 
 #include "condor_classad.h"
 
+#include <deque>
+#include <map>
+#include <vector>
+
 #include "collector_stats.h"
+#include "collector_index.h"
+#include "collector_expiry.h"
 #include "hashkey.h"
 
+// Told about changes to the ads in the collector tables.
+// See CollectorEngine::addWatcher().
+class CollectorAdWatcher
+{
+  public:
+	virtual ~CollectorAdWatcher() {}
+
+	// an ad was inserted into the table (old_ad is NULL), replaced by a new
+	// ad, or changed in place (old_ad == new_ad).  old_ad is still valid
+	// during the call.
+	virtual void adChanged(CollectorHashTable &table, ClassAd *old_ad, ClassAd *new_ad) = 0;
+
+	// an ad was taken out of its table.  the ad is still valid during the call.
+	virtual void adRemoved(ClassAd *ad) = 0;
+};
+
 class CollectorEngine : public Service
 {
   public:
@@ -70,6 +92,17 @@ class CollectorEngine : public Service
 	// walk specified hash table with the given visit procedure
 	int walkHashTable (AdTypes, int (*)(ClassAd *));
 
+	// walk the ads of the specified table that could match the given
+	// constraint.  if the table has an attribute index and the constraint
+	// has an indexable conjunct, only the ads filed under that value are
+	// visited, otherwise this is the same as walkHashTable. the scan
+	// function must still evaluate the constraint.
+	int walkIndexedTable (AdTypes, classad::ExprTree *constraint, int (*)(ClassAd *));
+
+	// set the attributes that are indexed in the startd, schedd, submitter
+	// and master tables and rebuild the indexes. an empty set disables indexing.
+	void setIndexAttributes(const classad::References &attrs);
+
 	// Walk through a specific (non-generic, non-ANY) table using a lambda
 	template<typename T>
 	int walkConcreteTable(AdTypes adType, T scanFunction) {
@@ -106,9 +139,31 @@ class CollectorEngine : public Service
 	// Publish stats into the collector's ClassAd
 	//int publishStats( ClassAd *ad );
 
+	// In-process query snapshots.  A query that is served in-process
+	// without forking calls beginSnapshot() before scanning the tables
+	// and endSnapshot() once the last result has been written.  While any
+	// snapshot is active, ads that are replaced or removed from the tables
+	// are retired rather than deleted, so the pointers held by the query
+	// stay valid until every snapshot that could reference them is done.
+	unsigned long beginSnapshot();
+	void endSnapshot(unsigned long epoch);
+	int activeSnapshots() const { return (int)m_activeSnapshots.size(); }
+	int retiredAdCount() const { return (int)m_retiredAds.size(); }
+
 		// returns true on success; false on failure (and sets error_desc)
 	bool setCollectorRequirements( char const *str, MyString &error_desc );
 
+	// Watchers are told about every ad that is inserted, changed or removed
+	// by an update, invalidation or expiration.  A watcher may remove itself
+	// from inside one of its callbacks.
+	void addWatcher(CollectorAdWatcher *watcher);
+	void removeWatcher(CollectorAdWatcher *watcher);
+	int watcherCount() const { return (int)m_watchers.size(); }
+
+	// the table that holds the given type of ad, or NULL for the generic
+	// and ANY types, which span several tables.
+	CollectorHashTable *getTable(AdTypes);
+
   private:
 	typedef bool (*HashFunc) (AdNameHashKey &, const ClassAd *);
 
@@ -154,7 +209,36 @@ class CollectorEngine : public Service
 
 	void  housekeeper ();
 	int  housekeeperTimerID;
-	void cleanHashTable (CollectorHashTable &, time_t, HashFunc);
+	void cleanHashTable (CollectorHashTable &, time_t);
+	void purgeHashTable (CollectorHashTable &);
+
+	// ads ordered by the time they expire. every ad put into a table is
+	// scheduled here, so the periodic housekeeper only visits the ads that
+	// are due. when m_expiryResync is set (because the default lifetime
+	// changed) the next pass scans the tables instead and reschedules every ad.
+	CollectorExpiryQueue m_expiry;
+	bool m_expiryResync;
+	bool getExpiryTime (ClassAd *, int &timeStamp, time_t &expires);
+	void scheduleExpiry (CollectorHashTable &, ClassAd *, const AdNameHashKey &, time_t not_before = 0);
+	void expireDueAds (time_t now);
+	bool expireAd (CollectorHashTable &, ClassAd *, AdNameHashKey &, int timeStamp, time_t now);
+
+	// delete an ad that has been taken out of its table, or park it on
+	// the retired list if an active query snapshot may still refer to it.
+	// this also takes the ad out of the attribute indexes.
+	void retireAd (ClassAd *);
+	void reclaimRetiredAds ();
+	unsigned long m_snapshotEpoch;
+	std::map<unsigned long, int> m_activeSnapshots; // epoch -> refcount
+	std::deque< std::pair<unsigned long, ClassAd*> > m_retiredAds;
+
+	std::vector<CollectorAdWatcher*> m_watchers;
+	void notifyChanged (CollectorHashTable &, ClassAd *old_ad, ClassAd *new_ad);
+	void notifyRemoved (ClassAd *);
+
+	// secondary attribute indexes, keyed by the table they index
+	CollectorAdIndex *findIndex (CollectorHashTable &);
+	std::map<CollectorHashTable*, CollectorAdIndex> m_indexes;
 	ClassAd* updateClassAd(CollectorHashTable&,const char*, const char *,
 						   ClassAd*,AdNameHashKey&, const MyString &, int &, 
 						   const condor_sockaddr& );
@@ -168,6 +252,17 @@ class CollectorEngine : public Service
 							int  &insert,
 							const condor_sockaddr& /*from*/ );
 
+	// apply a delta update to the ad in the table, if the ad is the one
+	// the delta was made from.  on success the delta is deleted and the
+	// updated ad is returned.
+	ClassAd * applyDeltaClassAd (CollectorHashTable &hashTable,
+							const char *adType,
+							const char *label,
+							ClassAd *delta,
+							AdNameHashKey &hk,
+							const MyString &hashString,
+							int  &insert );
+
 	// support for dynamically created tables
 	CollectorHashTable *findOrCreateTable(MyString &str);
 
@@ -0,0 +1,72 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_debug.h"
+
+#include "collector_expiry.h"
+
+void
+CollectorExpiryQueue::schedule(ClassAd *ad, time_t expires, CollectorHashTable *table, const AdNameHashKey &hk)
+{
+	if ( ! ad) {
+		return;
+	}
+	cancel(ad);
+
+	Entry entry;
+	entry.ad = ad;
+	entry.table = table;
+	entry.hk = hk;
+	m_byAd[ad] = m_byTime.insert(std::make_pair(expires, entry));
+}
+
+void
+CollectorExpiryQueue::cancel(ClassAd *ad)
+{
+	std::map<ClassAd*, TimeMap::iterator>::iterator found = m_byAd.find(ad);
+	if (found == m_byAd.end()) {
+		return;
+	}
+	m_byTime.erase(found->second);
+	m_byAd.erase(found);
+}
+
+void
+CollectorExpiryQueue::clear()
+{
+	m_byTime.clear();
+	m_byAd.clear();
+}
+
+bool
+CollectorExpiryQueue::popExpired(time_t now, ClassAd *&ad, CollectorHashTable *&table, AdNameHashKey &hk)
+{
+	TimeMap::iterator first = m_byTime.begin();
+	if (first == m_byTime.end() || first->first >= now) {
+		return false;
+	}
+	ad = first->second.ad;
+	table = first->second.table;
+	hk = first->second.hk;
+	m_byAd.erase(ad);
+	m_byTime.erase(first);
+	return true;
+}
@@ -0,0 +1,69 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef __COLLECTOR_EXPIRY_H__
+#define __COLLECTOR_EXPIRY_H__
+
+#include "condor_classad.h"
+#include "hashkey.h"
+
+#include <map>
+
+// The ads of the collector tables ordered by the time they expire, so that
+// the housekeeper only has to look at the ads that are due rather than at
+// every ad in every table.
+//
+// Each ad has at most one entry; scheduling an ad again moves it.  The queue
+// does not look inside the ads, so an entry may be out of date if the ad was
+// changed without being rescheduled; the housekeeper checks the ad again
+// before expiring it.
+class CollectorExpiryQueue
+{
+  public:
+	CollectorExpiryQueue() {}
+	~CollectorExpiryQueue() {}
+
+	// file the ad, which is in the given table under the given key, to
+	// expire at the given time.
+	void schedule(ClassAd *ad, time_t expires, CollectorHashTable *table, const AdNameHashKey &hk);
+	void cancel(ClassAd *ad);
+	void clear();
+	size_t size() const { return m_byAd.size(); }
+
+	// take the entry that expires first out of the queue, if it expires
+	// before now.  returns false when no more ads are due.
+	bool popExpired(time_t now, ClassAd *&ad, CollectorHashTable *&table, AdNameHashKey &hk);
+
+  private:
+	struct Entry {
+		ClassAd *ad;
+		CollectorHashTable *table;
+		AdNameHashKey hk;
+	};
+	typedef std::multimap<time_t, Entry> TimeMap;
+
+	TimeMap m_byTime;
+	std::map<ClassAd*, TimeMap::iterator> m_byAd;
+
+	// no copying, m_byAd holds iterators into m_byTime
+	CollectorExpiryQueue(const CollectorExpiryQueue &);
+	CollectorExpiryQueue & operator=(const CollectorExpiryQueue &);
+};
+
+#endif // __COLLECTOR_EXPIRY_H__
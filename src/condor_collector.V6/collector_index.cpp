@@ -0,0 +1,204 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_debug.h"
+
+#include "collector_index.h"
+
+// key used in m_ad_keys for an ad that is filed in the 'other' list.
+static const char OTHER_KEY[] = "?";
+
+void
+CollectorAdIndex::configure(const classad::References &attrs)
+{
+	clear();
+	m_attrs = attrs;
+	m_index.clear();
+	for (classad::References::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it) {
+		m_index[*it];
+	}
+}
+
+void
+CollectorAdIndex::clear()
+{
+	for (auto it = m_index.begin(); it != m_index.end(); ++it) {
+		it->second.values.clear();
+		it->second.other.clear();
+	}
+	m_ad_keys.clear();
+}
+
+bool
+CollectorAdIndex::valueKey(const classad::Value &val, std::string &key)
+{
+	std::string str;
+	bool bval;
+	if (val.IsStringValue(str)) {
+		key = "s:";
+		key += str;
+		lower_case(key);
+		return true;
+	} else if (val.IsBooleanValue(bval)) {
+		key = bval ? "b:1" : "b:0";
+		return true;
+	}
+	return false;
+}
+
+void
+CollectorAdIndex::insert(ClassAd *ad)
+{
+	if ( ! ad || m_attrs.empty()) {
+		return;
+	}
+
+	// if the ad is already filed, take it out first so we don't leave stale keys behind
+	if (m_ad_keys.count(ad)) {
+		remove(ad);
+	}
+
+	std::vector<std::string> &keys = m_ad_keys[ad];
+	keys.resize(m_attrs.size());
+
+	size_t ix = 0;
+	for (classad::References::const_iterator it = m_attrs.begin(); it != m_attrs.end(); ++it, ++ix) {
+		classad::ExprTree *expr = ad->Lookup(*it);
+		if ( ! expr) {
+			continue; // missing attributes never compare equal to a literal
+		}
+		AttrIndex &index = m_index[*it];
+		classad::Value val;
+		if (ExprTreeIsLiteral(expr, val) && valueKey(val, keys[ix])) {
+			index.values[keys[ix]].insert(ad);
+		} else {
+			keys[ix] = OTHER_KEY;
+			index.other.insert(ad);
+		}
+	}
+}
+
+void
+CollectorAdIndex::remove(ClassAd *ad)
+{
+	auto found = m_ad_keys.find(ad);
+	if (found == m_ad_keys.end()) {
+		return;
+	}
+
+	const std::vector<std::string> &keys = found->second;
+	size_t ix = 0;
+	for (classad::References::const_iterator it = m_attrs.begin(); it != m_attrs.end() && ix < keys.size(); ++it, ++ix) {
+		const std::string &key = keys[ix];
+		if (key.empty()) {
+			continue;
+		}
+		AttrIndex &index = m_index[*it];
+		if (key == OTHER_KEY) {
+			index.other.erase(ad);
+		} else {
+			auto vit = index.values.find(key);
+			if (vit != index.values.end()) {
+				vit->second.erase(ad);
+				if (vit->second.empty()) {
+					index.values.erase(vit);
+				}
+			}
+		}
+	}
+	m_ad_keys.erase(found);
+}
+
+void
+CollectorAdIndex::indexableConjuncts(classad::ExprTree *tree,
+	std::vector< std::pair<std::string, std::string> > &conjuncts) const
+{
+	tree = SkipExprParens(tree);
+	if ( ! tree) {
+		return;
+	}
+
+	std::string attr;
+	if (tree->GetKind() == classad::ExprTree::OP_NODE) {
+		classad::Operation::OpKind op;
+		classad::ExprTree *t1, *t2, *t3;
+		((classad::Operation*)tree)->GetComponents(op, t1, t2, t3);
+		if (op == classad::Operation::LOGICAL_AND_OP) {
+			indexableConjuncts(t1, conjuncts);
+			indexableConjuncts(t2, conjuncts);
+			return;
+		}
+
+		classad::Value val;
+		std::string key;
+		if (ExprTreeIsAttrCmpLiteral(tree, op, attr, val) &&
+			(op == classad::Operation::EQUAL_OP || op == classad::Operation::META_EQUAL_OP) &&
+			m_attrs.count(attr) && valueKey(val, key))
+		{
+			conjuncts.push_back(std::make_pair(attr, key));
+		}
+	} else if (ExprTreeIsAttrRef(tree, attr) && m_attrs.count(attr)) {
+		// a bare attribute reference is a match when the attribute is true
+		conjuncts.push_back(std::make_pair(attr, std::string("b:1")));
+	}
+}
+
+bool
+CollectorAdIndex::candidates(classad::ExprTree *constraint, std::vector<ClassAd*> &ads) const
+{
+	if (m_attrs.empty() || ! constraint) {
+		return false;
+	}
+
+	std::vector< std::pair<std::string, std::string> > conjuncts;
+	indexableConjuncts(constraint, conjuncts);
+	if (conjuncts.empty()) {
+		return false;
+	}
+
+	// pick the conjunct that leaves the fewest ads to evaluate
+	const AdSet *best_values = NULL;
+	const AdSet *best_other = NULL;
+	size_t best_count = (size_t)-1;
+	static const AdSet no_ads;
+	for (auto it = conjuncts.begin(); it != conjuncts.end(); ++it) {
+		auto index = m_index.find(it->first);
+		if (index == m_index.end()) {
+			continue;
+		}
+		auto vit = index->second.values.find(it->second);
+		const AdSet *values = (vit == index->second.values.end()) ? &no_ads : &vit->second;
+		size_t count = values->size() + index->second.other.size();
+		if (count < best_count) {
+			best_count = count;
+			best_values = values;
+			best_other = &index->second.other;
+		}
+	}
+	if ( ! best_values) {
+		return false;
+	}
+
+	ads.reserve(ads.size() + best_count);
+	ads.insert(ads.end(), best_values->begin(), best_values->end());
+	ads.insert(ads.end(), best_other->begin(), best_other->end());
+	return true;
+}
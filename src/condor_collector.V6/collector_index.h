@@ -0,0 +1,94 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef __COLLECTOR_INDEX_H__
+#define __COLLECTOR_INDEX_H__
+
+#include "condor_classad.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Secondary indexes on a few attributes of the ads in one collector table.
+//
+// For each indexed attribute, ads are filed by the literal value of that
+// attribute.  String values are filed case-insensitively, since the ==
+// operator on strings is case-insensitive; boolean values are filed as
+// true or false.  Ads where the attribute is an expression or some other
+// kind of literal are kept in a separate list that is included in every
+// lookup, and ads where the attribute is missing are not filed at all,
+// since a comparison against a missing attribute can never be true.
+//
+// The index is only used to narrow down the set of ads a query constraint
+// must be evaluated against; the full constraint is still evaluated on
+// every candidate, so a lookup may return extra ads but never omits an ad
+// that could match.
+class CollectorAdIndex
+{
+  public:
+	CollectorAdIndex() {}
+	~CollectorAdIndex() {}
+
+	// set the attributes to index; this forgets all ads currently indexed.
+	void configure(const classad::References &attrs);
+	bool enabled() const { return ! m_attrs.empty(); }
+	const classad::References & attributes() const { return m_attrs; }
+
+	void insert(ClassAd *ad);
+	void remove(ClassAd *ad);
+	void clear();
+	size_t size() const { return m_ad_keys.size(); }
+
+	// Look for conjuncts of the constraint of the form Attr == "literal",
+	// Attr =?= "literal", Attr == true or a bare boolean Attr where Attr is
+	// indexed.  If any are found, the candidates for the most selective one
+	// are appended to ads and true is returned.  If the constraint has no
+	// indexable conjunct, false is returned and the caller must scan the
+	// whole table.
+	bool candidates(classad::ExprTree *constraint, std::vector<ClassAd*> &ads) const;
+
+  private:
+	typedef std::set<ClassAd*> AdSet;
+
+	struct AttrIndex {
+		std::map<std::string, AdSet> values; // value key -> ads with that value
+		AdSet other;                         // ads where the value cannot be keyed
+	};
+
+	// the value key of an ad attribute, or of a query literal.
+	// returns false if there is no key for the value.
+	static bool valueKey(const classad::Value &val, std::string &key);
+
+	// collect the indexable conjuncts of a constraint as (attr, value key) pairs
+	void indexableConjuncts(classad::ExprTree *tree,
+		std::vector< std::pair<std::string, std::string> > &conjuncts) const;
+
+	classad::References m_attrs;
+	std::map<std::string, AttrIndex, classad::CaseIgnLTStr> m_index;
+
+	// how each ad is currently filed, so that it can be removed again even if
+	// its attributes have been changed in the mean time. one entry per indexed
+	// attribute, in the order of m_attrs. empty means not filed, "?" means
+	// filed in the 'other' list.
+	std::map<ClassAd*, std::vector<std::string> > m_ad_keys;
+};
+
+#endif // __COLLECTOR_INDEX_H__
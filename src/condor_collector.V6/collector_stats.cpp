@@ -376,6 +376,16 @@ void UpdatesStats::Init()
 	STATS_POOL_ADD(Pool, "", PendingQueries, IF_BASICPUB);
 	STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "", DroppedQueries, IF_BASICPUB);
 
+	// stats for in-process snapshot queries.
+	STATS_POOL_ADD(Pool, "", ActiveQuerySnapshots, IF_BASICPUB);
+	STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "", SnapshotQueries, IF_BASICPUB);
+	STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "", IndexedQueries, IF_BASICPUB);
+	STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "", DeltaUpdates, IF_BASICPUB);
+	STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "", DeltaUpdatesRejected, IF_BASICPUB);
+	STATS_POOL_ADD(Pool, "", UpdateSocketBacklogBytes, IF_VERBOSEPUB);
+	STATS_POOL_ADD(Pool, "", ActiveWatches, IF_BASICPUB);
+	STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "", WatchEvents, IF_BASICPUB);
+
 	ADD_EXTERN_RUNTIME(Pool, HandleQuery, IF_VERBOSEPUB);
 	ADD_EXTERN_RUNTIME(Pool, HandleLocate, IF_VERBOSEPUB);
 
@@ -424,6 +434,12 @@ void UpdatesStats::Init()
 	bool enable = param_boolean("PUBLISH_COLLECTOR_ENGINE_PROFILING_STATS",false);
 	int prof_publevel = enable ? IF_BASICPUB : IF_VERBOSEPUB;
 	ADD_EXTERN_RUNTIME(Pool, CollectorEngine_receive_update, prof_publevel);
+
+	// the stages of receive_update: reading the ad off the wire, applying
+	// it to the tables, and handing it to the plugins and view collectors.
+	ADD_EXTERN_RUNTIME(Pool, UpdateStageRead, IF_VERBOSEPUB);
+	ADD_EXTERN_RUNTIME(Pool, UpdateStageApply, IF_VERBOSEPUB);
+	ADD_EXTERN_RUNTIME(Pool, UpdateStageForward, IF_VERBOSEPUB);
 #ifdef PROFILE_RECEIVE_UPDATE
 	ADD_EXTERN_RUNTIME(Pool, CollectorEngine_ru_pre_collect, prof_publevel);
 	ADD_EXTERN_RUNTIME(Pool, CollectorEngine_ru_collect, prof_publevel);
@@ -526,6 +542,18 @@ void UpdatesStats::Publish(ClassAd & ad, int flags) const
 	}
 	Pool.Publish(ad, flags);
 
+	// how well identical expressions are being shared between ads
+	unsigned long cache_values = 0, cache_uses = 0;
+	if (classad::ClassAdGetExpressionCaching() &&
+		classad::CachedExprEnvelope::_debug_get_usage(cache_values, cache_uses))
+	{
+		ad.Assign("ClassadCacheValues", (long long)cache_values);
+		ad.Assign("ClassadCacheUses", (long long)cache_uses);
+		if (cache_values) {
+			ad.Assign("ClassadCacheSharingRatio", (double)cache_uses / cache_values);
+		}
+	}
+
 	if (param_boolean("PUBLISH_COLLECTOR_ENGINE_PROFILING_STATS",false)) {
 		long dpf_skipped=-1, dpf_logged=-1;
 		double dpf_skipped_rt=-1, dpf_logged_rt=-1;
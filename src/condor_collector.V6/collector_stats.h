@@ -175,6 +175,26 @@ struct UpdatesStats {
 	stats_entry_abs<int> PendingQueries;
 	stats_entry_recent<long> DroppedQueries;
 
+	// in-process queries served from a table snapshot
+	stats_entry_abs<int> ActiveQuerySnapshots;
+	stats_entry_recent<long> SnapshotQueries;
+
+	// queries where an attribute index narrowed the scan
+	stats_entry_recent<long> IndexedQueries;
+
+	// startd delta updates applied, and those dropped because we did
+	// not have the ad they were made from
+	stats_entry_recent<long> DeltaUpdates;
+	stats_entry_recent<long> DeltaUpdatesRejected;
+
+	// bytes waiting to be read on the socket when an update finished,
+	// a rough measure of how far behind the update handler is running.
+	stats_entry_abs<int> UpdateSocketBacklogBytes;
+
+	// open WATCH_ADS connections, and the change events written to them
+	stats_entry_abs<int> ActiveWatches;
+	stats_entry_recent<long> WatchEvents;
+
 #ifdef TRACK_QUERIES_BY_SUBSYS
 	stats_entry_recent<long> InProcQueriesFrom[SUBSYSTEM_ID_COUNT]; // Track subsystems < the AUTO subsys.
 	stats_entry_recent<long> ForkQueriesFrom[SUBSYSTEM_ID_COUNT]; // Track subsystems < the AUTO subsys.
@@ -26,6 +26,29 @@
 #include "../condor_procapi/procapi.h"
 #include <limits>
 
+	// the most attributes and functions published from the ClassAd
+	// evaluation profile
+static const size_t MAX_PUBLISHED_PROFILE = 20;
+
+	// publish the entries of the ClassAd evaluation profile that used
+	// the most time, as a list of nested ads
+static void
+PublishEvalProfile(ClassAd *ad, const char *attr, const std::vector<classad::EvalProfile::Entry> &entries)
+{
+	std::vector<classad::ExprTree*> list;
+	for (size_t ii = 0; ii < entries.size() && ii < MAX_PUBLISHED_PROFILE; ii++) {
+		classad::ClassAd *entry = new classad::ClassAd();
+		entry->InsertAttr("Name", entries[ii].name);
+		if ( ! entries[ii].ad_type.empty()) {
+			entry->InsertAttr("AdType", entries[ii].ad_type);
+		}
+		entry->InsertAttr("Count", (long long)entries[ii].count);
+		entry->InsertAttr("Time", entries[ii].seconds);
+		list.push_back(entry);
+	}
+	ad->Insert(attr, classad::ExprList::MakeExprList(list));
+}
+
 int configured_statistics_window_quantum() {
     int quantum = param_integer("STATISTICS_WINDOW_QUANTUM_DAEMONCORE", INT_MAX, 1, INT_MAX);
     if (quantum >= INT_MAX)
@@ -152,6 +175,13 @@ bool SelfMonitorData::ExportData(ClassAd *ad, bool verbose /*=false*/)
             ad->Assign("MonitorSelfSysCpuTime",         sys_time);
             ad->Assign("MonitorSelfUserCpuTime",        user_time);
         }
+        if (classad::EvalProfile::Enabled()) {
+            std::vector<classad::EvalProfile::Entry> entries;
+            classad::EvalProfile::GetAttributes(entries);
+            PublishEvalProfile(ad, "MonitorSelfClassAdAttributeProfile", entries);
+            classad::EvalProfile::GetFunctions(entries);
+            PublishEvalProfile(ad, "MonitorSelfClassAdFunctionProfile", entries);
+        }
         success = true;
     }
 
@@ -735,6 +735,8 @@
 #define ATTR_CLASSAD_LIFETIME  "ClassAdLifetime"
 #define ATTR_UPDATE_PRIO  "UpdatePrio"
 #define ATTR_UPDATE_SEQUENCE_NUMBER  "UpdateSequenceNumber"
+#define ATTR_UPDATE_DELTA_BASE  "UpdateDeltaBase"
+#define ATTR_UPDATE_DELTA_REMOVED  "UpdateDeltaRemoved"
 #define ATTR_USE_GRID_SHELL  "UseGridShell"
 #define ATTR_USE_PARROT  "UseParrot"
 #define ATTR_USER  "User"
@@ -862,6 +864,7 @@
 #define ATTR_SEC_SUBSYSTEM  "Subsystem"
 #define ATTR_SEC_REMOTE_VERSION  "RemoteVersion"
 #define ATTR_SEC_SHORT_VERSION  "ShortVersion"
+#define ATTR_SEC_BINARY_CLASSADS  "BinaryClassAds"
 #define ATTR_SEC_SERVER_ENDPOINT  "ServerEndpoint"
 #define ATTR_SEC_SERVER_COMMAND_SOCK  "ServerCommandSock"
 #define ATTR_SEC_SERVER_PID  "ServerPid"
@@ -1061,6 +1064,17 @@ extern const char ATTR_SEC_AUTHENTICATED_USER [];
 #define ATTR_LAST_NEGOTIATION_CYCLE_NUM_JOBS_CONSIDERED  "LastNegotiationCycleNumJobsConsidered"
 #define ATTR_LAST_NEGOTIATION_CYCLE_MATCHES  "LastNegotiationCycleMatches"
 #define ATTR_LAST_NEGOTIATION_CYCLE_REJECTIONS  "LastNegotiationCycleRejections"
+#define ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_HITS  "LastNegotiationCycleMatchCacheHits"
+#define ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_MISSES  "LastNegotiationCycleMatchCacheMisses"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_BUCKETS  "LastNegotiationCycleSlotBuckets"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_BUCKET_EVALUATIONS_SAVED  "LastNegotiationCycleSlotBucketEvaluationsSaved"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOT_ADS_REUSED  "LastNegotiationCycleSlotAdsReused"
+#define ATTR_LAST_NEGOTIATION_CYCLE_REGEX_CACHE_HITS  "LastNegotiationCycleRegexCacheHits"
+#define ATTR_LAST_NEGOTIATION_CYCLE_REGEX_CACHE_MISSES  "LastNegotiationCycleRegexCacheMisses"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SCHEDD_ROUND_TRIPS  "LastNegotiationCycleScheddRoundTrips"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SCHEDD_WAIT_TIME  "LastNegotiationCycleScheddWaitTime"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOWEST_SCHEDD  "LastNegotiationCycleSlowestSchedd"
+#define ATTR_LAST_NEGOTIATION_CYCLE_SLOWEST_SCHEDD_WAIT_TIME  "LastNegotiationCycleSlowestScheddWaitTime"
 #define ATTR_LAST_NEGOTIATION_CYCLE_SUBMITTERS_FAILED  "LastNegotiationCycleSubmittersFailed"
 #define ATTR_LAST_NEGOTIATION_CYCLE_SUBMITTERS_OUT_OF_TIME  "LastNegotiationCycleSubmittersOutOfTime"
 #define ATTR_LAST_NEGOTIATION_CYCLE_SUBMITTERS_SHARE_LIMIT  "LastNegotiationCycleSubmittersShareLimit"
@@ -344,6 +344,22 @@ const int UPDATE_OWN_SUBMITTOR_AD = 80;
 // Request a collector to retrieve an identity token from a schedd.
 const int IMPERSONATION_TOKEN_REQUEST = 81;
 
+// Update only the attributes of a startd ad that have changed since
+// the update with sequence number UpdateDeltaBase.
+const int UPDATE_STARTD_AD_DELTA = 82;
+
+// Watch the ads that match a query.  The reply is the same as the reply
+// to a query, followed by one message for each matching ad that is later
+// inserted, changed or removed, until either side closes the connection.
+// Each message is one of the WatchAdsEvent values below followed by the
+// (projected) ad.
+const int WATCH_ADS = 83;
+enum WatchAdsEvent {
+	WATCH_ADS_EVENT_INSERT = 1,
+	WATCH_ADS_EVENT_UPDATE = 2,
+	WATCH_ADS_EVENT_REMOVE = 3,
+};
+
 /* these comments are used to control command_table_generator.pl
 NAMETABLE_DIRECTIVE:END_SECTION:collector
 */
@@ -44,6 +44,11 @@ const condor_mode_t NULL_FILE_PERMISSIONS = (condor_mode_t)0;
 
 #include "proc.h"
 
+namespace classad {
+	class ClassAdBinaryUnParser;
+	class ClassAdBinaryParser;
+}
+
 /** @name Special Types
     We need to define a special code() method for certain integer arguments.
     To take advantage of overloading, we need make these arguments have a
@@ -504,6 +509,22 @@ public:
 	/// Set the peer's version.
 	void set_peer_version(CondorVersionInfo const *version);
 
+	/// True if the peer said in the security handshake that it can read
+	/// ClassAds in the binary encoding (see putClassAd()).
+	bool get_peer_binary_classads() const { return m_peer_binary_classads; }
+
+	void set_peer_binary_classads(bool can_read) { m_peer_binary_classads = can_read; }
+
+	/// The writer and reader of ClassAds in the binary encoding (see
+	/// putClassAd()).  Their attribute name tables last until the end
+	/// of the current outgoing or incoming message.
+	classad::ClassAdBinaryUnParser *classad_binary_unparser();
+	classad::ClassAdBinaryParser *classad_binary_parser();
+
+	/// Forget the binary ClassAd name tables for the outgoing (encode) or
+	/// incoming (decode) direction, called at the end of each message.
+	void reset_classad_binary_names(bool outgoing, bool incoming);
+
 	/** Get this stream's type.
         @return the type of this stream
     */
@@ -587,6 +608,9 @@ protected:
 	int decrypt_buf_len;
 	char *m_peer_description_str;
 	CondorVersionInfo *m_peer_version;
+	bool m_peer_binary_classads;
+	classad::ClassAdBinaryUnParser *m_classad_unparser;
+	classad::ClassAdBinaryParser *m_classad_parser;
 
 	time_t m_deadline_time;
 	static int timeout_multiplier;
@@ -1664,9 +1664,14 @@ SecManStartCommand::sendAuthInfo_inner()
 		CondorVersionInfo ver_info(m_remote_version.c_str());
 		m_sock->set_peer_version(&ver_info);
 	}
+	bool peer_binary_classads = false;
+	m_auth_info.LookupBool(ATTR_SEC_BINARY_CLASSADS, peer_binary_classads);
+	m_sock->set_peer_binary_classads(peer_binary_classads);
 
 	// fill in our version
 	m_auth_info.Assign(ATTR_SEC_REMOTE_VERSION,CondorVersion());
+	// and tell the server that we can read binary ClassAds
+	m_auth_info.Assign(ATTR_SEC_BINARY_CLASSADS, true);
 
 	// fill in return address, if we are a daemon
 	char const* dcss = global_dc_sinful();
@@ -1932,6 +1937,13 @@ SecManStartCommand::receiveAuthInfo_inner()
 				CondorVersionInfo ver_info(m_remote_version.c_str());
 				m_sock->set_peer_version(&ver_info);
 			}
+			// likewise whether the server can read binary ClassAds, since
+			// the session is cached with it
+			m_auth_info.Delete(ATTR_SEC_BINARY_CLASSADS);
+			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_BINARY_CLASSADS );
+			bool peer_binary_classads = false;
+			m_auth_info.LookupBool(ATTR_SEC_BINARY_CLASSADS, peer_binary_classads);
+			m_sock->set_peer_binary_classads(peer_binary_classads);
 			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_ENACT );
 			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_AUTHENTICATION_METHODS_LIST );
 			m_sec_man.sec_copy_attribute( m_auth_info, auth_response, ATTR_SEC_AUTHENTICATION_METHODS );
@@ -515,6 +515,7 @@ ReliSock::end_of_message_internal()
 	int ret_val = FALSE;
 
     resetCrypto();
+	reset_classad_binary_names(_coding == stream_encode, _coding == stream_decode);
 	switch(_coding){
 		case stream_encode:
 			if ( ignore_next_encode_eom == TRUE ) {
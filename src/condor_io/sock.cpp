@@ -1931,6 +1931,11 @@ int Sock::close()
 	set_MD_mode(MD_OFF);
 	set_crypto_key(false, NULL);
 
+	// and whatever was left of a message in the binary ClassAd encoding,
+	// which the next peer must ask for again
+	reset_classad_binary_names(true, true);
+	set_peer_binary_classads(false);
+
 	// we also need to reset the FQU
 	setFullyQualifiedUser(NULL);
 	setTriedAuthentication(false);
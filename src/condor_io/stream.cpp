@@ -25,6 +25,8 @@
 #include "condor_debug.h"
 #include "MyString.h"
 #include "utilfns.h"
+#include "classad/binarySink.h"
+#include "classad/binarySource.h"
 
 // initialize static data members
 int Stream::timeout_multiplier = 0;
@@ -58,6 +60,9 @@ Stream :: Stream() :
 	decrypt_buf_len(0),
 	m_peer_description_str(NULL),
 	m_peer_version(NULL),
+	m_peer_binary_classads(false),
+	m_classad_unparser(NULL),
+	m_classad_parser(NULL),
 	m_deadline_time(0),
 	ignore_timeout_multiplier(false)
 {
@@ -91,6 +96,8 @@ Stream :: ~Stream()
 	if( m_peer_version ) {
 		delete m_peer_version;
 	}
+	delete m_classad_unparser;
+	delete m_classad_parser;
 }
 
 int 
@@ -1534,6 +1541,35 @@ Stream::set_peer_version(CondorVersionInfo const *version)
 	}
 }
 
+classad::ClassAdBinaryUnParser *
+Stream::classad_binary_unparser()
+{
+	if( !m_classad_unparser ) {
+		m_classad_unparser = new classad::ClassAdBinaryUnParser();
+	}
+	return m_classad_unparser;
+}
+
+classad::ClassAdBinaryParser *
+Stream::classad_binary_parser()
+{
+	if( !m_classad_parser ) {
+		m_classad_parser = new classad::ClassAdBinaryParser();
+	}
+	return m_classad_parser;
+}
+
+void
+Stream::reset_classad_binary_names(bool outgoing, bool incoming)
+{
+	if( outgoing && m_classad_unparser ) {
+		m_classad_unparser->Reset();
+	}
+	if( incoming && m_classad_parser ) {
+		m_classad_parser->Reset();
+	}
+}
+
 void
 Stream::set_deadline_timeout(int t)
 {
@@ -0,0 +1,212 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Tests for MatchResultCache, which lets jobs that look the same to a
+// slot share the result of matching it, across submitters and cycles.
+
+#include "condor_common.h"
+#include "condor_attributes.h"
+#include "condor_classad.h"
+#include "compat_classad_util.h"
+#include "matchmaker_match_cache.h"
+
+static unsigned failures = 0;
+
+static void
+check( bool ok, const char * what ) {
+	if( ! ok ) {
+		++failures;
+		fprintf( stderr, "FAILED: %s\n", what );
+	}
+}
+
+static void
+make_slot( ClassAd & slot, const char * name, int memory, long long seq ) {
+	slot.Assign( ATTR_NAME, name );
+	slot.Assign( ATTR_STARTD_IP_ADDR, "<127.0.0.1:9618>" );
+	slot.Assign( ATTR_DAEMON_START_TIME, 1000 );
+	slot.Assign( ATTR_UPDATE_SEQUENCE_NUMBER, seq );
+	slot.Assign( ATTR_MEMORY, memory );
+	slot.Assign( ATTR_ARCH, "X86_64" );
+	slot.AssignExpr( ATTR_REQUIREMENTS, "TARGET.ImageSize <= MY.Memory" );
+}
+
+static void
+make_job( ClassAd & job ) {
+	job.Assign( ATTR_IMAGE_SIZE, 100 );
+	job.Assign( ATTR_OWNER, "alice" );
+	job.AssignExpr( ATTR_REQUIREMENTS, "TARGET.Arch == \"X86_64\" && TARGET.Memory >= 512" );
+	job.AssignExpr( ATTR_RANK, "TARGET.Memory" );
+}
+
+	// a cache holding the result for the job against the slot, in a cycle
+	// that has just begun with only that slot
+static int
+cache_one( MatchResultCache & cache, ClassAdListDoesNotDeleteAds & slots,
+	ClassAd & slot, ClassAd & job ) {
+	slots.Insert( &slot );
+	cache.beginCycle( slots, ATTR_IMAGE_SIZE );
+	int sig = cache.jobSignature( job );
+	cache.store( &slot, sig, IsAMatch( &job, &slot ) );
+	return sig;
+}
+
+static void
+test_hit() {
+	ClassAd slot, job1, job2;
+	make_slot( slot, "slot1@example.org", 1024, 1 );
+	make_job( job1 );
+	make_job( job2 );
+		// an attribute the slot does not look at
+	job2.Assign( ATTR_OWNER, "bob" );
+
+	ClassAdListDoesNotDeleteAds slots;
+	slots.Insert( &slot );
+	MatchResultCache cache;
+	cache.beginCycle( slots, ATTR_IMAGE_SIZE );
+	int sig1 = cache.jobSignature( job1 );
+	check( sig1 >= 0, "stable job is cacheable" );
+	check( cache.lookup( &slot, sig1 ) == -1, "first lookup misses" );
+	cache.store( &slot, sig1, IsAMatch( &job1, &slot ) );
+	int sig2 = cache.jobSignature( job2 );
+	check( sig2 == sig1, "jobs that differ only in what the slot ignores share a signature" );
+	check( cache.lookup( &slot, sig2 ) == 1, "second job gets the stored result" );
+	check( cache.hits() == 1 && cache.misses() == 1, "hits and misses are counted" );
+}
+
+static void
+test_volatile_job() {
+	ClassAd slot;
+	make_slot( slot, "slot1@example.org", 1024, 1 );
+	ClassAdListDoesNotDeleteAds slots;
+	slots.Insert( &slot );
+	MatchResultCache cache;
+	cache.beginCycle( slots, ATTR_IMAGE_SIZE );
+
+		// the negotiator sets SubmitterUserPrio for each submitter
+	ClassAd prio_job;
+	make_job( prio_job );
+	prio_job.Assign( ATTR_SUBMITTER_USER_PRIO, 0.5 );
+	prio_job.AssignExpr( ATTR_REQUIREMENTS, "TARGET.Memory >= 512 && MY.SubmitterUserPrio < 10" );
+	check( cache.jobSignature( prio_job ) == -1, "job referring to a per-submitter attribute is not cached" );
+
+	ClassAd time_job;
+	make_job( time_job );
+	time_job.AssignExpr( ATTR_REQUIREMENTS, "TARGET.Memory >= 512 && time() > 0" );
+	check( cache.jobSignature( time_job ) == -1, "job calling time() is not cached" );
+
+		// also through an attribute the Requirements refer to
+	ClassAd random_job;
+	make_job( random_job );
+	random_job.AssignExpr( "Pick", "random(2)" );
+	random_job.AssignExpr( ATTR_REQUIREMENTS, "TARGET.Memory >= 512 && MY.Pick == 0" );
+	check( cache.jobSignature( random_job ) == -1, "job calling random() indirectly is not cached" );
+}
+
+static void
+test_volatile_slot() {
+	ClassAd slot, job;
+	make_slot( slot, "slot1@example.org", 1024, 1 );
+	slot.AssignExpr( ATTR_START, "time() % 2 == 0" );
+	make_job( job );
+
+	ClassAdListDoesNotDeleteAds slots;
+	MatchResultCache cache;
+	int sig = cache_one( cache, slots, slot, job );
+	check( sig >= 0, "job is cacheable" );
+	check( cache.peek( &slot, sig ) == -1, "slot calling time() is not cached" );
+}
+
+static void
+test_generation() {
+	ClassAd slot, job;
+	make_slot( slot, "slot1@example.org", 1024, 7 );
+	make_job( job );
+
+	ClassAdListDoesNotDeleteAds slots;
+	MatchResultCache cache;
+	cache_one( cache, slots, slot, job );
+	cache.endCycle();
+
+		// a new copy of the same update, as the negotiator fetches each cycle
+	ClassAd same( slot );
+	ClassAdListDoesNotDeleteAds same_slots;
+	same_slots.Insert( &same );
+	cache.beginCycle( same_slots, ATTR_IMAGE_SIZE );
+	check( cache.peek( &same, cache.jobSignature( job ) ) == 1, "result kept while the slot is not updated" );
+	cache.endCycle();
+
+	ClassAd updated( slot );
+	updated.Assign( ATTR_UPDATE_SEQUENCE_NUMBER, 8 );
+	updated.Assign( ATTR_MEMORY, 256 );
+	ClassAdListDoesNotDeleteAds updated_slots;
+	updated_slots.Insert( &updated );
+	cache.beginCycle( updated_slots, ATTR_IMAGE_SIZE );
+	check( cache.peek( &updated, cache.jobSignature( job ) ) == -2, "result forgotten when the slot is updated" );
+	cache.endCycle();
+
+		// a restarted startd begins counting again
+	ClassAd restarted( slot );
+	restarted.Assign( ATTR_DAEMON_START_TIME, 2000 );
+	ClassAdListDoesNotDeleteAds restarted_slots;
+	restarted_slots.Insert( &restarted );
+	cache.beginCycle( restarted_slots, ATTR_IMAGE_SIZE );
+	check( cache.peek( &restarted, cache.jobSignature( job ) ) == -2, "result forgotten when the startd restarts" );
+}
+
+static void
+test_invalidate() {
+	ClassAd slot, job;
+	make_slot( slot, "slot1@example.org", 1024, 7 );
+	make_job( job );
+
+	ClassAdListDoesNotDeleteAds slots;
+	MatchResultCache cache;
+	int sig = cache_one( cache, slots, slot, job );
+	cache.invalidate( &slot );
+	check( cache.lookup( &slot, sig ) == -1, "invalidated slot is matched again" );
+	cache.store( &slot, sig, true );
+	check( cache.peek( &slot, sig ) == -1, "invalidated slot stores nothing" );
+	check( cache.hits() == 0, "no hits after invalidate" );
+	cache.endCycle();
+
+	ClassAd copy( slot );
+	ClassAdListDoesNotDeleteAds next;
+	next.Insert( &copy );
+	cache.beginCycle( next, ATTR_IMAGE_SIZE );
+	check( cache.peek( &copy, cache.jobSignature( job ) ) == -2, "invalidated results are not kept for the next cycle" );
+}
+
+int
+main( int /* argc */, char ** /* argv */ ) {
+		// as the daemons do, unless STRICT_CLASSAD_EVALUATION is set, so
+		// that MY.attr refers to the job ad
+	classad::SetOldClassAdSemantics( true );
+
+	test_hit();
+	test_volatile_job();
+	test_volatile_slot();
+	test_generation();
+	test_invalidate();
+
+	if( failures == 0 ) {
+		fprintf( stdout, "No failures detected.\n" );
+	}
+	return failures;
+}
@@ -49,6 +49,8 @@
 #include <string>
 #include <sstream>
 #include <deque>
+#include <limits>
+#include <cmath>
 
 #if defined(WANT_CONTRIB) && defined(WITH_MANAGEMENT)
 #if defined(HAVE_DLOPEN)
@@ -114,6 +116,21 @@ public:
 	int matches;
 	int rejections;
 
+	int match_cache_hits;
+	int match_cache_misses;
+
+	int slot_buckets;
+	int slot_bucket_evaluations_saved;
+
+	int slot_ads_reused;
+
+	int regex_cache_hits;
+	int regex_cache_misses;
+
+		// time spent waiting on each schedd for resource requests,
+		// keyed by schedd address
+	std::map<std::string, ScheddLatency> schedd_latency;
+
     int pies;
     int pie_spins;
 
@@ -152,6 +169,14 @@ NegotiationCycleStats::NegotiationCycleStats():
     num_jobs_considered(0),
 	matches(0),
 	rejections(0),
+	match_cache_hits(0),
+	match_cache_misses(0),
+	slot_buckets(0),
+	slot_bucket_evaluations_saved(0),
+	slot_ads_reused(0),
+	regex_cache_hits(0),
+	regex_cache_misses(0),
+	schedd_latency(),
     pies(0),
     pie_spins(0),
     active_schedds(),
@@ -395,6 +420,13 @@ Matchmaker ()
 
 	want_globaljobprio = false;
 	want_matchlist_caching = false;
+	want_match_result_caching = false;
+	want_slot_bucketing = false;
+	want_incremental_cycles = false;
+	incremental_full_query_interval = 0;
+	m_lastFullSlotQuery = 0;
+	m_slotAdsWatermark = 0;
+	m_slotAdsReused = 0;
 	PublishCrossSlotPrios = false;
 	ConsiderPreemption = true;
 	ConsiderEarlyPreemption = false;
@@ -484,6 +516,7 @@ Matchmaker::
     if (SlotPoolsizeConstraint) delete SlotPoolsizeConstraint;
 	if (groupQuotasHash) delete groupQuotasHash;
 	if (stashedAds) delete stashedAds;
+	clearSlotAdCache();
     if (strSlotConstraint) free(strSlotConstraint), strSlotConstraint = NULL;
 
 	int i;
@@ -763,6 +796,15 @@ reinitialize ()
 
 	want_globaljobprio = param_boolean("USE_GLOBAL_JOB_PRIOS",false);
 	want_matchlist_caching = param_boolean("NEGOTIATOR_MATCHLIST_CACHING",true);
+	want_match_result_caching = param_boolean("NEGOTIATOR_MATCH_RESULT_CACHING",true);
+	want_slot_bucketing = param_boolean("NEGOTIATOR_SLOT_BUCKETING",true);
+	want_incremental_cycles = param_boolean("NEGOTIATOR_INCREMENTAL_CYCLES",false);
+	incremental_full_query_interval = param_integer("NEGOTIATOR_INCREMENTAL_FULL_QUERY_INTERVAL",3600,0);
+		// how we transform slot ads may have changed, so fetch them all again
+	clearSlotAdCache();
+	matchResultCache.setMaxSignatures(param_integer("NEGOTIATOR_MATCH_RESULT_CACHE_MAX_SIGNATURES",1000,1));
+		// the negotiator's policy may have changed, so start over
+	matchResultCache.clear();
 	PublishCrossSlotPrios = param_boolean("NEGOTIATOR_CROSS_SLOT_PRIOS", false);
 	ConsiderPreemption = param_boolean("NEGOTIATOR_CONSIDER_PREEMPTION",true);
 	ConsiderEarlyPreemption = param_boolean("NEGOTIATOR_CONSIDER_EARLY_PREEMPTION",false);
@@ -1194,9 +1236,12 @@ compute_significant_attrs(ClassAdListDoesNotDeleteAds & startdAds)
 		if ( !sample_startd_ad ) {
 			sample_startd_ad = new ClassAd(*startd_ad);
 		}
-		classad::ClassAd::iterator attr_it;
-		for ( attr_it = startd_ad->begin(); attr_it != startd_ad->end(); attr_it++ ) {
-			startd_ad->GetExternalReferences( attr_it->second, external_references, true );
+		// including the attributes of the ad it is chained to, if any
+		for ( const ClassAd *cur = startd_ad; cur; cur = cur->GetChainedParentAd() ) {
+			classad::ClassAd::const_iterator attr_it;
+			for ( attr_it = cur->begin(); attr_it != cur->end(); attr_it++ ) {
+				startd_ad->GetExternalReferences( attr_it->second, external_references, true );
+			}
 		}
 	}	// while startd_ad
 
@@ -1506,6 +1551,12 @@ negotiationTime ()
 	// Save this for future use.
 	int cTotalSlots = startdAds.MyLength();
     negotiation_cycle_stats[0]->total_slots = cTotalSlots;
+	negotiation_cycle_stats[0]->slot_ads_reused = m_slotAdsReused;
+
+		// the regexp() cache is shared by the whole process, so count
+		// what it did during this cycle
+	unsigned long regex_hits_start, regex_misses_start;
+	classad::ClassAdGetRegexCacheStats( regex_hits_start, regex_misses_start );
 
 	double minSlotWeight = 0;
 	double untrimmedSlotWeightTotal = sumSlotWeights(startdAds,&minSlotWeight,NULL);
@@ -1579,12 +1630,24 @@ negotiationTime ()
 		// matched job ad that is sent to the startd.  So in different
 		// matching contexts, the negotiator match exprs are in different
 		// ads, but they should always be in at least one.
-	insertNegotiatorMatchExprs( startdAds );
+		// With incremental cycles, they went in when the ads were fetched.
+	if ( ! want_incremental_cycles) {
+		insertNegotiatorMatchExprs( startdAds );
+	}
 
 	// insert RemoteUserPrio and related attributes so they are
 	// available during matchmaking
 	addRemoteUserPrios( startdAds );
 
+	// the slot ads are now as they will be matched, so see which
+	// cached match results from the previous cycle still hold
+	if (want_match_result_caching) {
+		matchResultCache.beginCycle(startdAds, job_attr_references);
+	}
+	if (want_slot_bucketing) {
+		slotBuckets.beginCycle(startdAds);
+	}
+
 	SetupMatchSecurity(submitterAds);
 
     if (hgq_groups.size() <= 1) {
@@ -1959,6 +2022,26 @@ negotiationTime ()
         dprintf(D_ALWAYS, "end sleep: %d seconds\n", insert_duration);
     }
 
+    if (want_match_result_caching) {
+        negotiation_cycle_stats[0]->match_cache_hits = matchResultCache.hits();
+        negotiation_cycle_stats[0]->match_cache_misses = matchResultCache.misses();
+        matchResultCache.endCycle();
+    }
+    unsigned long regex_hits_end, regex_misses_end;
+    classad::ClassAdGetRegexCacheStats(regex_hits_end, regex_misses_end);
+    negotiation_cycle_stats[0]->regex_cache_hits = (int)(regex_hits_end - regex_hits_start);
+    negotiation_cycle_stats[0]->regex_cache_misses = (int)(regex_misses_end - regex_misses_start);
+    if (want_slot_bucketing) {
+        negotiation_cycle_stats[0]->slot_buckets = slotBuckets.maxBuckets();
+        slotBuckets.endCycle();
+    }
+
+    for (std::map<std::string, ScheddLatency>::const_iterator it = negotiation_cycle_stats[0]->schedd_latency.begin();
+         it != negotiation_cycle_stats[0]->schedd_latency.end(); ++it) {
+        dprintf(D_FULLDEBUG, "Waited %.3f sec (longest %.3f sec) for %d resource request lists from %s\n",
+                it->second.wait_time, it->second.max_wait, it->second.fetches, it->first.c_str());
+    }
+
     // ----- Done with the negotiation cycle
     dprintf( D_ALWAYS, "---------- Finished Negotiation Cycle ----------\n" );
 
@@ -3540,6 +3623,13 @@ sumSlotWeights(ClassAdListDoesNotDeleteAds &startdAds, double* minSlotWeight, Ex
 	return sum;
 }
 
+void Matchmaker::
+clearSlotAdCache()
+{
+	m_slotAdCache.clear();
+	m_slotAdsWatermark = 0;
+}
+
 bool Matchmaker::
 obtainAdsFromCollector (
 						ClassAdList &allAds,
@@ -3559,6 +3649,18 @@ obtainAdsFromCollector (
 	CollectorList* collects = daemonCore->getCollectorList();
 
     cp_resources = false;
+	m_slotAdsReused = 0;
+
+		// For incremental cycles, we only ask for the slot ads that the
+		// collector heard about since the newest one we have, and use our
+		// copies of the others.  Every so often, we ask for all of them.
+	bool incremental = false;
+	time_t now = time(NULL);
+	if ( ! want_incremental_cycles) {
+		clearSlotAdCache();
+	} else if (m_slotAdsWatermark > 0 && now - m_lastFullSlotQuery < incremental_full_query_interval) {
+		incremental = true;
+	}
 
     // build a query for Scheduler, Submitter and (constrained) machine ads
     //
@@ -3573,10 +3675,14 @@ obtainAdsFromCollector (
 	}
     if (strSlotConstraint && strSlotConstraint[0]) {
         formatstr(constraint, "((MyType == \"Machine\") && (%s))", strSlotConstraint);
-        publicQuery.addORConstraint(constraint.c_str());
     } else {
-        publicQuery.addORConstraint("(MyType == \"Machine\")");
+        constraint = "(MyType == \"Machine\")";
     }
+	if (incremental) {
+		formatstr_cat(constraint, " && (%s >= %lld)", ATTR_LAST_HEARD_FROM, (long long)m_slotAdsWatermark);
+		constraint = "(" + constraint + ")";
+	}
+	publicQuery.addORConstraint(constraint.c_str());
 
 	// If preemption is disabled, we only need a handful of attrs from claimed ads.
 	// Ask for that projection.
@@ -3597,9 +3703,42 @@ obtainAdsFromCollector (
 		return false;
 	}
 
+		// Ask which slots there are, and when the collector last heard
+		// from each of them, before asking for the ones that changed.  A
+		// slot that changes in between is then returned by both queries.
+	ClassAdList slotKeyList;
+	if (incremental) {
+		CondorQuery keyQuery(STARTD_AD);
+		if (strSlotConstraint && strSlotConstraint[0]) {
+			keyQuery.addANDConstraint(strSlotConstraint);
+		}
+		std::vector<std::string> keyAttrs;
+		keyAttrs.push_back(ATTR_NAME);
+		keyAttrs.push_back(ATTR_STARTD_IP_ADDR);
+		keyAttrs.push_back(ATTR_LAST_HEARD_FROM);
+		keyQuery.setDesiredAttrs(keyAttrs);
+
+		dprintf(D_ALWAYS, "  Getting list of Machine ads ...\n");
+		result = collects->query (keyQuery, slotKeyList);
+		if( result!=Q_OK ) {
+			dprintf(D_ALWAYS, "Couldn't fetch ads: %s\n", getStrQueryResult(result));
+			return false;
+		}
+	}
+
     CondorError errstack;
-	dprintf(D_ALWAYS, "  Getting Scheduler, Submitter and Machine ads ...\n");
-	result = collects->query (publicQuery, allAds, &errstack);
+	dprintf(D_ALWAYS, "  Getting Scheduler, Submitter and %sMachine ads ...\n",
+		incremental ? "changed " : "");
+	{
+			// these ads are all freed at the end of the cycle, so
+			// parse them into one arena
+		classad::ClassAdArena::Batch batch;
+		result = collects->query (publicQuery, allAds, &errstack);
+		dprintf(D_FULLDEBUG, "  Parsed %lu ClassAd nodes into %lu blocks (%lu bytes)\n",
+			(unsigned long)batch.Arena().Allocations(),
+			(unsigned long)batch.Arena().Blocks(),
+			(unsigned long)batch.Arena().Bytes());
+	}
 	if( result!=Q_OK ) {
 		dprintf(D_ALWAYS, "Couldn't fetch ads: %s\n", 
            errstack.code() ? errstack.getFullText(false).c_str() : getStrQueryResult(result)
@@ -3607,6 +3746,13 @@ obtainAdsFromCollector (
 		return false;
 	}
 
+	std::set<std::string> freshSlots;	// slot ads the collector just sent
+	time_t watermark = 0;
+	if (want_incremental_cycles && ! incremental) {
+		clearSlotAdCache();
+		m_lastFullSlotQuery = now;
+	}
+
 	dprintf(D_ALWAYS, "  Sorting %d ads ...\n",allAds.MyLength());
 
 	allAds.Open();
@@ -3632,6 +3778,9 @@ obtainAdsFromCollector (
 				continue;
 			}
 
+			time_t lastHeardFrom = 0;
+			ad->LookupInteger(ATTR_LAST_HEARD_FROM, lastHeardFrom);
+
 			// Next, let's transform the ad. The first thing we might
 			// do is replace the Requirements attribute with whatever
 			// we find in NegotiatorRequirements
@@ -3762,6 +3911,20 @@ obtainAdsFromCollector (
 
 			OptimizeMachineAdForMatchmaking( ad );
 
+			if (want_incremental_cycles) {
+					// keep a copy ready for matchmaking for later cycles;
+					// the ones we use are changed by negotiation.
+				insertNegotiatorMatchExprs( ad );
+				std::string adID = MachineAdID(ad).c_str();
+				freshSlots.insert(adID);
+				if (lastHeardFrom > 0) {
+					SlotAdEntry &entry = m_slotAdCache[adID];
+					entry.ad.reset(new ClassAd(*ad));
+					entry.last_heard_from = lastHeardFrom;
+					watermark = MAX(watermark, lastHeardFrom);
+				}
+			}
+
 			startdAds.Insert(ad);
 		} else if( !strcmp(GetMyTypeName(*ad),SUBMITTER_ADTYPE) ) {
 
@@ -3835,6 +3998,65 @@ obtainAdsFromCollector (
 	}
 	allAds.Close();
 
+	if (incremental) {
+			// Use our copies of the slots that have not changed, and
+			// forget the ones that have gone away.
+		std::set<std::string> current;
+		int missing = 0;
+		slotKeyList.Open();
+		while( (ad=slotKeyList.Next()) ) {
+			std::string name;
+			if ( ! ad->LookupString(ATTR_NAME, name)) {
+				continue;
+			}
+			std::string adID = MachineAdID(ad).c_str();
+			current.insert(adID);
+			if (freshSlots.count(adID)) {
+				continue;
+			}
+			time_t lastHeardFrom = 0;
+			ad->LookupInteger(ATTR_LAST_HEARD_FROM, lastHeardFrom);
+			std::map<std::string, SlotAdEntry>::iterator it = m_slotAdCache.find(adID);
+			if (it == m_slotAdCache.end() || it->second.last_heard_from != lastHeardFrom) {
+					// we never saw this version of the ad
+				missing++;
+				continue;
+			}
+			watermark = MAX(watermark, lastHeardFrom);
+
+				// changes made while negotiating go into the chained
+				// ad, and the cached one stays as it was
+			ClassAd *copy = new ClassAd();
+			copy->ChainToSharedAd(it->second.ad);
+			if (!cp_resources && cp_supports_policy(*copy)) {
+				cp_resources = true;
+			}
+			allAds.Insert(copy);
+			startdAds.Insert(copy);
+			m_slotAdsReused++;
+		}
+		slotKeyList.Close();
+
+		std::map<std::string, SlotAdEntry>::iterator it = m_slotAdCache.begin();
+		while (it != m_slotAdCache.end()) {
+			if (current.count(it->first) || freshSlots.count(it->first)) {
+				++it;
+			} else {
+				m_slotAdCache.erase(it++);
+			}
+		}
+
+		if (missing) {
+			dprintf(D_ALWAYS, "  %d Machine ads were not in the incremental query, will fetch all of them next cycle\n", missing);
+			m_lastFullSlotQuery = 0;
+		}
+		dprintf(D_ALWAYS, "  Fetched %d changed Machine ads, reused %d\n",
+			(int)freshSlots.size(), m_slotAdsReused);
+	}
+	if (want_incremental_cycles) {
+		m_slotAdsWatermark = MAX(m_slotAdsWatermark, watermark);
+	}
+
 	// In the processing of allAds above, if want_globaljobprio is true,
 	// we may have created additional submitter ads and inserted them
 	// into submitterAds on the fly.
@@ -4526,6 +4748,8 @@ negotiate(char const* groupName, char const *submitterName, const ClassAd *submi
 	// Not for other uses, as it may change!
 	std::string schedd_id;
 	formatstr(schedd_id, "%s (%s)", submitterName, scheddAddr.c_str());
+
+	request_list->setLatencyStats(&negotiation_cycle_stats[0]->schedd_latency[scheddAddr]);
 	
 	int schedd_will_match = 1; // number of extra jobs schedd will put into a partitionable slot
 
@@ -4763,6 +4987,11 @@ negotiate(char const* groupName, char const *submitterName, const ClassAd *submi
 			result = matchmakingProtocol (request, offer, claimIds, sock, 
 					submitterName, scheddAddr.c_str());
 
+			// the offer has been changed to hand it to the schedd, so what
+			// we know about it no longer holds
+			matchResultCache.invalidate(offer);
+			slotBuckets.invalidate(offer);
+
 			// 2e(iii). if the matchmaking protocol failed, do not consider the
 			//			startd again for this negotiation cycle.
 			if (result == MM_BAD_MATCH)
@@ -4868,12 +5097,16 @@ updateNegCycleEndTime(time_t startTime, ClassAd *submitter) {
 
 float Matchmaker::
 EvalNegotiatorMatchRank(char const *expr_name,ExprTree *expr,
-                        ClassAd &request,ClassAd *resource)
+                        ClassAd &request,ClassAd *resource,
+                        const classad::Value *known)
 {
 	classad::Value result;
 	float rank = -(FLT_MAX);
 
-	if(expr && EvalExprTree(expr,resource,&request,result)) {
+	if (expr && known) {
+		result = *known;
+	}
+	if(expr && (known || EvalExprTree(expr,resource,&request,result))) {
 		double val;
 		if( result.IsNumber(val) ) {
 			rank = (float)val;
@@ -5019,6 +5252,19 @@ getSinfulStringProtocolBools( bool isIPv4, bool isIPv6,
 	}
 }
 
+	// evaluate one of the negotiator's match expressions for a slot,
+	// or use the value the match pool already got for it.
+static bool
+EvalMatchCheck(ExprTree *expr, ClassAd *candidate, ClassAd &request,
+               const classad::Value *known, classad::Value &result)
+{
+	if (known) {
+		result = *known;
+		return true;
+	}
+	return EvalExprTree(expr, candidate, &request, result);
+}
+
 
 /*
 Warning: scheddAddr may not be the actual address we'll use to contact the
@@ -5175,17 +5421,63 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 	double allocatedWeight = 0.0;
 		// Set up for parallel matchmaking, if enabled
 	std::vector<ClassAd *> par_candidates;
-	std::vector<ClassAd *> par_matches;
+	std::map<ClassAd *, size_t> par_index;
+
+		// Jobs that look the same to the slots share match results,
+		// even across submitters and negotiation cycles.
+	int match_sig = -1;
+	if (want_match_result_caching) {
+		match_sig = matchResultCache.jobSignature(request);
+	}
+
+		// Slots that look the same to this job share the result of
+		// matching (and the job's Rank of) the first of them.
+	int slot_division = -1;
+	std::vector<int> bucket_match;
+	std::vector<double> bucket_rank;
+	if (want_slot_bucketing) {
+		slot_division = slotBuckets.divide(request);
+		bucket_match.assign(slotBuckets.bucketCount(slot_division), -1);
+		bucket_rank.assign(slotBuckets.bucketCount(slot_division), std::numeric_limits<double>::quiet_NaN());
+	}
 
 	int num_threads =  param_integer("NEGOTIATOR_NUM_THREADS", 1);
 	if (num_threads > 1) {
 		startdAds.Open();
 		par_candidates.reserve(startdAds.Length());
 		while ((candidate = startdAds.Next())) {
+				// The consumption policy rewrites the request for each
+				// slot, so those slots are matched one at a time below.
+			if (cp_supports_policy(*candidate)) {
+				continue;
+			}
+			if (match_sig >= 0 && matchResultCache.lookup(candidate, match_sig) >= 0) {
+				continue;
+			}
+			par_index[candidate] = par_candidates.size();
 			par_candidates.push_back(candidate);
 		}
 		startdAds.Close();
-		ParallelIsAMatch(&request, par_candidates, par_matches, num_threads, false);
+
+			// Along with the match, have the pool work out the ranks and
+			// preemption conditions of the slots that match.
+		std::vector<MatchPool::Check> checks(POOL_NUM_CHECKS);
+		checks[POOL_JOB_RANK] = MatchPool::Check(request.Lookup(ATTR_RANK), true);
+		checks[POOL_PRE_JOB_RANK].expr = NegotiatorPreJobRank;
+		checks[POOL_POST_JOB_RANK].expr = NegotiatorPostJobRank;
+		if (ConsiderPreemption) {
+			checks[POOL_PREEMPTION_RANK].expr = PreemptionRank;
+			checks[POOL_RANK_COND_STD].expr = rankCondStd;
+			checks[POOL_RANK_COND_PRIO_PREEMPT].expr = rankCondPrioPreempt;
+			checks[POOL_PREEMPTION_REQ].expr = PreemptionReq;
+		}
+		matchPool.setThreads(num_threads);
+		matchPool.match(request, par_candidates, false, &checks);
+		if (match_sig >= 0) {
+			for (size_t ii = 0; ii < par_candidates.size(); ++ii) {
+				matchResultCache.store(par_candidates[ii], match_sig, matchPool.matched(ii));
+			}
+		}
 	}
 
 	// scan the offer ads
@@ -5238,13 +5530,40 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
         // When candidate supports a consumption policy, then resources
         // requested via consumption policy must also be available from
         // the resource
+		// The consumption policy rewrites the request for each slot, so
+		// those matches are not cached.
 		bool is_a_match = false;
-		if (num_threads > 1) {
-			is_a_match = cp_sufficient && 
-				(par_matches.end() != 
-					std::find(par_matches.begin(), par_matches.end(), candidate));
+		int cached_match = -1;
+		int bucket = -1;
+		const classad::Value *pool_values = NULL;
+		std::map<ClassAd *, size_t>::const_iterator par = par_index.find(candidate);
+		if (par != par_index.end()) {
+			// the match pool has already done this one
+			cached_match = matchPool.matched(par->second) ? 1 : 0;
+			pool_values = matchPool.values(par->second);
+		} else if ( ! has_cp && match_sig >= 0) {
+			// with threads, the lookup was done (and counted) before the parallel match
+			cached_match = (num_threads > 1) ? matchResultCache.peek(candidate, match_sig)
+			                                 : matchResultCache.lookup(candidate, match_sig);
+		}
+		if ( ! has_cp) {
+			bucket = slotBuckets.bucket(slot_division, candidate);
+			if (cached_match < 0 && bucket >= 0 && bucket_match[bucket] >= 0) {
+				cached_match = bucket_match[bucket];
+				negotiation_cycle_stats[0]->slot_bucket_evaluations_saved++;
+				matchResultCache.store(candidate, match_sig, cached_match);
+			}
+		}
+		if (cached_match >= 0) {
+			is_a_match = cp_sufficient && cached_match;
 		} else {
 			is_a_match = cp_sufficient && IsAMatch(&request, candidate);
+			if (match_sig >= 0 && ! has_cp) {
+				matchResultCache.store(candidate, match_sig, is_a_match);
+			}
+		}
+		if (bucket >= 0 && bucket_match[bucket] < 0) {
+			bucket_match[bucket] = is_a_match ? 1 : 0;
 		}
 
         if (has_cp) {
@@ -5320,7 +5639,8 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 						machine_name.c_str(), cluster_id, proc_id);
 				continue;
 			}
-			if ( !(EvalExprTree(rankCondStd, candidate, &request, result) && 
+			if ( !(EvalMatchCheck(rankCondStd, candidate, request,
+			                      pool_values ? &pool_values[POOL_RANK_COND_STD] : NULL, result) &&
 				   result.IsBooleanValue(val) && val) ) {
 					// offer does not strictly prefer this request.
 					// try the next offer since only_for_statdrank flag is set
@@ -5345,7 +5665,8 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 			 (candidatePreemptState == NO_PREEMPTION) // have we not already considered preemption?
 		   )
 		{
-			if( EvalExprTree(rankCondStd, candidate, &request, result) && 
+			if( EvalMatchCheck(rankCondStd, candidate, request,
+			                   pool_values ? &pool_values[POOL_RANK_COND_STD] : NULL, result) &&
 				result.IsBooleanValue(val) && val ) {
 					// offer strictly prefers this request to the one
 					// currently being serviced; preempt for rank
@@ -5359,7 +5680,8 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 					// (1) we need to make sure that PreemptionReq's hold (i.e.,
 					// if the PreemptionReq expression isn't true, dont preempt)
 				if (PreemptionReq && 
-					!(EvalExprTree(PreemptionReq,candidate,&request,result) &&
+					!(EvalMatchCheck(PreemptionReq, candidate, request,
+					                 pool_values ? &pool_values[POOL_PREEMPTION_REQ] : NULL, result) &&
 					  result.IsBooleanValue(val) && val) ) {
 					rejPreemptForPolicy++;
 					dprintf(D_MACHINE,
@@ -5370,7 +5692,8 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 					// (2) we need to make sure that the machine ranks the job
 					// at least as well as the one it is currently running 
 					// (i.e., rankCondPrioPreempt holds)
-				if(!(EvalExprTree(rankCondPrioPreempt,candidate,&request,result)&&
+				if(!(EvalMatchCheck(rankCondPrioPreempt, candidate, request,
+				                    pool_values ? &pool_values[POOL_RANK_COND_PRIO_PREEMPT] : NULL, result) &&
 					 result.IsBooleanValue(val) && val ) ) {
 						// machine doesn't like this job as much -- find another
 					rejPreemptForRank++;
@@ -5409,7 +5732,8 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 			}
 		}
 
-		calculateRanks(request, candidate, candidatePreemptState, candidateRankValue, candidatePreJobRankValue, candidatePostJobRankValue, candidatePreemptRankValue);
+		calculateRanks(request, candidate, candidatePreemptState, candidateRankValue, candidatePreJobRankValue, candidatePostJobRankValue, candidatePreemptRankValue,
+			(bucket >= 0) ? &bucket_rank[bucket] : NULL, pool_values);
 
 		if ( MatchList ) {
 			MatchList->add_candidate(
@@ -5625,7 +5949,9 @@ calculateRanks(ClassAd &request,
                double &candidateRankValue,
                double &candidatePreJobRankValue,
                double &candidatePostJobRankValue,
-               double &candidatePreemptRankValue
+               double &candidatePreemptRankValue,
+               double *knownRankValue,
+               const classad::Value *poolValues
               )
 {
 	if (m_staticRanks) {
@@ -5644,24 +5970,37 @@ calculateRanks(ClassAd &request,
 
 	candidatePreJobRankValue = EvalNegotiatorMatchRank(
 		"NEGOTIATOR_PRE_JOB_RANK",NegotiatorPreJobRank,
-		request, candidate);
+		request, candidate,
+		poolValues ? &poolValues[POOL_PRE_JOB_RANK] : NULL);
 
-	// calculate the request's rank of the candidate
+	// calculate the request's rank of the candidate, unless the caller
+	// already knows it from an identical candidate or the match pool
 	double tmp;
-	if(!EvalFloat(ATTR_RANK, &request, candidate, tmp)) {
-		tmp = 0.0;
+	if (knownRankValue && ! std::isnan(*knownRankValue)) {
+		tmp = *knownRankValue;
+	} else {
+		if (poolValues && poolValues[POOL_JOB_RANK].IsNumber(tmp)) {
+			// the match pool evaluated it
+		} else if(!EvalFloat(ATTR_RANK, &request, candidate, tmp)) {
+			tmp = 0.0;
+		}
+		if (knownRankValue) {
+			*knownRankValue = tmp;
+		}
 	}
 	candidateRankValue = tmp;
 
 	candidatePostJobRankValue = EvalNegotiatorMatchRank(
 		"NEGOTIATOR_POST_JOB_RANK",NegotiatorPostJobRank,
-		request, candidate);
+		request, candidate,
+		poolValues ? &poolValues[POOL_POST_JOB_RANK] : NULL);
 
 	candidatePreemptRankValue = -(FLT_MAX);
 	if(candidatePreemptState != NO_PREEMPTION) {
 		candidatePreemptRankValue = EvalNegotiatorMatchRank(
 			"PREEMPTION_RANK",PreemptionRank,
-			request, candidate);
+			request, candidate,
+			poolValues ? &poolValues[POOL_PREEMPTION_RANK] : NULL);
 	}
 
 	if (m_staticRanks) {
@@ -5737,6 +6076,10 @@ matchmakingProtocol (ClassAd &request, ClassAd *offer,
 	request.LookupInteger (ATTR_CLUSTER_ID, cluster);
 	request.LookupInteger (ATTR_PROC_ID, proc);
 
+	// a slot ad reused by an incremental cycle is chained to the cached
+	// one; what we change and send to the schedd must stand on its own
+	ChainCollapse(*offer);
+
 	bool offline = false;
 	offer->LookupBool(ATTR_OFFLINE,offline);
 	if( offline ) {
@@ -6782,6 +7125,14 @@ SetAttrN( ClassAd *ad, char const *attr, int n, double value )
 	ad->Assign(attrn,value);
 }
 
+static void
+SetAttrN( ClassAd *ad, char const *attr, int n, const std::string &value )
+{
+	std::string attrn;
+	formatstr(attrn,"%s%d",attr,n);
+	ad->Assign(attrn,value);
+}
+
 static void
 SetAttrN( ClassAd *ad, char const *attr, int n, std::set<std::string> &string_list )
 {
@@ -6825,6 +7176,17 @@ Matchmaker::publishNegotiationCycleStats( ClassAd *ad )
         ATTR_LAST_NEGOTIATION_CYCLE_NUM_JOBS_CONSIDERED,
         ATTR_LAST_NEGOTIATION_CYCLE_MATCHES,
         ATTR_LAST_NEGOTIATION_CYCLE_REJECTIONS,
+        ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_HITS,
+        ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_MISSES,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_BUCKETS,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_BUCKET_EVALUATIONS_SAVED,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOT_ADS_REUSED,
+        ATTR_LAST_NEGOTIATION_CYCLE_REGEX_CACHE_HITS,
+        ATTR_LAST_NEGOTIATION_CYCLE_REGEX_CACHE_MISSES,
+        ATTR_LAST_NEGOTIATION_CYCLE_SCHEDD_ROUND_TRIPS,
+        ATTR_LAST_NEGOTIATION_CYCLE_SCHEDD_WAIT_TIME,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOWEST_SCHEDD,
+        ATTR_LAST_NEGOTIATION_CYCLE_SLOWEST_SCHEDD_WAIT_TIME,
         ATTR_LAST_NEGOTIATION_CYCLE_PIES,
         ATTR_LAST_NEGOTIATION_CYCLE_PIE_SPINS,
         ATTR_LAST_NEGOTIATION_CYCLE_PREFETCH_DURATION,
@@ -6876,6 +7238,31 @@ Matchmaker::publishNegotiationCycleStats( ClassAd *ad )
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_NUM_JOBS_CONSIDERED, i, (int)s->num_jobs_considered);
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCHES, i, (int)s->matches);
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_REJECTIONS, i, (int)s->rejections);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_HITS, i, s->match_cache_hits);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCH_CACHE_MISSES, i, s->match_cache_misses);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_BUCKETS, i, s->slot_buckets);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_BUCKET_EVALUATIONS_SAVED, i, s->slot_bucket_evaluations_saved);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOT_ADS_REUSED, i, s->slot_ads_reused);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_REGEX_CACHE_HITS, i, s->regex_cache_hits);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_REGEX_CACHE_MISSES, i, s->regex_cache_misses);
+
+		int round_trips = 0;
+		double wait_time = 0.0;
+		std::map<std::string, ScheddLatency>::const_iterator slowest = s->schedd_latency.end();
+		for (std::map<std::string, ScheddLatency>::const_iterator it = s->schedd_latency.begin();
+			 it != s->schedd_latency.end(); ++it) {
+			round_trips += it->second.fetches;
+			wait_time += it->second.wait_time;
+			if (slowest == s->schedd_latency.end() || it->second.wait_time > slowest->second.wait_time) {
+				slowest = it;
+			}
+		}
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SCHEDD_ROUND_TRIPS, i, round_trips);
+		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SCHEDD_WAIT_TIME, i, wait_time);
+		if (slowest != s->schedd_latency.end()) {
+			SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOWEST_SCHEDD, i, slowest->first);
+			SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_SLOWEST_SCHEDD_WAIT_TIME, i, slowest->second.wait_time);
+		}
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCH_RATE, i, (s->duration > 0) ? (double)(s->matches)/double(s->duration) : double(0.0));
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_MATCH_RATE_SUSTAINED, i, (period > 0) ? (double)(s->matches)/double(period) : double(0.0));
 		SetAttrN( ad, ATTR_LAST_NEGOTIATION_CYCLE_ACTIVE_SUBMITTER_COUNT, i, (int)s->active_submitters.size());
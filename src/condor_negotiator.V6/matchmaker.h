@@ -28,6 +28,8 @@
 #include "dc_collector.h"
 #include "condor_ver_info.h"
 #include "matchmaker_negotiate.h"
+#include "matchmaker_match_cache.h"
+#include "match_pool.h"
 
 #include <vector>
 #include <string>
@@ -136,14 +138,28 @@ class Matchmaker : public Service
 
 		Accountant & getAccountant() { return accountant; }
 		static float EvalNegotiatorMatchRank(char const *expr_name,ExprTree *expr,
-		                              ClassAd &request,ClassAd *resource);
+		                              ClassAd &request,ClassAd *resource,
+		                              const classad::Value *known = NULL);
 
 		bool getGroupInfoFromUserId(const char* user, string& groupName, float& groupQuota, float& groupUsage);
 
 		void forwardAccountingData(std::set<std::string> &names);
 		void forwardGroupAccounting(CollectorList *cl, GroupEntry *ge);
 
-		void calculateRanks(ClassAd &request, ClassAd *offer, PreemptState candidatePreemptState, double &candidateRankValue, double &candidatePreJobRankValue, double &candidatePostJobRankValue, double &candidatePreemptRankValue);
+		void calculateRanks(ClassAd &request, ClassAd *offer, PreemptState candidatePreemptState, double &candidateRankValue, double &candidatePreJobRankValue, double &candidatePostJobRankValue, double &candidatePreemptRankValue, double *knownRankValue = NULL, const classad::Value *poolValues = NULL);
+
+			// the expressions the match pool evaluates for each slot
+			// that matches, in the order given to it.
+		enum PoolCheck {
+			POOL_JOB_RANK,
+			POOL_PRE_JOB_RANK,
+			POOL_POST_JOB_RANK,
+			POOL_PREEMPTION_RANK,
+			POOL_RANK_COND_STD,
+			POOL_RANK_COND_PRIO_PREEMPT,
+			POOL_PREEMPTION_REQ,
+			POOL_NUM_CHECKS
+		};
 
 		void setDryRun(bool d) {m_dryrun = d;}
 		bool getDryRun() const {return m_dryrun;}
@@ -163,6 +179,7 @@ class Matchmaker : public Service
 		
 		// auxillary functions
 		bool obtainAdsFromCollector (ClassAdList &allAds, ClassAdListDoesNotDeleteAds &startdAds, ClassAdListDoesNotDeleteAds &submitterAds, std::set<std::string> &submitterNames, ClaimIdHash &claimIds );	
+		void clearSlotAdCache();
 		char * compute_significant_attrs(ClassAdListDoesNotDeleteAds & startdAds);
 		bool consolidate_globaljobprio_submitter_ads(ClassAdListDoesNotDeleteAds & submitterAds);
 
@@ -373,6 +390,27 @@ class Matchmaker : public Service
 		ExprTree *NegotiatorPostJobRank; // rank applied after job rank
 		bool want_globaljobprio;	// cached value of config knob USE_GLOBAL_JOB_PRIOS
 		bool want_matchlist_caching;	// should we cache matches per autocluster?
+		bool want_match_result_caching;	// should we cache match results across submitters and cycles?
+		MatchResultCache matchResultCache;
+		bool want_slot_bucketing;	// should we evaluate one slot of each bucket of identical slots?
+		SlotBuckets slotBuckets;
+		MatchPool matchPool;		// threads for matchmaking when NEGOTIATOR_NUM_THREADS > 1
+		bool want_incremental_cycles;	// keep slot ads across cycles, fetching only the ones that changed?
+		int incremental_full_query_interval;	// but fetch all of them this often
+
+			// Our copy of each slot ad as it was when we last fetched it and
+			// made it ready for matchmaking, for incremental cycles.  A cycle
+			// that reuses it chains an ad to it rather than copying it, so it
+			// is shared with those ads and must not be changed.
+		struct SlotAdEntry {
+			SlotAdEntry() : last_heard_from(0) {}
+			classad_shared_ptr<ClassAd> ad;
+			time_t last_heard_from;	// by the collector, by its clock
+		};
+		std::map<std::string, SlotAdEntry> m_slotAdCache;	// keyed by MachineAdID
+		time_t m_slotAdsWatermark;	// LastHeardFrom of the newest slot ad we have
+		time_t m_lastFullSlotQuery;
+		int m_slotAdsReused;	// in the last call to obtainAdsFromCollector
 		bool PublishCrossSlotPrios; // value of knob NEGOTIATOR_CROSS_SLOT_PRIOS, default of false
 		bool ConsiderPreemption; // if false, negotiation is faster (default=true)
 		bool ConsiderEarlyPreemption; // if false, do not preempt slots that still have retirement time
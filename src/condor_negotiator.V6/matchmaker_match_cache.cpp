@@ -0,0 +1,521 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_attributes.h"
+#include "condor_classad.h"
+#include "matchmaker_match_cache.h"
+
+	// Attributes that the negotiator sets for each submitter or each
+	// cycle, so they can differ while the ads do not.  See
+	// Matchmaker::addRemoteUserPrios() and the request ad set up in
+	// Matchmaker::negotiate().  Expressions that refer to these, or
+	// that call these functions, cannot be cached.
+static const char * const volatile_attrs[] = {
+	ATTR_CURRENT_TIME,
+	ATTR_REMOTE_USER_PRIO,
+	ATTR_REMOTE_USER_RESOURCES_IN_USE,
+	ATTR_REMOTE_GROUP_RESOURCES_IN_USE,
+	ATTR_REMOTE_GROUP_QUOTA,
+	ATTR_SUBMITTOR_PRIO,
+	ATTR_SUBMITTER_USER_PRIO,
+	ATTR_SUBMITTER_USER_RESOURCES_IN_USE,
+	ATTR_SUBMITTER_GROUP_RESOURCES_IN_USE,
+	ATTR_SUBMITTER_GROUP_QUOTA,
+};
+
+static const char * const volatile_functions[] = {
+	"time",
+	"random",
+	"eval",
+	"ResourcesInUseByUser",			// RESOURCES_IN_USE_BY_USER_FN_NAME
+	"ResourcesInUseByUsersGroup",	// RESOURCES_IN_USE_BY_USERS_GROUP_FN_NAME
+};
+
+static bool
+is_volatile_attr(const std::string & attr)
+{
+		// with NEGOTIATOR_CROSS_SLOT_PRIOS, slotN_RemoteUserPrio and friends
+	size_t ix = attr.rfind('_');
+	const char * name = (ix == std::string::npos) ? attr.c_str() : attr.c_str() + ix + 1;
+	for (size_t i = 0; i < sizeof(volatile_attrs)/sizeof(volatile_attrs[0]); ++i) {
+		if (strcasecmp(name, volatile_attrs[i]) == 0 || strcasecmp(attr.c_str(), volatile_attrs[i]) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+	// returns true if the expression refers to a volatile attribute or
+	// calls a volatile function anywhere within it.  if check_attrs is
+	// false, only the functions are checked.
+static bool
+expr_is_volatile(const classad::ExprTree * tree, bool check_attrs = true)
+{
+	if ( ! tree) return false;
+	switch (tree->GetKind()) {
+		case classad::ExprTree::LITERAL_NODE:
+			return false;
+
+		case classad::ExprTree::ATTRREF_NODE: {
+			classad::ExprTree *expr = NULL;
+			std::string ref;
+			bool absolute = false;
+			((const classad::AttributeReference*)tree)->GetComponents(expr, ref, absolute);
+			return (check_attrs && is_volatile_attr(ref)) || expr_is_volatile(expr, check_attrs);
+		}
+
+		case classad::ExprTree::OP_NODE: {
+			classad::Operation::OpKind op;
+			classad::ExprTree *t1 = NULL, *t2 = NULL, *t3 = NULL;
+			((const classad::Operation*)tree)->GetComponents(op, t1, t2, t3);
+			return expr_is_volatile(t1, check_attrs) || expr_is_volatile(t2, check_attrs) || expr_is_volatile(t3, check_attrs);
+		}
+
+		case classad::ExprTree::FN_CALL_NODE: {
+			std::string fnName;
+			std::vector<classad::ExprTree*> args;
+			((const classad::FunctionCall*)tree)->GetComponents(fnName, args);
+			for (size_t i = 0; i < sizeof(volatile_functions)/sizeof(volatile_functions[0]); ++i) {
+				if (strcasecmp(fnName.c_str(), volatile_functions[i]) == 0) {
+					return true;
+				}
+			}
+			for (std::vector<classad::ExprTree*>::iterator it = args.begin(); it != args.end(); ++it) {
+				if (expr_is_volatile(*it, check_attrs)) return true;
+			}
+			return false;
+		}
+
+		case classad::ExprTree::CLASSAD_NODE: {
+			std::vector< std::pair<std::string, classad::ExprTree*> > attrs;
+			((const classad::ClassAd*)tree)->GetComponents(attrs);
+			for (std::vector< std::pair<std::string, classad::ExprTree*> >::iterator it = attrs.begin(); it != attrs.end(); ++it) {
+				if (expr_is_volatile(it->second, check_attrs)) return true;
+			}
+			return false;
+		}
+
+		case classad::ExprTree::EXPR_LIST_NODE: {
+			std::vector<classad::ExprTree*> exprs;
+			((const classad::ExprList*)tree)->GetComponents(exprs);
+			for (std::vector<classad::ExprTree*>::iterator it = exprs.begin(); it != exprs.end(); ++it) {
+				if (expr_is_volatile(*it, check_attrs)) return true;
+			}
+			return false;
+		}
+
+		case classad::ExprTree::EXPR_ENVELOPE:
+			return expr_is_volatile(SkipExprEnvelope(const_cast<classad::ExprTree*>(tree)), check_attrs);
+	}
+	return true;
+}
+
+MatchResultCache::MatchResultCache()
+	: m_max_signatures(1000)
+	, m_hits(0)
+	, m_misses(0)
+{
+}
+
+MatchResultCache::~MatchResultCache()
+{
+}
+
+void
+MatchResultCache::clear()
+{
+	m_slots.clear();
+	m_cycle_slots.clear();
+	m_signatures.clear();
+	m_job_attrs.clear();
+	m_job_attrs_str.clear();
+}
+
+void
+MatchResultCache::beginCycle(ClassAdListDoesNotDeleteAds &startdAds, const char *job_attrs)
+{
+	m_cycle_slots.clear();
+	m_hits = m_misses = 0;
+
+		// signatures are built from the job attributes the slots refer
+		// to, so if those change, the signatures no longer mean the same thing.
+	if ( ! job_attrs) job_attrs = "";
+	if (m_job_attrs_str != job_attrs || (int)m_signatures.size() > m_max_signatures) {
+		dprintf(D_FULLDEBUG, "Clearing match result cache (%d job signatures)\n", (int)m_signatures.size());
+		clear();
+		m_job_attrs_str = job_attrs;
+		StringTokenIterator attrs(job_attrs);
+		for (const char * attr = attrs.first(); attr; attr = attrs.next()) {
+			m_job_attrs.push_back(attr);
+		}
+	}
+
+	std::map<std::string, SlotEntry> slots;
+	int reused = 0;
+	std::string name, addr, id, generation;
+
+	ClassAd *ad;
+	startdAds.Open();
+	while ((ad = startdAds.Next())) {
+		if ( ! ad->LookupString(ATTR_NAME, name)) {
+			continue;
+		}
+		if ( ! ad->LookupString(ATTR_STARTD_IP_ADDR, addr)) {
+			addr = "<No Address>";
+		}
+		formatstr(id, "%s %s", addr.c_str(), name.c_str());
+
+			// ads without a sequence number (e.g. hand made, or stashed
+			// copies) can only share results within this cycle.
+		long long start_time = 0, seq = 0;
+		generation.clear();
+		if (ad->LookupInteger(ATTR_DAEMON_START_TIME, start_time) &&
+			ad->LookupInteger(ATTR_UPDATE_SEQUENCE_NUMBER, seq)) {
+			formatstr(generation, "%lld.%lld", start_time, seq);
+		}
+
+		if (slots.find(id) != slots.end()) {
+				// two ads by the same name, we cannot tell their results apart
+			SlotEntry &dup = slots[id];
+			dup.cacheable = false;
+			dup.generation.clear();
+			m_cycle_slots[ad] = &dup;
+			continue;
+		}
+		SlotEntry &entry = slots[id];
+		std::map<std::string, SlotEntry>::iterator it = m_slots.find(id);
+		if (it != m_slots.end() && ! generation.empty() && it->second.generation == generation) {
+			entry.generation.swap(it->second.generation);
+			entry.cacheable = it->second.cacheable;
+			entry.known.swap(it->second.known);
+			entry.matched.swap(it->second.matched);
+			++reused;
+		} else {
+			entry.generation = generation;
+				// the job's Requirements can refer to any attribute of the
+				// slot, so all of them must be stable.  skip the ones the
+				// negotiator put there, references to them are checked instead.
+				// that includes the attributes of the ad it is chained to.
+			entry.cacheable = true;
+			for (const ClassAd *cur = ad; cur && entry.cacheable; cur = cur->GetChainedParentAd()) {
+				for (classad::ClassAd::const_iterator attr = cur->begin(); attr != cur->end(); ++attr) {
+					if ( ! is_volatile_attr(attr->first) && expr_is_volatile(attr->second)) {
+						entry.cacheable = false;
+						break;
+					}
+				}
+			}
+		}
+		m_cycle_slots[ad] = &entry;
+	}
+	startdAds.Close();
+
+		// slots that are not in this cycle are forgotten
+	m_slots.swap(slots);
+
+	dprintf(D_FULLDEBUG, "Match result cache: kept results for %d of %d slots, %d job signatures\n",
+		reused, (int)m_cycle_slots.size(), (int)m_signatures.size());
+}
+
+void
+MatchResultCache::endCycle()
+{
+	m_cycle_slots.clear();
+}
+
+int
+MatchResultCache::jobSignature(ClassAd &request)
+{
+		// everything in the job ad that evaluating the job's Requirements
+		// and the slot's Requirements can look at: the job's Requirements,
+		// the job attributes the slots refer to, and whatever those refer
+		// to within the job ad.
+	classad::References attrs;
+	attrs.insert(ATTR_REQUIREMENTS);
+	for (std::vector<std::string>::const_iterator it = m_job_attrs.begin(); it != m_job_attrs.end(); ++it) {
+		attrs.insert(*it);
+	}
+	classad::References internal;
+	for (classad::References::const_iterator it = attrs.begin(); it != attrs.end(); ++it) {
+		classad::ExprTree *expr = request.Lookup(*it);
+		if (expr) {
+			request.GetInternalReferences(expr, internal, false);
+		}
+	}
+	attrs.insert(internal.begin(), internal.end());
+
+	std::string sig;
+	for (classad::References::const_iterator it = attrs.begin(); it != attrs.end(); ++it) {
+		classad::ExprTree *expr = request.Lookup(*it);
+		if ( ! expr) {
+			continue;
+		}
+		if (is_volatile_attr(*it) || expr_is_volatile(expr)) {
+			return -1;
+		}
+		sig += *it;
+		sig += '=';
+		ExprTreeToString(expr, sig);
+		sig += '\n';
+	}
+
+	std::map<std::string, int>::iterator found = m_signatures.find(sig);
+	if (found != m_signatures.end()) {
+		return found->second;
+	}
+	int id = (int)m_signatures.size();
+	m_signatures[sig] = id;
+	return id;
+}
+
+MatchResultCache::SlotEntry *
+MatchResultCache::findSlot(ClassAd *slot)
+{
+	std::map<ClassAd*, SlotEntry*>::iterator it = m_cycle_slots.find(slot);
+	if (it == m_cycle_slots.end() || ! it->second->cacheable) {
+		return NULL;
+	}
+	return it->second;
+}
+
+int
+MatchResultCache::peek(ClassAd *slot, int sig)
+{
+	SlotEntry *entry = findSlot(slot);
+	if ( ! entry || sig < 0) {
+		return -1;
+	}
+	if (sig < (int)entry->known.size() && entry->known[sig]) {
+		return entry->matched[sig] ? 1 : 0;
+	}
+	return -2;
+}
+
+int
+MatchResultCache::lookup(ClassAd *slot, int sig)
+{
+	int result = peek(slot, sig);
+	if (result >= 0) {
+		++m_hits;
+	} else if (result == -2) {
+		++m_misses;
+		result = -1;
+	}
+	return result;
+}
+
+void
+MatchResultCache::store(ClassAd *slot, int sig, bool matched)
+{
+	SlotEntry *entry = findSlot(slot);
+	if ( ! entry || sig < 0) {
+		return;
+	}
+	if (sig >= (int)entry->known.size()) {
+		entry->known.resize(sig + 1, false);
+		entry->matched.resize(sig + 1, false);
+	}
+	entry->known[sig] = true;
+	entry->matched[sig] = matched;
+}
+
+void
+MatchResultCache::invalidate(ClassAd *slot)
+{
+	std::map<ClassAd*, SlotEntry*>::iterator it = m_cycle_slots.find(slot);
+	if (it == m_cycle_slots.end()) {
+		return;
+	}
+	SlotEntry *entry = it->second;
+	entry->cacheable = false;
+	entry->generation.clear();
+	entry->known.clear();
+	entry->matched.clear();
+}
+
+
+	// append name=expression to the key for each of the attributes and the
+	// attributes of the ad that they refer to.  returns false if one of them
+	// calls a function that may give a different answer each time.
+static bool
+append_attrs_key(ClassAd &ad, classad::References attrs, std::string &key)
+{
+	classad::References internal;
+	for (classad::References::const_iterator it = attrs.begin(); it != attrs.end(); ++it) {
+		classad::ExprTree *expr = ad.Lookup(*it);
+		if (expr && expr->GetKind() != classad::ExprTree::LITERAL_NODE) {
+			ad.GetInternalReferences(expr, internal, false);
+		}
+	}
+	attrs.insert(internal.begin(), internal.end());
+
+	for (classad::References::const_iterator it = attrs.begin(); it != attrs.end(); ++it) {
+		classad::ExprTree *expr = ad.Lookup(*it);
+		if ( ! expr) {
+			continue;
+		}
+		if (expr_is_volatile(expr, false)) {
+			return false;
+		}
+		key += *it;
+		key += '=';
+		ExprTreeToString(expr, key);
+		key += '\n';
+	}
+	return true;
+}
+
+SlotBuckets::SlotBuckets()
+	: m_max_buckets(0)
+{
+}
+
+SlotBuckets::~SlotBuckets()
+{
+}
+
+void
+SlotBuckets::beginCycle(ClassAdListDoesNotDeleteAds &startdAds)
+{
+	endCycle();
+
+	classad::References attrs;
+	attrs.insert(ATTR_REQUIREMENTS);
+
+	ClassAd *ad;
+	startdAds.Open();
+	while ((ad = startdAds.Next())) {
+		SlotInfo &info = m_slots[ad];
+		info.alone = ! append_attrs_key(*ad, attrs, info.key);
+		m_slot_order.push_back(ad);
+	}
+	startdAds.Close();
+}
+
+void
+SlotBuckets::endCycle()
+{
+	m_slot_order.clear();
+	m_slots.clear();
+	m_division_ids.clear();
+	m_divisions.clear();
+	m_max_buckets = 0;
+}
+
+int
+SlotBuckets::divide(ClassAd &request)
+{
+	if (m_slot_order.empty()) {
+		return -1;
+	}
+
+		// the slot attributes the job looks at
+	classad::References refs;
+	const char * job_attrs[] = { ATTR_REQUIREMENTS, ATTR_RANK };
+	for (size_t i = 0; i < sizeof(job_attrs)/sizeof(job_attrs[0]); ++i) {
+		classad::ExprTree *expr = request.Lookup(job_attrs[i]);
+		if ( ! expr) {
+			continue;
+		}
+		if (expr_is_volatile(expr, false)) {
+			return -1;
+		}
+		request.GetExternalReferences(expr, refs, true);
+	}
+	TrimReferenceNames(refs, true);
+
+	std::string refs_key;
+	for (classad::References::const_iterator it = refs.begin(); it != refs.end(); ++it) {
+		refs_key += *it;
+		refs_key += ',';
+	}
+	std::map<std::string, int>::iterator found = m_division_ids.find(refs_key);
+	if (found != m_division_ids.end()) {
+		return found->second;
+	}
+
+	int id = (int)m_divisions.size();
+	m_division_ids[refs_key] = id;
+	m_divisions.resize(id + 1);
+	Division &division = m_divisions[id];
+	division.count = 0;
+
+	std::map<std::string, int> buckets;
+	std::string key;
+	for (std::vector<ClassAd*>::const_iterator it = m_slot_order.begin(); it != m_slot_order.end(); ++it) {
+		SlotInfo &info = m_slots[*it];
+		if (info.alone) {
+			continue;
+		}
+		key = info.key;
+		key += '\0';
+		if ( ! append_attrs_key(**it, refs, key)) {
+			continue;
+		}
+		std::map<std::string, int>::iterator bucket = buckets.find(key);
+		if (bucket == buckets.end()) {
+			bucket = buckets.insert(std::make_pair(key, division.count++)).first;
+		}
+		division.bucket_of[*it] = bucket->second;
+	}
+
+	if (division.count > m_max_buckets) {
+		m_max_buckets = division.count;
+	}
+	dprintf(D_FULLDEBUG, "Divided %d slots into %d buckets for jobs referring to %s\n",
+		(int)m_slot_order.size(), division.count, refs_key.c_str());
+	return id;
+}
+
+int
+SlotBuckets::bucketCount(int division) const
+{
+	if (division < 0 || division >= (int)m_divisions.size()) {
+		return 0;
+	}
+	return m_divisions[division].count;
+}
+
+int
+SlotBuckets::bucket(int division, ClassAd *slot)
+{
+	if (division < 0 || division >= (int)m_divisions.size()) {
+		return -1;
+	}
+	std::map<ClassAd*, SlotInfo>::iterator info = m_slots.find(slot);
+	if (info == m_slots.end() || info->second.alone) {
+		return -1;
+	}
+	std::map<ClassAd*, int>::iterator it = m_divisions[division].bucket_of.find(slot);
+	if (it == m_divisions[division].bucket_of.end()) {
+		return -1;
+	}
+	return it->second;
+}
+
+void
+SlotBuckets::invalidate(ClassAd *slot)
+{
+	std::map<ClassAd*, SlotInfo>::iterator info = m_slots.find(slot);
+	if (info != m_slots.end()) {
+		info->second.alone = true;
+	}
+}
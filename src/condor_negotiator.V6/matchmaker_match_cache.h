@@ -0,0 +1,157 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _MATCHMAKER_MATCH_CACHE_H
+#define _MATCHMAKER_MATCH_CACHE_H
+
+#include <map>
+#include <vector>
+#include <string>
+
+	// Remembers whether a job matches a slot (the job's Requirements
+	// and the slot's Requirements), across submitters and across
+	// negotiation cycles.  Jobs are known by a signature made from the
+	// expressions in the job ad that matchmaking can look at, so jobs
+	// of different submitters and schedds that look the same to the
+	// slots share results.  Slots are known by name and address, and
+	// their results are kept for as long as the collector hands us a
+	// slot ad with the same DaemonStartTime and UpdateSequenceNumber.
+	//
+	// Jobs and slots whose matching depends on something that changes
+	// without the ad changing (the time, user priorities, ...) are
+	// never cached.
+class MatchResultCache {
+
+ public:
+	MatchResultCache();
+	~MatchResultCache();
+
+		// call at the start of each cycle with the slot ads that will be
+		// considered, once the negotiator is done changing them, and the
+		// job attributes the slot ads refer to.  Forgets the results of
+		// slots that have changed or gone away.
+	void beginCycle(ClassAdListDoesNotDeleteAds &startdAds, const char *job_attrs);
+
+		// call at the end of each cycle, before the slot ads are deleted.
+	void endCycle();
+
+		// forget everything
+	void clear();
+
+		// the most job signatures to remember before starting over
+	void setMaxSignatures(int max_sigs) { m_max_signatures = max_sigs; }
+
+		// returns the id of the job's signature, or -1 if matches
+		// of this job cannot be cached.
+	int jobSignature(ClassAd &request);
+
+		// returns 1 if the job matched the slot, 0 if not, or -1 if
+		// there is no cached result
+	int lookup(ClassAd *slot, int sig);
+		// same as lookup(), but not counted as a hit or miss, and
+		// returns -2 rather than -1 if a result could be cached
+	int peek(ClassAd *slot, int sig);
+	void store(ClassAd *slot, int sig, bool matched);
+
+		// the negotiator changed the slot ad; do not use or store
+		// results for this slot for the rest of the cycle.
+	void invalidate(ClassAd *slot);
+
+		// lookups that found or did not find a result since beginCycle()
+	int hits() const { return m_hits; }
+	int misses() const { return m_misses; }
+
+ private:
+
+	struct SlotEntry {
+		SlotEntry() : cacheable(false) {}
+		std::string generation;
+		bool cacheable;
+		std::vector<bool> known;	// indexed by signature id
+		std::vector<bool> matched;
+	};
+
+	SlotEntry * findSlot(ClassAd *slot);
+
+	std::map<std::string, SlotEntry> m_slots;	// keyed by name and address
+	std::map<ClassAd*, SlotEntry*> m_cycle_slots;	// the slot ads of this cycle
+	std::map<std::string, int> m_signatures;
+	std::vector<std::string> m_job_attrs;
+	std::string m_job_attrs_str;
+	int m_max_signatures;
+	int m_hits;
+	int m_misses;
+};
+
+	// Divides the slots into buckets of slots that look the same to a
+	// job: the same values for the attributes that the job's Requirements
+	// and Rank refer to, and the same Requirements.  Evaluating a job
+	// against one slot of a bucket then gives the result for all of them.
+	// Each distinct set of references made by the jobs gets its own
+	// division of the slots, made the first time it is needed in a cycle.
+class SlotBuckets {
+
+ public:
+	SlotBuckets();
+	~SlotBuckets();
+
+		// call at the start of each cycle with the slot ads that will be
+		// considered, once the negotiator is done changing them.
+	void beginCycle(ClassAdListDoesNotDeleteAds &startdAds);
+
+		// call at the end of each cycle, before the slot ads are deleted.
+	void endCycle();
+
+		// returns the id of the division of the slots to use for this
+		// job, or -1 if the job cannot share results between slots.
+	int divide(ClassAd &request);
+
+		// the number of buckets in a division
+	int bucketCount(int division) const;
+
+		// returns the bucket of the slot, or -1 if the slot is on its own.
+	int bucket(int division, ClassAd *slot);
+
+		// the negotiator changed the slot ad, it is on its own from now on.
+	void invalidate(ClassAd *slot);
+
+		// the most buckets any division had this cycle
+	int maxBuckets() const { return m_max_buckets; }
+
+ private:
+
+	struct SlotInfo {
+		SlotInfo() : alone(false) {}
+		std::string key;	// the slot's Requirements and what they refer to
+		bool alone;
+	};
+
+	struct Division {
+		std::map<ClassAd*, int> bucket_of;
+		int count;
+	};
+
+	std::vector<ClassAd*> m_slot_order;
+	std::map<ClassAd*, SlotInfo> m_slots;
+	std::map<std::string, int> m_division_ids;	// keyed by the job's references
+	std::vector<Division> m_divisions;
+	int m_max_buckets;
+};
+
+#endif
@@ -28,7 +28,8 @@
 ResourceRequestList::ResourceRequestList(int protocol_version)
 	: m_send_end_negotiate(false),
 	m_send_end_negotiate_now(false),
-	m_requests_to_fetch(0)
+	m_requests_to_fetch(0),
+	m_latency(NULL)
 {
 	m_protocol_version = protocol_version;
 	m_clear_rejected_autoclusters = false;
@@ -284,6 +285,8 @@ ResourceRequestList::fetchRequestsFromSchedd(ReliSock* const sock, bool blocking
 		m_requests_to_fetch = m_num_to_fetch;
 	}
 
+	double wait_start = blocking ? _condor_debug_get_time_double() : 0.0;
+	TryStates result = RRL_DONE;
 	while (m_requests_to_fetch > 0) {
 		// 2b.  the schedd may either reply with JOB_INFO or NO_MORE_JOBS
 		dprintf (D_FULLDEBUG, "    Getting reply from schedd ...\n");
@@ -298,7 +301,8 @@ ResourceRequestList::fetchRequestsFromSchedd(ReliSock* const sock, bool blocking
 		if (read_would_block)
 		{
 			dprintf(D_NETWORK, "Resource request would block.\n");
-			return RRL_CONTINUE;
+			result = RRL_CONTINUE;
+			break;
 		}
 		m_requests_to_fetch--;
 		if (!retval)
@@ -307,7 +311,8 @@ ResourceRequestList::fetchRequestsFromSchedd(ReliSock* const sock, bool blocking
 			sock->end_of_message ();
 			errcode = __LINE__;
 			m_requests_to_fetch = 0;
-			return RRL_ERROR;
+			result = RRL_ERROR;
+			break;
 		}
 
 		// 2c.  if the schedd replied with NO_MORE_JOBS, cleanup and quit
@@ -317,7 +322,8 @@ ResourceRequestList::fetchRequestsFromSchedd(ReliSock* const sock, bool blocking
 			sock->end_of_message ();
 			// Note: do NOT set errcode here, as this is not an error condition
 			m_requests_to_fetch = 0;
-			return RRL_NO_MORE_JOBS;
+			result = RRL_NO_MORE_JOBS;
+			break;
 		}
 		else
 		if (reply != JOB_INFO)
@@ -327,7 +333,8 @@ ResourceRequestList::fetchRequestsFromSchedd(ReliSock* const sock, bool blocking
 			sock->end_of_message ();
 			errcode = __LINE__;
 			m_requests_to_fetch = 0;
-			return RRL_ERROR;
+			result = RRL_ERROR;
+			break;
 		}
 
 		// 2d.  get the request
@@ -339,11 +346,20 @@ ResourceRequestList::fetchRequestsFromSchedd(ReliSock* const sock, bool blocking
 			sock->end_of_message();
 			errcode = __LINE__;
 			m_requests_to_fetch = 0;
-			return RRL_ERROR;
+			result = RRL_ERROR;
+			break;
 		}
 		m_ads.push_back(request_ad);
 	}
 
-	return RRL_DONE;
+	if ( blocking && m_latency ) {
+		double waited = _condor_debug_get_time_double() - wait_start;
+		m_latency->fetches++;
+		m_latency->wait_time += waited;
+		if ( waited > m_latency->max_wait ) {
+			m_latency->max_wait = waited;
+		}
+	}
+	return result;
 }
 
@@ -22,6 +22,15 @@
 
 #include <deque>
 
+	// Time the negotiator spent waiting on one schedd for resource
+	// requests during a cycle.
+struct ScheddLatency {
+	ScheddLatency() : fetches(0), wait_time(0.0), max_wait(0.0) {}
+	int fetches;		// round trips we had to wait for
+	double wait_time;	// total seconds spent waiting
+	double max_wait;	// longest single wait, in seconds
+};
+
 class ResourceRequestList {
 
  public:
@@ -57,6 +66,9 @@ class ResourceRequestList {
 	};
 	TryStates tryRetrieve(ReliSock* const sock);
 
+		// Add the time spent waiting for the schedd to these stats.
+	void setLatencyStats(ScheddLatency *stats) { m_latency = stats; }
+
  private:
 
 	TryStates fetchRequestsFromSchedd(ReliSock* const sock, bool blocking);
@@ -68,6 +80,7 @@ class ResourceRequestList {
 	bool m_clear_rejected_autoclusters;
 	int m_requests_to_fetch;
 	int m_num_to_fetch;
+	ScheddLatency *m_latency;
 	int errcode;
 	int current_autocluster;
 	ClassAd cached_resource_request;
@@ -0,0 +1,157 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Tests for SlotBuckets, which lets slots that look the same to a job
+// share the result of matching (and the Rank of) the first of them.
+
+#include "condor_common.h"
+#include "condor_attributes.h"
+#include "condor_classad.h"
+#include "compat_classad_util.h"
+#include "matchmaker_match_cache.h"
+
+static unsigned failures = 0;
+
+static void
+check( bool ok, const char * what ) {
+	if( ! ok ) {
+		++failures;
+		fprintf( stderr, "FAILED: %s\n", what );
+	}
+}
+
+static void
+make_slot( ClassAd & slot, const char * name, int memory ) {
+	slot.Assign( ATTR_NAME, name );
+	slot.Assign( ATTR_MEMORY, memory );
+	slot.Assign( ATTR_ARCH, "X86_64" );
+	slot.AssignExpr( ATTR_REQUIREMENTS, "TARGET.ImageSize <= MY.Memory" );
+}
+
+static void
+make_job( ClassAd & job ) {
+	job.Assign( ATTR_IMAGE_SIZE, 100 );
+	job.AssignExpr( ATTR_REQUIREMENTS, "TARGET.Arch == \"X86_64\" && TARGET.Memory >= 512" );
+	job.AssignExpr( ATTR_RANK, "TARGET.Memory" );
+}
+
+	// every slot in a bucket must give the same Requirements and Rank
+	// result as evaluating the job against the slot itself
+static void
+test_same_result() {
+	ClassAd slot1, slot2, slot3, slot4, job;
+	make_slot( slot1, "slot1@example.org", 1024 );
+	make_slot( slot2, "slot2@example.org", 1024 );
+	make_slot( slot3, "slot3@example.org", 2048 );
+	make_slot( slot4, "slot4@example.org", 256 );
+		// an attribute the job does not look at
+	slot2.Assign( ATTR_STATE, "Claimed" );
+	make_job( job );
+
+	ClassAd *all[] = { &slot1, &slot2, &slot3, &slot4 };
+	const int num_slots = sizeof(all)/sizeof(all[0]);
+	ClassAdListDoesNotDeleteAds slots;
+	for( int i = 0; i < num_slots; ++i ) {
+		slots.Insert( all[i] );
+	}
+	SlotBuckets buckets;
+	buckets.beginCycle( slots );
+	int div = buckets.divide( job );
+	check( div >= 0, "stable job can share results" );
+	check( buckets.bucketCount( div ) == 3, "slots that differ only in what the job ignores share a bucket" );
+	check( buckets.bucket( div, &slot1 ) == buckets.bucket( div, &slot2 ), "slot1 and slot2 share a bucket" );
+	check( buckets.bucket( div, &slot1 ) != buckets.bucket( div, &slot3 ), "slot1 and slot3 do not share a bucket" );
+
+	std::vector<int> bucket_match( buckets.bucketCount( div ), -1 );
+	std::vector<double> bucket_rank( buckets.bucketCount( div ), 0 );
+	for( int i = 0; i < num_slots; ++i ) {
+		int b = buckets.bucket( div, all[i] );
+		bool matched = IsAMatch( &job, all[i] );
+		double rank = 0;
+		EvalFloat( ATTR_RANK, &job, all[i], rank );
+		if( b < 0 ) {
+			check( false, "every stable slot is in a bucket" );
+		} else if( bucket_match[b] < 0 ) {
+			bucket_match[b] = matched ? 1 : 0;
+			bucket_rank[b] = rank;
+		} else {
+			check( bucket_match[b] == (matched ? 1 : 0), "bucket gives the slot's Requirements result" );
+			check( bucket_rank[b] == rank, "bucket gives the slot's Rank" );
+		}
+	}
+}
+
+static void
+test_volatile() {
+	ClassAd slot1, slot2, job;
+	make_slot( slot1, "slot1@example.org", 1024 );
+	make_slot( slot2, "slot2@example.org", 1024 );
+	slot2.AssignExpr( ATTR_REQUIREMENTS, "TARGET.ImageSize <= MY.Memory && random(2) == 0" );
+	make_job( job );
+
+	ClassAdListDoesNotDeleteAds slots;
+	slots.Insert( &slot1 );
+	slots.Insert( &slot2 );
+	SlotBuckets buckets;
+	buckets.beginCycle( slots );
+	int div = buckets.divide( job );
+	check( buckets.bucket( div, &slot1 ) >= 0, "stable slot is in a bucket" );
+	check( buckets.bucket( div, &slot2 ) == -1, "slot calling random() is left out of the buckets" );
+
+	ClassAd random_job;
+	make_job( random_job );
+	random_job.AssignExpr( ATTR_REQUIREMENTS, "TARGET.Memory >= 512 && random(2) == 0" );
+	check( buckets.divide( random_job ) == -1, "job calling random() does not share results" );
+}
+
+static void
+test_invalidate() {
+	ClassAd slot1, slot2, job;
+	make_slot( slot1, "slot1@example.org", 1024 );
+	make_slot( slot2, "slot2@example.org", 1024 );
+	make_job( job );
+
+	ClassAdListDoesNotDeleteAds slots;
+	slots.Insert( &slot1 );
+	slots.Insert( &slot2 );
+	SlotBuckets buckets;
+	buckets.beginCycle( slots );
+	int div = buckets.divide( job );
+	int before = buckets.bucket( div, &slot2 );
+	buckets.invalidate( &slot2 );
+	check( before >= 0, "slot is in a bucket before invalidate" );
+	check( buckets.bucket( div, &slot2 ) == -1, "invalidate() takes the slot out of its bucket" );
+	check( buckets.bucket( div, &slot1 ) == before, "other slots keep their bucket" );
+}
+
+int
+main( int /* argc */, char ** /* argv */ ) {
+		// as the daemons do, unless STRICT_CLASSAD_EVALUATION is set, so
+		// that MY.attr refers to the slot ad
+	classad::SetOldClassAdSemantics( true );
+
+	test_same_result();
+	test_volatile();
+	test_invalidate();
+
+	if( failures == 0 ) {
+		fprintf( stdout, "No failures detected.\n" );
+	}
+	return failures;
+}
@@ -4348,10 +4348,18 @@ show_schedd_queue(const char* scheddAddress, const char* scheddName, const char*
 	StringList *pattrs = &app.attrs;
 	if (dash_unmatchable) pattrs = &no_attrs; // we need all of the attrs to do matchmaking.
 	int fetchResult;
-	if (dash_dry_run) {
-		fetchResult = dryFetchQueue(dry_run_file, *pattrs, fetch_opts, g_match_limit, pfnProcess, pvProcess);
-	} else {
-		fetchResult = Q.fetchQueueFromHostAndProcess(scheddAddress, *pattrs, fetch_opts, g_match_limit, pfnProcess, pvProcess, useFastPath, &errstack, &summary_ad);
+	{
+		// when the jobads are all kept until they are printed, parse them into one arena.
+		// the other processing options delete each ad as they go, so they use the heap.
+		std::unique_ptr<classad::ClassAdArena::Batch> batch;
+		if (pfnProcess == AddJobToClassAdCollection) {
+			batch.reset(new classad::ClassAdArena::Batch());
+		}
+		if (dash_dry_run) {
+			fetchResult = dryFetchQueue(dry_run_file, *pattrs, fetch_opts, g_match_limit, pfnProcess, pvProcess);
+		} else {
+			fetchResult = Q.fetchQueueFromHostAndProcess(scheddAddress, *pattrs, fetch_opts, g_match_limit, pfnProcess, pvProcess, useFastPath, &errstack, &summary_ad);
+		}
 	}
 	cleanup_cache_optimizer();
 	if (fetchResult != Q_OK) {
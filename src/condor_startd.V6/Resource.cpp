@@ -309,6 +309,8 @@ Resource::Resource( CpuAttributes* cap, int rid, bool multiple_slots, Resource*
 	r_no_collector_updates = SlotType::type_param_boolean(cap, "HIDDEN", false);
 
 	update_tid = -1;
+	r_update_base_seq = 0;
+	r_delta_updates = 0;
 
 	r_cpu_busy = 0;
 	r_cpu_busy_start_time = 0;
@@ -1531,20 +1533,92 @@ Resource::do_update( void )
 #endif
 #endif
 
+		// Send only the changes since the last update if we can
+	int cmd = UPDATE_STARTD_AD;
+	ClassAd public_delta, private_delta;
+	ClassAd *update_public = &public_ad, *update_private = &private_ad;
+	if( make_update_delta( public_ad, private_ad, public_delta, private_delta ) ) {
+		cmd = UPDATE_STARTD_AD_DELTA;
+		update_public = &public_delta;
+		update_private = &private_delta;
+	}
+
 		// Send class ads to collector(s)
-	rval = resmgr->send_update( UPDATE_STARTD_AD, &public_ad,
-								&private_ad, true );
+	rval = resmgr->send_update( cmd, update_public,
+								update_private, true );
 	if( rval ) {
-		dprintf( D_FULLDEBUG, "Sent update to %d collector(s)\n", rval );
+		dprintf( D_FULLDEBUG, "Sent %s to %d collector(s)\n",
+				 (cmd == UPDATE_STARTD_AD_DELTA) ? "delta update" : "update", rval );
 	} else {
 		dprintf( D_ALWAYS, "Error sending update to collector(s)\n" );
 	}
 
+		// Remember what we sent, so the next update can be a delta.
+		// If any collector did not get this update, it will not be
+		// able to apply a delta, so the next update must be full.
+	if( max_delta_updates > 0 ) {
+		long long seq = 0;
+		CollectorList *collectors = daemonCore->getCollectorList();
+		if( rval > 0 && collectors && rval == collectors->number() &&
+			update_public->LookupInteger( ATTR_UPDATE_SEQUENCE_NUMBER, seq ) )
+		{
+			r_update_base_public = std::move( public_ad );
+			r_update_base_private = std::move( private_ad );
+				// a delta was sent without the full ads, so they don't
+				// have the sequence number that the next delta names
+			r_update_base_public.Assign( ATTR_UPDATE_SEQUENCE_NUMBER, seq );
+			r_update_base_private.Assign( ATTR_UPDATE_SEQUENCE_NUMBER, seq );
+			r_update_base_seq = seq;
+			r_delta_updates = (cmd == UPDATE_STARTD_AD_DELTA) ? r_delta_updates + 1 : 0;
+		} else {
+			r_update_base_seq = 0;
+		}
+	}
+
 	// We _must_ reset update_tid to -1 before we return so
 	// the class knows there is no pending update.
 	update_tid = -1;
 }
 
+bool
+Resource::make_update_delta( const ClassAd & public_ad, const ClassAd & private_ad,
+							 ClassAd & public_delta, ClassAd & private_delta )
+{
+	if( max_delta_updates <= 0 || r_update_base_seq <= 0 ||
+		r_delta_updates >= max_delta_updates ) {
+		return false;
+	}
+
+		// The collector needs these to find the ad that the delta applies
+		// to, and to validate it, so always send them.  The sequence
+		// numbers and start times are added to each update when it is sent,
+		// so they should never be reported as removed.
+	static AttrNameSet always_send;
+	if( always_send.empty() ) {
+		always_send.insert( ATTR_MY_TYPE );
+		always_send.insert( ATTR_TARGET_TYPE );
+		always_send.insert( ATTR_NAME );
+		always_send.insert( ATTR_MACHINE );
+		always_send.insert( ATTR_SLOT_ID );
+		always_send.insert( ATTR_MY_ADDRESS );
+		always_send.insert( ATTR_STARTD_IP_ADDR );
+		always_send.insert( ATTR_UPDATE_SEQUENCE_NUMBER );
+		always_send.insert( ATTR_DAEMON_START_TIME );
+		always_send.insert( ATTR_DAEMON_LAST_RECONFIG_TIME );
+	}
+
+	int pub_changed = MakeClassAdDelta( public_delta, r_update_base_public, public_ad, &always_send );
+	int pvt_changed = MakeClassAdDelta( private_delta, r_update_base_private, private_ad, &always_send );
+	if( pub_changed < 0 || pvt_changed < 0 ) {
+		return false;
+	}
+	int changed = pub_changed + pvt_changed;
+
+	dprintf( D_FULLDEBUG, "Delta update for %s has %d changed attributes\n",
+			 r_name, changed );
+	return true;
+}
+
 // build a slot ad from whole cloth, used for updating the collector, etc
 // it is an ERROR to pass r_classad as input ad here!!
 void Resource::publish_single_slot_ad(ClassAd & ad, time_t cur_time, Purpose purpose)
@@ -1667,6 +1741,8 @@ Resource::update_with_ack( void )
 
 	publish_private(&private_ad);
 
+		// the collector will not have the ad our next delta is based on
+	r_update_base_seq = 0;
 
     if ( !putClassAd ( socket, public_ad ) ) {
 
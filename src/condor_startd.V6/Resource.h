@@ -420,6 +420,16 @@ private:
 
 	int			update_tid;	// DaemonCore timer id for update delay
 
+		// The last ads sent to the collector(s) and the sequence number
+		// they were sent with, so that the next update can send only
+		// the attributes that changed.  see STARTD_MAX_DELTA_UPDATES
+	ClassAd		r_update_base_public;
+	ClassAd		r_update_base_private;
+	long long	r_update_base_seq;	// 0 if the next update must be a full one
+	int			r_delta_updates;	// delta updates sent since the last full one
+	bool	make_update_delta( const ClassAd & public_ad, const ClassAd & private_ad,
+							   ClassAd & public_delta, ClassAd & private_delta );
+
 	int		r_cpu_busy;
 	time_t	r_cpu_busy_start_time;
 	time_t	r_last_compute_condor_load;
@@ -89,6 +89,7 @@ extern	int		polling_interval;	// Interval for polling when
 									// running a job
 extern	int		update_interval;	// Interval to update CM
 extern	int		update_offset;		// Interval offset to update CM
+extern	int		max_delta_updates;	// Delta updates to send between full updates
 
 // String Lists
 extern	StringList* console_devices;
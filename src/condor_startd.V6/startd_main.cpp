@@ -57,6 +57,7 @@ ResMgr*	resmgr;			// Pointer to the resource manager object
 int	polling_interval = 0;	// Interval for polling when there are resources in use
 int	update_interval = 0;	// Interval to update CM
 int	update_offset = 0;		// Interval offset to update CM
+int	max_delta_updates = 0;	// Delta updates to send between full updates
 
 // String Lists
 StringList *startd_job_attrs = NULL;
@@ -510,6 +511,7 @@ init_params( int first_time)
 
 	update_interval = param_integer( "UPDATE_INTERVAL", 300, 1 );
 	update_offset = param_integer( "UPDATE_OFFSET", 0, 0 );
+	max_delta_updates = param_integer( "STARTD_MAX_DELTA_UPDATES", 0, 0 );
 
 	if( accountant_host ) {
 		free( accountant_host );
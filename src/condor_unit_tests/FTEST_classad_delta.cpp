@@ -0,0 +1,216 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/*
+	This code tests MakeClassAdDelta() and ApplyClassAdDelta(), which
+	the startd and collector use for delta updates of slot ads.
+ */
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "classad_merge.h"
+#include "function_test_driver.h"
+#include "emit.h"
+#include "unit_test_utils.h"
+
+static bool test_round_trip(void);
+static bool test_removed(void);
+static bool test_always_send(void);
+static bool test_base_mismatch(void);
+static bool test_no_base(void);
+
+bool FTEST_classad_delta(void) {
+	emit_function("MakeClassAdDelta() and ApplyClassAdDelta()");
+	emit_comment("Making a delta from one update of an ad to the next, and "
+		"applying it to the ad that holds the first update");
+
+		// driver to run the tests and all required setup
+	FunctionDriver driver;
+	driver.register_function(test_round_trip);
+	driver.register_function(test_removed);
+	driver.register_function(test_always_send);
+	driver.register_function(test_base_mismatch);
+	driver.register_function(test_no_base);
+
+		// run the tests
+	return driver.do_all_functions();
+}
+
+	// the update the delta is made from, and the one that follows it
+static void make_updates(ClassAd &base_ad, ClassAd &new_ad) {
+	base_ad.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 5);
+	base_ad.Assign(ATTR_NAME, "slot1@example.org");
+	base_ad.Assign(ATTR_STATE, "Unclaimed");
+	base_ad.Assign(ATTR_MEMORY, 1024);
+	base_ad.AssignExpr(ATTR_REQUIREMENTS, "START");
+	base_ad.Assign("Gone", "soon");
+
+	new_ad.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 6);
+	new_ad.Assign(ATTR_NAME, "slot1@example.org");
+	new_ad.Assign(ATTR_STATE, "Claimed");
+	new_ad.Assign(ATTR_MEMORY, 1024);
+	new_ad.AssignExpr(ATTR_REQUIREMENTS, "START");
+	new_ad.Assign("Added", true);
+}
+
+	// true if the two ads have the same attributes with the same values
+static bool same_ads(const ClassAd &ad1, const ClassAd &ad2) {
+	if (ad1.size() != ad2.size()) {
+		return false;
+	}
+	for (auto itr = ad1.begin(); itr != ad1.end(); itr++) {
+		ExprTree *expr = ad2.Lookup(itr->first);
+		if ( ! expr || ! expr->SameAs(itr->second)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool test_round_trip() {
+	emit_test("Does applying a delta to the base ad give the new ad?");
+
+	ClassAd base_ad, new_ad, delta;
+	make_updates(base_ad, new_ad);
+	AttrNameSet always_send;
+	always_send.insert(ATTR_UPDATE_SEQUENCE_NUMBER);
+
+	int changed = MakeClassAdDelta(delta, base_ad, new_ad, &always_send);
+	long long base_seq = -1;
+	delta.LookupInteger(ATTR_UPDATE_DELTA_BASE, base_seq);
+
+	ClassAd stored(base_ad);
+	int applied = ApplyClassAdDelta(&stored, delta);
+
+	emit_input_header();
+	emit_param("Changed", "%d", changed);
+	emit_param("Base", "%lld", base_seq);
+	emit_output_expected_header();
+	emit_retval("%d", 4);
+	emit_output_actual_header();
+	emit_retval("%d", applied);
+	if (changed != 3 || base_seq != 5 || applied != 4) {
+		FAIL;
+	}
+	if ( ! same_ads(stored, new_ad)) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_removed() {
+	emit_test("Is an attribute missing from the new ad listed as removed, "
+		"and deleted when the delta is applied?");
+
+	ClassAd base_ad, new_ad, delta;
+	make_updates(base_ad, new_ad);
+
+	MakeClassAdDelta(delta, base_ad, new_ad);
+	std::string removed;
+	delta.LookupString(ATTR_UPDATE_DELTA_REMOVED, removed);
+
+	ClassAd stored(base_ad);
+	ApplyClassAdDelta(&stored, delta);
+
+	emit_input_header();
+	emit_param("Removed", "%s", removed.c_str());
+	emit_output_expected_header();
+	emit_retval("%s", "FALSE");
+	emit_output_actual_header();
+	emit_retval("%s", tfstr(stored.Lookup("Gone") != NULL));
+	if (removed != "Gone" || stored.Lookup("Gone") ||
+		delta.Lookup("Gone") || stored.Lookup(ATTR_UPDATE_DELTA_REMOVED)) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_always_send() {
+	emit_test("Are unchanged attributes left out of the delta, except "
+		"those that are always sent?");
+
+	ClassAd base_ad, new_ad, delta;
+	make_updates(base_ad, new_ad);
+	AttrNameSet always_send;
+	always_send.insert(ATTR_NAME);
+
+	MakeClassAdDelta(delta, base_ad, new_ad, &always_send);
+
+	emit_input_header();
+	emit_param("Always send", "%s", ATTR_NAME);
+	emit_output_expected_header();
+	emit_retval("%s", "TRUE");
+	emit_output_actual_header();
+	emit_retval("%s", tfstr(delta.Lookup(ATTR_NAME) != NULL));
+	if ( ! delta.Lookup(ATTR_NAME) || delta.Lookup(ATTR_MEMORY) ||
+		delta.Lookup(ATTR_REQUIREMENTS) || ! delta.Lookup(ATTR_STATE)) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_base_mismatch() {
+	emit_test("Is a delta dropped when the ad does not hold the update "
+		"that the delta was made from?");
+
+	ClassAd base_ad, new_ad, delta;
+	make_updates(base_ad, new_ad);
+	MakeClassAdDelta(delta, base_ad, new_ad);
+
+	ClassAd stored(base_ad);
+	stored.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 4);
+	ClassAd before(stored);
+	int applied = ApplyClassAdDelta(&stored, delta);
+
+	emit_input_header();
+	emit_param("Stored sequence number", "%d", 4);
+	emit_param("Delta base", "%d", 5);
+	emit_output_expected_header();
+	emit_retval("%d", -1);
+	emit_output_actual_header();
+	emit_retval("%d", applied);
+	if (applied != -1 || ClassAdDeltaAppliesTo(stored, delta) ||
+		! same_ads(stored, before)) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_no_base() {
+	emit_test("Does MakeClassAdDelta() fail when the base ad has no "
+		"sequence number?");
+
+	ClassAd base_ad, new_ad, delta;
+	make_updates(base_ad, new_ad);
+	base_ad.Delete(ATTR_UPDATE_SEQUENCE_NUMBER);
+	int changed = MakeClassAdDelta(delta, base_ad, new_ad);
+
+	emit_input_header();
+	emit_param("Base sequence number", "%s", "none");
+	emit_output_expected_header();
+	emit_retval("%d", -1);
+	emit_output_actual_header();
+	emit_retval("%d", changed);
+	if (changed != -1) {
+		FAIL;
+	}
+	PASS;
+}
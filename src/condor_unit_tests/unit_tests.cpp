@@ -46,6 +46,7 @@ bool FTEST_basename(void);
 bool FTEST_dirname(void);
 bool FTEST_fullpath(void);
 bool FTEST_flatten_and_inline(void);
+bool FTEST_classad_delta(void);
 bool FTEST_stl_string_utils(void);
 bool FTEST_your_string(void);
 bool FTEST_tokener(void);
@@ -80,6 +81,7 @@ const static struct {
 	map(FTEST_dirname),
 	map(FTEST_fullpath),
 	map(FTEST_flatten_and_inline),
+	map(FTEST_classad_delta),
 	map(FTEST_stl_string_utils),
 	map(FTEST_your_string),
 	map(FTEST_tokener),
@@ -20,7 +20,9 @@
 
 #include "condor_common.h"
 #include "condor_classad.h"
+#include "condor_attributes.h"
 #include "classad_merge.h"
+#include "stl_string_utils.h"
 
 void MergeClassAds(ClassAd *merge_into, ClassAd *merge_from, 
 				   bool merge_conflicts, bool mark_dirty,
@@ -104,3 +106,94 @@ int MergeClassAdsIgnoring(ClassAd *merge_into, ClassAd *merge_from, const AttrNa
 	return cMerged;
 }
 
+
+int MakeClassAdDelta(ClassAd &delta, const ClassAd &base_ad, const ClassAd &new_ad, const AttrNameSet *always_send /*=NULL*/)
+{
+	// the delta can only be applied to the update that base_ad was
+	long long base_seq = 0;
+	if ( ! base_ad.LookupInteger(ATTR_UPDATE_SEQUENCE_NUMBER, base_seq)) {
+		return -1;
+	}
+
+	int cChanged = 0;
+
+	for (auto itr = new_ad.begin(); itr != new_ad.end(); itr++) {
+		bool send = always_send && always_send->find(itr->first) != always_send->end();
+		if ( ! send) {
+			ExprTree *base_expr = base_ad.Lookup(itr->first);
+			if (base_expr && base_expr->SameAs(itr->second)) {
+				continue;
+			}
+			++cChanged;
+		}
+		delta.Insert(itr->first, itr->second->Copy());
+	}
+
+	std::string removed;
+	for (auto itr = base_ad.begin(); itr != base_ad.end(); itr++) {
+		if (always_send && always_send->find(itr->first) != always_send->end()) {
+			continue;
+		}
+		if ( ! new_ad.Lookup(itr->first)) {
+			if ( ! removed.empty()) { removed += ","; }
+			removed += itr->first;
+			++cChanged;
+		}
+	}
+	if ( ! removed.empty()) {
+		delta.Assign(ATTR_UPDATE_DELTA_REMOVED, removed);
+	}
+	delta.Assign(ATTR_UPDATE_DELTA_BASE, base_seq);
+
+	return cChanged;
+}
+
+bool ClassAdDeltaAppliesTo(const ClassAd &ad, const ClassAd &delta)
+{
+	long long base_seq = -1, cur_seq = -1;
+	return delta.LookupInteger(ATTR_UPDATE_DELTA_BASE, base_seq) &&
+		ad.LookupInteger(ATTR_UPDATE_SEQUENCE_NUMBER, cur_seq) &&
+		base_seq == cur_seq;
+}
+
+int ApplyClassAdDelta(ClassAd *apply_to, const ClassAd &delta, const AttrNameSet *ignore /*=NULL*/, bool mark_dirty /*=true*/)
+{
+	if ( ! apply_to || ! ClassAdDeltaAppliesTo(*apply_to, delta)) {
+		return -1;
+	}
+
+	bool was_dirty_tracking = apply_to->SetDirtyTracking(mark_dirty);
+
+	int cApplied = 0;
+
+	// removals first, so that the sender can both remove and re-add
+	// an attribute in the same delta.
+	std::string removed;
+	if (delta.LookupString(ATTR_UPDATE_DELTA_REMOVED, removed)) {
+		StringTokenIterator it(removed);
+		for (const char *name = it.first(); name; name = it.next()) {
+			if (ignore && ignore->find(name) != ignore->end()) {
+				continue;
+			}
+			if (apply_to->Delete(name)) {
+				++cApplied;
+			}
+		}
+	}
+
+	for (auto itr = delta.begin(); itr != delta.end(); itr++) {
+		const std::string &name = itr->first;
+		if (strcasecmp(name.c_str(), ATTR_UPDATE_DELTA_REMOVED) == MATCH ||
+			strcasecmp(name.c_str(), ATTR_UPDATE_DELTA_BASE) == MATCH) {
+			continue;
+		}
+		if (ignore && ignore->find(name) != ignore->end()) {
+			continue;
+		}
+		apply_to->Insert(name, itr->second->Copy());
+		++cApplied;
+	}
+
+	apply_to->SetDirtyTracking(was_dirty_tracking);
+	return cApplied;
+}
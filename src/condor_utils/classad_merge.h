@@ -52,4 +52,33 @@ void MergeClassAdsCleanly(ClassAd *merge_into, ClassAd *merge_from);
 int MergeClassAdsIgnoring(ClassAd *merge_into, ClassAd *merge_from,
 						  const AttrNameSet & ignore, bool mark_dirty = true);
 
+/** Build a delta ad that holds the attributes of new_ad that are not
+ *  in base_ad or that have a different value there.  The names of the
+ *  attributes of base_ad that are not in new_ad are put into the delta
+ *  as a string list in ATTR_UPDATE_DELTA_REMOVED, and the
+ *  ATTR_UPDATE_SEQUENCE_NUMBER of base_ad as ATTR_UPDATE_DELTA_BASE.
+ *  Attributes in the always_send set are copied into the delta whether
+ *  they changed or not, and are never listed as removed.
+ *  @return the number of attributes that were added, changed or removed,
+ *  or -1 if base_ad has no sequence number to base a delta on
+ */
+int MakeClassAdDelta(ClassAd &delta, const ClassAd &base_ad, const ClassAd &new_ad,
+					 const AttrNameSet *always_send = NULL);
+
+/** True if the delta was made from the update that ad holds, that is
+ *  its ATTR_UPDATE_DELTA_BASE is the ATTR_UPDATE_SEQUENCE_NUMBER of ad.
+ */
+bool ClassAdDeltaAppliesTo(const ClassAd &ad, const ClassAd &delta);
+
+/** Apply a delta ad made by MakeClassAdDelta() to an ad, inserting the
+ *  changed attributes and deleting the removed ones.  Attributes in the
+ *  ignore set are neither inserted nor deleted.  A delta that was not
+ *  made from the update the ad holds (see ClassAdDeltaAppliesTo()) is
+ *  not applied; the sender must send the full ad instead.
+ *  @return the number of attributes that were inserted or deleted, or -1
+ *  if the delta does not apply to the ad
+ */
+int ApplyClassAdDelta(ClassAd *apply_to, const ClassAd &delta,
+					  const AttrNameSet *ignore = NULL, bool mark_dirty = true);
+
 #endif
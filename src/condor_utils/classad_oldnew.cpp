@@ -37,6 +37,8 @@ int _putClassAd(Stream *sock, const classad::ClassAd& ad, int options,
 int _putClassAd(Stream *sock, const classad::ClassAd& ad, int options,
 	const classad::References &whitelist, const classad::References *encrypted_attrs);
 int _mergeStringListIntoWhitelist(StringList & list_in, classad::References & whitelist_out);
+static int _putBinaryClassAd(Stream *sock, const classad::ClassAd& ad, int options,
+	const classad::References *whitelist, const classad::References *encrypted_attrs);
 
 
 static bool publish_server_timeMangled = false;
@@ -47,9 +49,47 @@ void AttrList_setPublishServerTime(bool publish)
 
 static const char *SECRET_MARKER = "ZKM"; // "it's a Zecret Klassad, Mon!"
 
+// Sent in place of the attribute count when the ad that follows is in
+// the binary encoding: an int length, then that many bytes written by
+// classad::ClassAdBinaryUnParser, then the usual MyType and TargetType
+// strings.  Only peers that said in the security handshake that they
+// can read it (ATTR_SEC_BINARY_CLASSADS) are sent it; all others get
+// text.  Attribute names are written by reference to a table that lasts
+// until the end of the CEDAR message, so all of the ads in a query reply
+// share the names.
+static const int BINARY_CLASSAD_MARKER = -2;
+
+static bool send_binary_classads = false;
+void AttrList_setBinaryEncoding(bool enable)
+{
+	send_binary_classads = enable;
+}
+
+// read the rest of an ad in the binary encoding, once the marker has been read.
+static bool getBinaryClassAd( Stream *sock, classad::ClassAd& ad )
+{
+	int cb = 0;
+	if ( ! sock->code(cb) || cb < 0) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get binary ClassAd length\n");
+		return false;
+	}
+	std::string buf;
+	buf.resize(cb);
+	if (cb && sock->get_bytes(&buf[0], cb) != cb) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get %d byte binary ClassAd\n", cb);
+		return false;
+	}
+	if ( ! sock->classad_binary_parser()->ParseClassAd(buf.data(), buf.size(), ad)) {
+		dprintf(D_ALWAYS, "getClassAd FAILED to parse %d byte binary ClassAd\n", cb);
+		return false;
+	}
+	return true;
+}
+
 ClassAd *
 getClassAd( Stream *sock )
 {
+	classad::ClassAdArena::Parsing parsing;
 	ClassAd *ad = new ClassAd( );
 	if( !ad ) { 
 		return NULL;
@@ -63,6 +103,7 @@ getClassAd( Stream *sock )
 
 bool getClassAd( Stream *sock, classad::ClassAd& ad )
 {
+	classad::ClassAdArena::Parsing parsing;
 	int 					numExprs;
 	MyString				inputLine;
 
@@ -74,6 +115,13 @@ bool getClassAd( Stream *sock, classad::ClassAd& ad )
  		return false;
 	}
 
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		if ( ! getBinaryClassAd(sock, ad)) {
+			return false;
+		}
+		numExprs = 0;
+	}
+
 	// at least numExprs are coming, but we may add
 	// my, target, and a couple extra right away
 
@@ -224,13 +272,17 @@ static long long myatoll(const char *s, const char* &end) {
 
 bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options)
 {
+	classad::ClassAdArena::Parsing parsing;
 	int cb;
 	const char *strptr;
 	std::string attr;
 	bool use_cache = (options & GET_CLASSAD_NO_CACHE) == 0;
 	bool cache_lazy = (options & GET_CLASSAD_LAZY_PARSE) != 0;
 	bool fast_tricks = (options & GET_CLASSAD_FAST) != 0;
-	const size_t always_cache_string_size = 128; // no fast parse for strings > this size.
+	// no fast parse for strings > this size. when sharing strings, only strings that fit
+	// into a std::string without a heap allocation (15 characters, so 17 with the quotes)
+	// are parsed as private literals, the rest are shared through the cache.
+	const size_t always_cache_string_size = (options & GET_CLASSAD_SHARE_STRINGS) ? 18 : 128;
 
 #ifdef PROFILE_GETCLASSAD
 	_condor_auto_accum_runtime< stats_entry_probe<double> > rt(getClassAdEx_runtime);
@@ -251,6 +303,14 @@ bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options)
 		return false;
 	}
 
+	// binary ads are not parsed, so there is nothing for the cache or the fast tricks to do
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		if ( ! getBinaryClassAd(sock, ad)) {
+			return false;
+		}
+		numExprs = 0;
+	}
+
 	// at least numExprs are coming, but we may add
 	// my, target, and a couple extra right away
 	// Auth (id,method) update(total,seq,lost,history)
@@ -422,6 +482,7 @@ int getClassAdNonblocking( ReliSock *sock, classad::ClassAd& ad )
 bool
 getClassAdNoTypes( Stream *sock, classad::ClassAd& ad )
 {
+	classad::ClassAdArena::Parsing parsing;
 	classad::ClassAdParser	parser;
 	int 					numExprs = 0; // Initialization clears Coverity warning
 	string					buffer;
@@ -437,6 +498,10 @@ getClassAdNoTypes( Stream *sock, classad::ClassAd& ad )
  		return false;
 	}
 
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return getBinaryClassAd(sock, ad);
+	}
+
 		// pack exprs into classad
 	buffer = "[";
 	for( int i = 0 ; i < numExprs ; i++ ) {
@@ -573,20 +638,26 @@ int putClassAd (Stream *sock, const classad::ClassAd& ad, int options, const cla
 	if (non_blocking && rsock)
 	{
 		BlockingModeGuard guard(rsock, true);
-		if (whitelist) {
-			retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs);
-		} else {
-			retval = _putClassAd(sock, ad, options, encrypted_attrs);
+		retval = _putBinaryClassAd(sock, ad, options, whitelist, encrypted_attrs);
+		if (retval < 0) {
+			if (whitelist) {
+				retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs);
+			} else {
+				retval = _putClassAd(sock, ad, options, encrypted_attrs);
+			}
 		}
 		bool backlog = rsock->clear_backlog_flag();
 		if (retval && backlog) { retval = 2; }
 	}
 	else // normal blocking mode put
 	{
-		if (whitelist) {
-			retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs);
-		} else {
-			retval = _putClassAd(sock, ad, options, encrypted_attrs);
+		retval = _putBinaryClassAd(sock, ad, options, whitelist, encrypted_attrs);
+		if (retval < 0) {
+			if (whitelist) {
+				retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs);
+			} else {
+				retval = _putClassAd(sock, ad, options, encrypted_attrs);
+			}
 		}
 	}
 	return retval;
@@ -625,6 +696,93 @@ static int _putClassAdTrailingInfo(Stream *sock, const classad::ClassAd& /* ad *
 	return true;
 }
 
+// add an attribute to those to be sent in the binary encoding. returns false if the
+// attribute would have to be sent as a secret, which the binary encoding cannot do.
+static bool _addBinaryAttr(std::vector< std::pair<std::string, classad::ExprTree*> > &attrs,
+	const std::string &attr, classad::ExprTree *expr,
+	bool exclude_private, bool crypto_is_noop, const classad::References *encrypted_attrs)
+{
+	if (ClassAdAttributeIsPrivate(attr) ||
+		(encrypted_attrs && (encrypted_attrs->find(attr) != encrypted_attrs->end())))
+	{
+		if (exclude_private) {
+			return true;
+		}
+		if ( ! crypto_is_noop) {
+			return false;
+		}
+	}
+	attrs.push_back(std::make_pair(attr, expr));
+	return true;
+}
+
+// send the ad in the binary encoding if the peer can read it.  returns -1 without
+// sending anything if the ad should be sent as text instead, otherwise the same
+// as _putClassAd.
+static int _putBinaryClassAd(Stream *sock, const classad::ClassAd& ad, int options,
+	const classad::References *whitelist, const classad::References *encrypted_attrs)
+{
+	if ( ! send_binary_classads || sock->type() != Stream::reli_sock) {
+		return -1;
+	}
+	if ( ! sock->get_peer_binary_classads()) {
+		return -1;
+	}
+
+	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
+	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
+	bool crypto_is_noop = sock->prepare_crypto_for_secret_is_noop();
+
+	// the same attributes in the same order as the text would have them, chained
+	// attributes first so that the ad's own attributes replace them.
+	std::vector< std::pair<std::string, classad::ExprTree*> > attrs;
+	attrs.reserve(whitelist ? whitelist->size() : ad.size() + 1);
+	if (whitelist) {
+		for (classad::References::const_iterator attr = whitelist->begin(); attr != whitelist->end(); ++attr) {
+			classad::ExprTree *expr = ad.Lookup(*attr);
+			if (expr && ! (publish_server_timeMangled && strcasecmp(attr->c_str(), ATTR_SERVER_TIME) == 0) &&
+				! _addBinaryAttr(attrs, *attr, expr, exclude_private, crypto_is_noop, encrypted_attrs)) {
+				return -1;
+			}
+		}
+	} else {
+		const classad::ClassAd *chainedAd = ad.GetChainedParentAd();
+		for (int pass = chainedAd ? 0 : 1; pass < 2; ++pass) {
+			const classad::ClassAd &cur = pass ? ad : *chainedAd;
+			for (classad::AttrList::const_iterator itor = cur.begin(); itor != cur.end(); ++itor) {
+				if ( ! _addBinaryAttr(attrs, itor->first, itor->second, exclude_private, crypto_is_noop, encrypted_attrs)) {
+					return -1;
+				}
+			}
+		}
+	}
+
+	classad::ExprTree *server_time = NULL;
+	if (publish_server_timeMangled) {
+		server_time = classad::Literal::MakeLong(time(NULL));
+		attrs.push_back(std::make_pair(std::string(ATTR_SERVER_TIME), server_time));
+	}
+
+	std::string buf;
+	bool encoded = sock->classad_binary_unparser()->Unparse(buf, attrs);
+	delete server_time;
+	if ( ! encoded) {
+		return -1;
+	}
+
+	int marker = BINARY_CLASSAD_MARKER;
+	int cb = (int)buf.size();
+	sock->encode();
+	if ( ! sock->code(marker) || ! sock->code(cb)) {
+		return false;
+	}
+	if (cb && sock->put_bytes(buf.data(), cb) != cb) {
+		return false;
+	}
+
+	return _putClassAdTrailingInfo(sock, ad, false, excludeTypes);
+}
+
 int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 	const classad::References *encrypted_attrs)
 {
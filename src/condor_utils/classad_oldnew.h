@@ -33,6 +33,10 @@ class ReliSock;
 
 void AttrList_setPublishServerTime(bool publish);
 
+// send ClassAds in the binary encoding to peers that can read it.
+// ads are read in either encoding regardless of this setting.
+void AttrList_setBinaryEncoding(bool enable);
+
 classad::ClassAd* getClassAd( Stream *sock );
 
 bool getClassAd( Stream *sock, classad::ClassAd& ad);
@@ -43,6 +47,7 @@ bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options);
 #define GET_CLASSAD_NO_CLEAR            0x08 // don't clear the ad, just merge new attributes into it.
 #define GET_CLASSAD_FAST                0x10 // use tricks to quickly parse the ad.
 #define GET_CLASSAD_LAZY_PARSE          0x20 // parse only when evaluating the first time. (ignored if GET_CLASSAD_NO_CACHE is set)
+#define GET_CLASSAD_SHARE_STRINGS       0x40 // with GET_CLASSAD_FAST, only short strings bypass the classAdCache, so longer ones are shared between ads
 
 class StatisticsPool;
 void getClassAdEx_addProfileStatsToPool(StatisticsPool * pool, int publevel);
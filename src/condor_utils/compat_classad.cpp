@@ -25,7 +25,6 @@
 #include "condor_attributes.h"
 #include "classad/xmlSink.h"
 #include "condor_config.h"
-#include "Regex.h"
 #include "classad/classadCache.h"
 #include "env.h"
 #include "condor_arglist.h"
@@ -83,6 +82,11 @@ void ClassAdReconfig()
 	classad::SetOldClassAdSemantics( !ClassAd_strictEvaluation );
 
 	classad::ClassAdSetExpressionCaching( param_boolean( "ENABLE_CLASSAD_CACHING", false ) );
+	classad::ClassAdSetCompileThreshold( param_integer( "CLASSAD_COMPILE_THRESHOLD", 10 ) );
+	classad::ClassAdSetRegexCacheSize( param_integer( "CLASSAD_REGEX_CACHE_SIZE", 1000 ) );
+	classad::ClassAdSetRegexJIT( param_boolean( "CLASSAD_REGEX_JIT", true ) );
+	classad::EvalProfile::Enable( param_boolean( "CLASSAD_EVAL_PROFILING", false ) );
+	AttrList_setBinaryEncoding( param_boolean( "ENABLE_CLASSAD_BINARY_ENCODING", false ) );
 
 	char *new_libs = param( "CLASSAD_USER_LIBS" );
 	if ( new_libs ) {
@@ -364,26 +368,22 @@ bool stringListMember_func( const char *name,
 	return true;
 }
 
-static int regexp_str_to_options( const char *option_str )
+// the options of regexp() that stringListRegexpMember() also takes,
+// in either case
+static std::string regexp_str_to_options( const char *option_str )
 {
-	int options = 0;
+	std::string options;
 	while (*option_str) {
 		switch (*option_str) {
 			case 'i':
 			case 'I':
-				options |= Regex::caseless;
-				break;
 			case 'm':
 			case 'M':
-				options |= Regex::multiline;
-				break;
 			case 's':
 			case 'S':
-				options |= Regex::dotall;
-				break;
 			case 'x':
 			case 'X':
-				options |= Regex::extended;
+				options += (char)tolower(*option_str);
 				break;
 			default:
 				// Ignore for forward compatibility 
@@ -431,34 +431,38 @@ bool stringListRegexpMember_func( const char * /*name*/,
 		return true;
 	}
 
-	StringList sl( list_str.c_str(), delim_str.c_str() );
-	if ( sl.number() == 0 ) {
-		result.SetUndefinedValue();
+	// the pattern is compiled once, and is an error even if there is
+	// nothing to match it against
+	std::string options = regexp_str_to_options(options_str.c_str());
+	classad::RegexpMatcher regex( pattern_str.c_str(), options );
+	if ( ! regex.Valid() ) {
+		result.SetErrorValue();
 		return true;
 	}
 
-	Regex r;
-	const char *errstr = 0;
-	int errpos = 0;
-	bool valid;
-	int options = regexp_str_to_options(options_str.c_str());
-
-	/* can the pattern be compiled */
-	valid = r.compile(pattern_str.c_str(), &errstr, &errpos, options);
-	if (!valid) {
-		result.SetErrorValue();
+	StringList sl( list_str.c_str(), delim_str.c_str() );
+	if ( sl.number() == 0 ) {
+		result.SetUndefinedValue();
 		return true;
 	}
 
-	result.SetBooleanValue( false );
-
 	sl.rewind();
 	char *entry;
+	bool matched = false;
 	while( (entry = sl.next())) {
-		if (r.match(entry)) {
-			result.SetBooleanValue( true );
+		classad::Value match;
+		regex.Match( entry, match );
+		if ( match.IsErrorValue() ) {
+			result.SetErrorValue();
+			return true;
+		}
+		bool is_match = false;
+		if ( match.IsBooleanValue( is_match ) && is_match ) {
+			matched = true;
+			break;
 		}
 	}
+	result.SetBooleanValue( matched );
 
 	return true;
 }
@@ -1212,6 +1216,22 @@ CondorClassAdFileParseHelper::~CondorClassAdFileParseHelper()
 		default: break;
 	}
 	ASSERT( ! new_parser);
+	delete new_source;
+	new_source = NULL;
+}
+
+// the source the new parsers read the file through. it reads ahead, so it
+// must be kept from one ad to the next, and nothing else may read the file.
+// a helper may be used for one file after another, which could reuse the
+// FILE* of one that was closed, so start over once a file has been read.
+classad::LexerSource * CondorClassAdFileParseHelper::getNewSource(FILE* file)
+{
+	if ( ! new_source) {
+		new_source = new classad::BufferedFileLexerSource(file);
+	} else if (new_source->GetSource() != file || new_source->AtEnd()) {
+		new_source->SetNewSource(file);
+	}
+	return new_source;
 }
 
 
@@ -1288,10 +1308,11 @@ int CondorClassAdFileParseHelper::NewParser(classad::ClassAd & ad, FILE* file, b
 				new_parser = (void*)parser;
 			}
 			ASSERT(parser);
-			bool fok = parser->ParseClassAd(file, ad);
+			classad::LexerSource * source = getNewSource(file);
+			bool fok = parser->ParseClassAd(source, ad);
 			if (fok) {
 				rval = ad.size();
-			} else if (feof(file)) {
+			} else if (source->AtEnd()) {
 				rval = -99;
 			} else {
 				rval = -1;
@@ -1305,7 +1326,8 @@ int CondorClassAdFileParseHelper::NewParser(classad::ClassAd & ad, FILE* file, b
 				new_parser = (void*)parser;
 			}
 			ASSERT(parser);
-			bool fok = parser->ParseClassAd(file, ad, false);
+			classad::LexerSource * source = getNewSource(file);
+			bool fok = parser->ParseClassAd(source, ad, false);
 			if ( ! fok) {
 				bool keep_going = false;
 				classad::Lexer::TokenType tt = parser->getLastTokenType();
@@ -1316,12 +1338,12 @@ int CondorClassAdFileParseHelper::NewParser(classad::ClassAd & ad, FILE* file, b
 					if (tt == classad::Lexer::LEX_OPEN_BOX) { keep_going = true; inside_list = true; }
 				}
 				if (keep_going) {
-					fok = parser->ParseClassAd(file, ad, false); 
+					fok = parser->ParseClassAd(source, ad, false);
 				}
 			}
 			if (fok) {
 				rval = ad.size();
-			} else if (feof(file)) {
+			} else if (source->AtEnd()) {
 				rval = -99;
 			} else {
 				rval = -1;
@@ -1335,7 +1357,8 @@ int CondorClassAdFileParseHelper::NewParser(classad::ClassAd & ad, FILE* file, b
 				new_parser = (void*)parser;
 			}
 			ASSERT(parser);
-			bool fok = parser->ParseClassAd(file, ad);
+			classad::LexerSource * source = getNewSource(file);
+			bool fok = parser->ParseClassAd(source, ad);
 			if ( ! fok) {
 				bool keep_going = false;
 				classad::Lexer::TokenType tt = parser->getLastTokenType();
@@ -1346,12 +1369,12 @@ int CondorClassAdFileParseHelper::NewParser(classad::ClassAd & ad, FILE* file, b
 					if (tt == classad::Lexer::LEX_OPEN_BRACE) { keep_going = true; inside_list = true; }
 				}
 				if (keep_going) {
-					fok = parser->ParseClassAd(file, ad, false); 
+					fok = parser->ParseClassAd(source, ad, false);
 				}
 			}
 			if (fok) {
 				rval = ad.size();
-			} else if (feof(file)) {
+			} else if (source->AtEnd()) {
 				rval = -99;
 			} else {
 				rval = -1;
@@ -2483,39 +2506,7 @@ QuoteAdStringValue(char const *val, std::string &buf)
 void
 ChainCollapse(classad::ClassAd &ad)
 {
-    classad::ExprTree *tmpExprTree;
-
-	classad::ClassAd *parent = ad.GetChainedParentAd();
-
-    if(!parent)
-    {   
-        //nothing chained, time to leave
-        return;
-    }
-
-    ad.Unchain();
-
-    classad::AttrList::iterator itr; 
-
-    for(itr = parent->begin(); itr != parent->end(); itr++)
-    {
-        // Only move the value from our chained ad into our ad when it 
-        // does not already exist. Hence the Lookup(). 
-        // This means that the attributes in our classad takes precedence
-        // over the ones in the chained class ad.
-
-        if( !ad.Lookup((*itr).first) )
-        {
-            tmpExprTree = (*itr).second;     
-
-            //deep copy it!
-            tmpExprTree = tmpExprTree->Copy(); 
-            ASSERT(tmpExprTree); 
-
-            //K, it's clear. Insert it, but don't try to 
-            ad.Insert((*itr).first, tmpExprTree);
-        }
-    }
+	ad.ChainCollapse();
 }
 
 
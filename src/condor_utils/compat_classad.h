@@ -229,7 +229,7 @@ class CondorClassAdFileParseHelper : public ClassAdFileParseHelper
 	};
 
 	CondorClassAdFileParseHelper(std::string delim, ParseType typ=Parse_long) 
-		: ad_delimitor(delim), parse_type(typ), new_parser(NULL), inside_list(false)
+		: ad_delimitor(delim), parse_type(typ), new_parser(NULL), new_source(NULL), inside_list(false)
 		, blank_line_is_ad_delimitor(delim=="\n") {};
 	ParseType getParseType() { return parse_type; }
 	bool configure(const char * delim, ParseType typ) {
@@ -244,10 +244,12 @@ class CondorClassAdFileParseHelper : public ClassAdFileParseHelper
 	CondorClassAdFileParseHelper(const CondorClassAdFileParseHelper & that); // no copy construction
 	CondorClassAdFileParseHelper & operator=(const CondorClassAdFileParseHelper & that); // no assignment
 	bool line_is_ad_delimitor(const std::string & line);
+	classad::LexerSource * getNewSource(FILE* file);
 
 	std::string ad_delimitor;
 	ParseType parse_type;
 	void*     new_parser; // a class whose type depends on the value of parse_type.
+	classad::BufferedFileLexerSource * new_source; // reads the file a chunk at a time for new_parser
 	bool      inside_list;
 	bool      blank_line_is_ad_delimitor;
 };
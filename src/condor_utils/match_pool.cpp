@@ -0,0 +1,258 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "match_pool.h"
+
+	// chunks handed to each thread at the start of a match; more
+	// chunks balance better, fewer cost less locking.
+static const size_t CHUNKS_PER_THREAD = 8;
+
+MatchPool::MatchPool()
+	: m_generation(0)
+	, m_busy(0)
+	, m_exit(false)
+	, m_request(NULL)
+	, m_candidates(NULL)
+	, m_checks(NULL)
+	, m_half_match(false)
+	, m_chunk_size(1)
+	, m_num_checks(0)
+{
+	setThreads(1);
+}
+
+MatchPool::~MatchPool()
+{
+	stop();
+}
+
+void
+MatchPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_exit = true;
+	}
+	m_start.notify_all();
+	for (size_t ii = 0; ii < m_workers.size(); ++ii) {
+		if (m_workers[ii]->thread.joinable()) {
+			m_workers[ii]->thread.join();
+		}
+		delete m_workers[ii];
+	}
+	m_workers.clear();
+	m_exit = false;
+}
+
+void
+MatchPool::setThreads(int threads)
+{
+	if (threads < 1) {
+		threads = 1;
+	}
+	if ((size_t)threads == m_workers.size()) {
+		return;
+	}
+
+	stop();
+
+	m_workers.reserve(threads);
+	for (int ii = 0; ii < threads; ++ii) {
+		m_workers.push_back(new Worker);
+	}
+	for (int ii = 1; ii < threads; ++ii) {
+		m_workers[ii]->thread = std::thread(&MatchPool::workerLoop, this, (size_t)ii);
+	}
+}
+
+void
+MatchPool::workerLoop(size_t id)
+{
+	unsigned int seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> guard(m_lock);
+			while ( ! m_exit && m_generation == seen) {
+				m_start.wait(guard);
+			}
+			if (m_exit) {
+				return;
+			}
+			seen = m_generation;
+		}
+
+		doWork(id);
+
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			if (--m_busy == 0) {
+				m_done.notify_one();
+			}
+		}
+	}
+}
+
+bool
+MatchPool::nextChunk(size_t id, size_t &chunk)
+{
+	Worker *self = m_workers[id];
+	{
+		std::lock_guard<std::mutex> guard(self->lock);
+		if ( ! self->chunks.empty()) {
+			chunk = self->chunks.front();
+			self->chunks.pop_front();
+			return true;
+		}
+	}
+
+		// out of our own work, steal from the far end of someone else's
+	for (size_t ii = 1; ii < m_workers.size(); ++ii) {
+		Worker *victim = m_workers[(id + ii) % m_workers.size()];
+		std::lock_guard<std::mutex> guard(victim->lock);
+		if ( ! victim->chunks.empty()) {
+			chunk = victim->chunks.back();
+			victim->chunks.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+MatchPool::doWork(size_t id)
+{
+	Worker *self = m_workers[id];
+	const std::vector<ClassAd*> &candidates = *m_candidates;
+
+	self->request.ChainToAd(m_request);
+	self->mad.ReplaceLeftAd(&self->request);
+
+	size_t chunk;
+	while (nextChunk(id, chunk)) {
+		size_t end = std::min((chunk + 1) * m_chunk_size, candidates.size());
+		for (size_t idx = chunk * m_chunk_size; idx < end; ++idx) {
+			ClassAd *candidate = candidates[idx];
+
+			self->mad.ReplaceRightAd(candidate);
+
+			bool result;
+			if (m_half_match) {
+				result = self->mad.rightMatchesLeft();
+			} else {
+				result = self->mad.symmetricMatch();
+			}
+			m_matched[idx] = result ? 1 : 0;
+
+				// Evaluated against the ads themselves rather than
+				// through EvalExprTree(), which shares one MatchClassAd
+				// and sets the parent scope of the expression.
+			if (result) {
+				classad::Value *vals = &m_values[idx * m_num_checks];
+				for (size_t ii = 0; ii < m_num_checks; ++ii) {
+					const Check &check = (*m_checks)[ii];
+					ClassAd *scope = check.request_scope ? &self->request : candidate;
+					if ( ! check.expr) {
+						vals[ii].SetUndefinedValue();
+					} else if ( ! scope->EvaluateExpr(check.expr, vals[ii])) {
+						vals[ii].SetErrorValue();
+					}
+				}
+			}
+
+			self->mad.RemoveRightAd();
+		}
+	}
+
+	self->mad.RemoveLeftAd();
+	self->request.Unchain();
+}
+
+size_t
+MatchPool::match(ClassAd &request, const std::vector<ClassAd*> &candidates,
+                 bool halfMatch, const std::vector<Check> *checks)
+{
+	size_t count = candidates.size();
+	size_t threads = m_workers.size();
+
+	m_request = &request;
+	m_candidates = &candidates;
+	m_half_match = halfMatch;
+	m_checks = checks;
+	m_num_checks = checks ? checks->size() : 0;
+	m_matched.assign(count, 0);
+	if (m_values.size() < count * m_num_checks) {
+		m_values.resize(count * m_num_checks);
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+		// give each thread a run of neighboring chunks
+	m_chunk_size = count / (threads * CHUNKS_PER_THREAD);
+	if (m_chunk_size < 1) {
+		m_chunk_size = 1;
+	}
+	size_t chunks = (count + m_chunk_size - 1) / m_chunk_size;
+	for (size_t ii = 0; ii < threads; ++ii) {
+		std::lock_guard<std::mutex> guard(m_workers[ii]->lock);
+		m_workers[ii]->chunks.clear();
+		for (size_t chunk = ii * chunks / threads; chunk < (ii + 1) * chunks / threads; ++chunk) {
+			m_workers[ii]->chunks.push_back(chunk);
+		}
+	}
+
+	if (threads > 1) {
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_busy = threads - 1;
+			++m_generation;
+		}
+		m_start.notify_all();
+	}
+
+	doWork(0);
+
+	if (threads > 1) {
+		std::unique_lock<std::mutex> guard(m_lock);
+		while (m_busy > 0) {
+			m_done.wait(guard);
+		}
+	}
+
+	m_request = NULL;
+	m_candidates = NULL;
+	m_checks = NULL;
+
+	size_t matched = 0;
+	for (size_t ii = 0; ii < count; ++ii) {
+		matched += m_matched[ii];
+	}
+	return matched;
+}
+
+const classad::Value *
+MatchPool::values(size_t index) const
+{
+	if ( ! m_num_checks || ! m_matched[index]) {
+		return NULL;
+	}
+	return &m_values[index * m_num_checks];
+}
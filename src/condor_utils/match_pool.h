@@ -0,0 +1,113 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _MATCH_POOL_H
+#define _MATCH_POOL_H
+
+#include "compat_classad.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+	// Matches one ad (the request) against many candidate ads using
+	// a set of threads that lives for as long as the pool does.  The
+	// candidates are cut into chunks that are handed out evenly to the
+	// threads; a thread that runs out of chunks takes them from the
+	// end of another thread's queue, so slow candidates do not hold up
+	// the whole scan.  The calling thread does its share of the work.
+	//
+	// Besides the match itself, the pool can evaluate a set of
+	// expressions (ranks, preemption conditions, ...) for each
+	// candidate that matches, so those are done in parallel too.
+	//
+	// Each thread has its own MatchClassAd and its own ad chained to
+	// the request, so the request is neither copied nor changed.  The
+	// request, candidates and expressions must not change during match().
+class MatchPool {
+
+ public:
+	struct Check {
+		Check() : expr(NULL), request_scope(false) {}
+		Check(classad::ExprTree *e, bool req) : expr(e), request_scope(req) {}
+		classad::ExprTree *expr;	// not owned, may be NULL
+			// evaluate with the request as MY and the candidate as
+			// TARGET, rather than the other way round.
+		bool request_scope;
+	};
+
+	MatchPool();
+	~MatchPool();
+
+		// use this many threads, counting the caller's
+	void setThreads(int threads);
+	int threads() const { return (int)m_workers.size(); }
+
+		// match the request against each of the candidates, and
+		// evaluate the checks for each one that matches.
+		// Returns the number of candidates that matched.
+	size_t match(ClassAd &request, const std::vector<ClassAd*> &candidates,
+	             bool halfMatch = false, const std::vector<Check> *checks = NULL);
+
+		// results of the last match(), indexed like its candidates
+	bool matched(size_t index) const { return m_matched[index] != 0; }
+		// the values of the checks for a matched candidate, in the
+		// order they were given.  A check that is NULL or that could
+		// not be evaluated has an undefined or error value.
+	const classad::Value *values(size_t index) const;
+
+ private:
+
+	struct Worker {
+		classad::MatchClassAd mad;
+		ClassAd request;			// chained to the request being matched
+		std::mutex lock;			// protects chunks
+		std::deque<size_t> chunks;
+		std::thread thread;
+	};
+
+	void stop();
+	void workerLoop(size_t id);
+	void doWork(size_t id);
+	bool nextChunk(size_t id, size_t &chunk);
+
+	std::vector<Worker*> m_workers;	// worker 0 is the caller
+
+	std::mutex m_lock;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	unsigned int m_generation;
+	size_t m_busy;
+	bool m_exit;
+
+		// the current match
+	ClassAd *m_request;
+	const std::vector<ClassAd*> *m_candidates;
+	const std::vector<Check> *m_checks;
+	bool m_half_match;
+	size_t m_chunk_size;
+
+	std::vector<char> m_matched;
+	std::vector<classad::Value> m_values;
+	size_t m_num_checks;
+};
+
+#endif
@@ -343,7 +343,8 @@ parseOldAds_impl(boost::python::object input)
 };
 
 ClassAdFileIterator::ClassAdFileIterator(FILE *source)
-  : m_done(false), m_source(source), m_parser(new classad::ClassAdParser())
+  : m_done(false), m_source(source), m_parser(new classad::ClassAdParser()),
+    m_lexer_source(new classad::BufferedFileLexerSource(source))
 {}
 
 boost::shared_ptr<ClassAdWrapper>
@@ -352,9 +353,9 @@ ClassAdFileIterator::next()
     if (m_done) THROW_EX(StopIteration, "All ads processed");
 
     boost::shared_ptr<ClassAdWrapper> result(new ClassAdWrapper());
-    if (!m_parser->ParseClassAd(m_source, *result))
+    if (!m_parser->ParseClassAd(m_lexer_source.get(), *result))
     {
-        if (feof(m_source))
+        if (m_lexer_source->AtEnd())
         {
             m_done = true;
             THROW_EX(StopIteration, "All ads processed");
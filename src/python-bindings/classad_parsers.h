@@ -1,5 +1,6 @@
 
 #include "classad_wrapper.h"
+#include <classad/lexerSource.h>
 
 enum ParserType {
   CLASSAD_AUTO,
@@ -46,6 +47,8 @@ private:
     bool m_done;
     FILE * m_source;
     boost::shared_ptr<classad::ClassAdParser> m_parser;
+    // reads the file a chunk at a time, and is kept from one ad to the next
+    boost::shared_ptr<classad::BufferedFileLexerSource> m_lexer_source;
 };
 
 class ClassAdStringIterator